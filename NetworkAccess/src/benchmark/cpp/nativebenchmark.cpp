@@ -0,0 +1,145 @@
+/*
+ * nativebenchmark.cpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "netsocket.hpp"
+#include "netsocket_native.hpp"
+
+/*
+ * Measures the cost of the virtual Socket interface against the inlined NativeSocket view over loopback.
+ * Both use the same sockets, so the difference is the dispatch trough the library and its bookkeeping around the system call.
+ * Datagrams are exchanged in windows which fit the receive buffer, so none are dropped and no thread is needed.
+ * Arguments: [first port], the ports first port to first port + 2 on 127.0.0.1 have to be free.
+ */
+
+#define WINDOW 64
+#define MESSAGE_SIZE 16
+#define MESSAGE_COUNT (1 << 19)
+#define ROUNDS 3 // the first round warms up the caches
+
+using namespace NetSocket;
+
+/*
+ * Sends each message over the connection and receives it on the other end, with either the sockets or the views
+ */
+template<typename Stream>
+long long streamPingPong(Stream& sender, Stream& receiver) {
+	char buffer[MESSAGE_SIZE] = {0};
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < MESSAGE_COUNT; i++) {
+		if (!sender.send(buffer, MESSAGE_SIZE)) {
+			printf("send failed!\n");
+			exit(1);
+		}
+		for (unsigned int received = 0; received < MESSAGE_SIZE;) {
+			unsigned int count = 0;
+			if (!receiver.receive(buffer + received, MESSAGE_SIZE - received, &count)) {
+				printf("receive failed!\n");
+				exit(1);
+			}
+			received += count;
+		}
+	}
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+ * Sends an window of datagrams and receives them, with either the sockets or the views
+ */
+template<typename Datagrams>
+long long datagramWindows(Datagrams& sender, Datagrams& receiver, const inetaddr& target) {
+	char buffer[MESSAGE_SIZE] = {0};
+	inetaddr source;
+	auto start = std::chrono::steady_clock::now();
+	for (int sent = 0; sent < MESSAGE_COUNT; sent += WINDOW) {
+		for (int i = 0; i < WINDOW; i++) {
+			if (!sender.sendto(target, buffer, MESSAGE_SIZE)) {
+				printf("sendto failed!\n");
+				exit(1);
+			}
+		}
+		for (int i = 0; i < WINDOW; i++) {
+			unsigned int received = 0;
+			if (!receiver.receivefrom(source, buffer, MESSAGE_SIZE, &received) || received != MESSAGE_SIZE) {
+				printf("receivefrom failed!\n");
+				exit(1);
+			}
+		}
+	}
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char* name, long long virtualNanos, long long nativeNanos) {
+	printf("  %-24s virtual %8.1f ns/message   native %8.1f ns/message\n", name, virtualNanos / (double) MESSAGE_COUNT, nativeNanos / (double) MESSAGE_COUNT);
+}
+
+bool resolveLoopback(unsigned int port, bool udp, inetaddr& address) {
+	std::vector<inetaddr> addresses;
+	if (!resolveInet("127.0.0.1", std::to_string(port), udp, addresses) || addresses.empty())
+		return false;
+	address = addresses[0];
+	return true;
+}
+
+int main(int argc, char** argv) {
+	unsigned int port = argc > 1 ? atoi(argv[1]) : 25570;
+	if (!InetInit()) {
+		printf("failed to initialize network!\n");
+		return 1;
+	}
+
+	inetaddr listenAddress, addressA, addressB;
+	if (!resolveLoopback(port, false, listenAddress) || !resolveLoopback(port + 1, true, addressA) || !resolveLoopback(port + 2, true, addressB)) {
+		printf("failed to resolve loopback addresses!\n");
+		return 1;
+	}
+
+	Socket* listener = newSocket();
+	Socket* client = newSocket();
+	Socket* server = newSocket();
+	if (!listener->listen(listenAddress) || !client->connect(listenAddress, 1000) || !listener->accept(*server)) {
+		printf("failed to open TCP connection!\n");
+		return 1;
+	}
+	client->setNagle(false);
+	server->setNagle(false);
+
+	Socket* socketA = newSocket();
+	Socket* socketB = newSocket();
+	if (!socketA->bind(addressA) || !socketB->bind(addressB)) {
+		printf("failed to bind UDP sockets!\n");
+		return 1;
+	}
+
+	NativeSocket nativeClient, nativeServer, nativeA, nativeB;
+	if (!nativeClient.attach(*client) || !nativeServer.attach(*server) || !nativeA.attach(*socketA) || !nativeB.attach(*socketB)) {
+		printf("failed to attach native views!\n");
+		return 1;
+	}
+
+	for (int round = 0; round < ROUNDS; round++) {
+		printf("round %d%s\n", round, round == 0 ? " (warmup)" : "");
+		long long virtualNanos = streamPingPong(*client, *server);
+		long long nativeNanos = streamPingPong(nativeClient, nativeServer);
+		report("tcp send + receive", virtualNanos, nativeNanos);
+		virtualNanos = datagramWindows(*socketA, *socketB, addressB);
+		nativeNanos = datagramWindows(nativeA, nativeB, addressB);
+		report("udp sendto + receivefrom", virtualNanos, nativeNanos);
+	}
+
+	delete socketA;
+	delete socketB;
+	delete client;
+	delete server;
+	delete listener;
+	InetCleanup();
+	return 0;
+}
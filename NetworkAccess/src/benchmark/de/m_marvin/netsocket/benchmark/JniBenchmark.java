@@ -0,0 +1,180 @@
+/*
+ * JniBenchmark.java
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+package de.m_marvin.netsocket.benchmark;
+
+import java.io.IOException;
+import java.net.InetSocketAddress;
+import java.nio.ByteBuffer;
+import java.nio.channels.DatagramChannel;
+import java.nio.file.Path;
+
+import de.m_marvin.netsocket.DatagramBatch;
+import de.m_marvin.netsocket.INetAddress;
+import de.m_marvin.netsocket.NetSocket;
+import de.m_marvin.netsocket.Socket;
+
+/**
+ * Measures the cost of the JNI binding over loopback, with java.nio.channels.DatagramChannel as reference.
+ * Datagrams are exchanged in windows which fit the receive buffer, so none are dropped and no thread is needed:
+ * one JNI call per datagram (sendto/receivefrom), one JNI call per window (DatagramBatch) and the nio channel.
+ * STREAM throughput is measured with an receiving thread and 64 kB direct buffers.
+ * Arguments: [library file] [first port], without library file the library is loaded from the java library path.
+ * The ports first port to first port + 4 on 127.0.0.1 have to be free.
+ */
+public class JniBenchmark {
+
+	static final int WINDOW = 64;
+	static final int DATAGRAM_SIZE = 256;
+	static final int DATAGRAM_COUNT = 1 << 19;
+	static final int STREAM_CHUNK = 65536;
+	static final long STREAM_BYTES = 2L << 30;
+	static final int ROUNDS = 3;	// the first round warms up the JIT
+
+	public static void main(String[] args) throws Exception {
+		if (args.length > 0)
+			NetSocket.load(Path.of(args[0]));
+		else
+			NetSocket.load();
+		int port = args.length > 1 ? Integer.parseInt(args[1]) : 25560;
+
+		INetAddress addressA = INetAddress.parse("127.0.0.1", port);
+		INetAddress addressB = INetAddress.parse("127.0.0.1", port + 1);
+		Socket socketA = new Socket();
+		Socket socketB = new Socket();
+		if (!socketA.bind(addressA) || !socketB.bind(addressB))
+			throw new IllegalStateException("failed to bind UDP sockets");
+
+		DatagramChannel channelA = DatagramChannel.open().bind(new InetSocketAddress("127.0.0.1", port + 2));
+		DatagramChannel channelB = DatagramChannel.open().bind(new InetSocketAddress("127.0.0.1", port + 3));
+
+		INetAddress listenAddress = INetAddress.parse("127.0.0.1", port + 4);
+		Socket listener = new Socket();
+		Socket client = new Socket();
+		Socket server = new Socket();
+		if (!listener.listen(listenAddress) || !client.connect(listenAddress, 1000) || !listener.accept(server))
+			throw new IllegalStateException("failed to open TCP connection");
+
+		for (int round = 0; round < ROUNDS; round++) {
+			System.out.printf("round %d%s\n", round, round == 0 ? " (warmup)" : "");
+			reportDatagrams("udp jni single", datagramSingle(socketA, socketB, addressB));
+			reportDatagrams("udp jni batch", datagramBatch(socketA, socketB, addressB));
+			reportDatagrams("udp nio channel", datagramChannel(channelA, channelB, (InetSocketAddress) channelB.getLocalAddress()));
+			reportStream("tcp jni stream", stream(client, server));
+		}
+
+		channelA.close();
+		channelB.close();
+		socketA.free();
+		socketB.free();
+		client.free();
+		server.free();
+		listener.free();
+	}
+
+	static void reportDatagrams(String name, long nanos) {
+		System.out.printf("  %-16s %8.1f ns/datagram %10.0f datagrams/s\n", name, nanos / (double) DATAGRAM_COUNT, DATAGRAM_COUNT * 1e9 / nanos);
+	}
+
+	static void reportStream(String name, long nanos) {
+		System.out.printf("  %-16s %8.1f MB/s\n", name, STREAM_BYTES * 1e3 / nanos);
+	}
+
+	/**
+	 * Sends and receives each datagram with its own JNI call.
+	 */
+	static long datagramSingle(Socket sender, Socket receiver, INetAddress target) {
+		ByteBuffer payload = ByteBuffer.allocateDirect(DATAGRAM_SIZE);
+		ByteBuffer buffer = ByteBuffer.allocateDirect(DATAGRAM_SIZE);
+		INetAddress source = new INetAddress();
+		long start = System.nanoTime();
+		for (int sent = 0; sent < DATAGRAM_COUNT; sent += WINDOW) {
+			for (int i = 0; i < WINDOW; i++) {
+				payload.clear();
+				if (!sender.sendto(target, payload))
+					throw new IllegalStateException("sendto failed");
+			}
+			for (int i = 0; i < WINDOW; i++) {
+				buffer.clear();
+				if (receiver.receivefrom(source, buffer) != DATAGRAM_SIZE)
+					throw new IllegalStateException("receivefrom failed");
+			}
+		}
+		return System.nanoTime() - start;
+	}
+
+	/**
+	 * Sends each window with one JNI call, and receives it with as few calls as the datagrams arrive in.
+	 */
+	static long datagramBatch(Socket sender, Socket receiver, INetAddress target) {
+		DatagramBatch outgoing = new DatagramBatch(WINDOW, DATAGRAM_SIZE);
+		DatagramBatch incoming = new DatagramBatch(WINDOW, DATAGRAM_SIZE);
+		for (int i = 0; i < WINDOW; i++)
+			outgoing.set(i, target, DATAGRAM_SIZE);
+		outgoing.setCount(WINDOW);
+		long start = System.nanoTime();
+		for (int sent = 0; sent < DATAGRAM_COUNT; sent += WINDOW) {
+			if (sender.sendtoBatch(outgoing) != WINDOW)
+				throw new IllegalStateException("sendtoBatch failed");
+			for (int received = 0; received < WINDOW;) {
+				int count = receiver.receivefromBatch(incoming);
+				if (count <= 0)
+					throw new IllegalStateException("receivefromBatch failed");
+				received += count;
+			}
+		}
+		return System.nanoTime() - start;
+	}
+
+	/**
+	 * Same pattern as datagramSingle() with java.nio, for comparison.
+	 */
+	static long datagramChannel(DatagramChannel sender, DatagramChannel receiver, InetSocketAddress target) throws IOException {
+		ByteBuffer payload = ByteBuffer.allocateDirect(DATAGRAM_SIZE);
+		ByteBuffer buffer = ByteBuffer.allocateDirect(DATAGRAM_SIZE);
+		long start = System.nanoTime();
+		for (int sent = 0; sent < DATAGRAM_COUNT; sent += WINDOW) {
+			for (int i = 0; i < WINDOW; i++) {
+				payload.clear();
+				sender.send(payload, target);
+			}
+			for (int i = 0; i < WINDOW; i++) {
+				buffer.clear();
+				receiver.receive(buffer);
+			}
+		}
+		return System.nanoTime() - start;
+	}
+
+	/**
+	 * Sends STREAM_BYTES trough the connection while another thread receives them.
+	 */
+	static long stream(Socket sender, Socket receiver) throws InterruptedException {
+		Thread reader = new Thread(() -> {
+			ByteBuffer buffer = ByteBuffer.allocateDirect(STREAM_CHUNK);
+			long remaining = STREAM_BYTES;
+			while (remaining > 0) {
+				buffer.clear();
+				int received = receiver.receive(buffer);
+				if (received < 0)
+					throw new IllegalStateException("receive failed");
+				remaining -= received;
+			}
+		});
+		ByteBuffer chunk = ByteBuffer.allocateDirect(STREAM_CHUNK);
+		long start = System.nanoTime();
+		reader.start();
+		for (long sent = 0; sent < STREAM_BYTES; sent += STREAM_CHUNK) {
+			chunk.clear();
+			if (!sender.send(chunk))
+				throw new IllegalStateException("send failed");
+		}
+		reader.join();
+		return System.nanoTime() - start;
+	}
+
+}
@@ -12,9 +12,11 @@
 #include <vector>
 #include <memory>
 
-/** FIXME
- * Sockets seem to terminate randomly by some certain errors, leaving the
- * stype field in an invalid state
+/**
+ * Threading: on the platform sockets (newSocket()) one thread may send while another receives, and any thread may call close().
+ * Each call holds an reference on the handle while it uses it, close() only marks the socket as closing and wakes up blocked calls,
+ * which then return false. The handle is released when the last call returned, so an closed handle is never reused by an running call.
+ * Opening an socket (listen(), bind(), connect(), accept()) must not run concurrently with other calls on the same socket.
  */
 
 namespace NetSocket {
@@ -22,6 +24,11 @@ namespace NetSocket {
 bool InetInit();
 void InetCleanup();
 
+/*
+ * Buffer size required by INetAddress::format() for any IPv4 or IPv6 address, including the null termination
+ */
+#define INET_ADDRESS_LENGTH 46
+
 class INetAddress {
 
 public:
@@ -31,7 +38,51 @@ public:
 	INetAddress(const INetAddress& other);
 	~INetAddress();
 	bool fromstr(std::string& addressStr, unsigned int port);
+	/**
+	 * Parses an IPv4 or IPv6 address without allocating memory and without printing anything on invalid input.
+	 * The accepted syntax is the same as for fromstr(), which uses this function internally.
+	 * @param addressStr The address text, does not have to be null terminated
+	 * @param length The length of the text
+	 * @param port The port number
+	 * @return true if the text was an valid address, false otherwise
+	 */
+	bool parse(const char* addressStr, unsigned int length, unsigned int port);
+	/**
+	 * Initializes this address as unix domain socket address (linux only).
+	 * Sockets created with such an address use AF_UNIX instead of TCP/UDP, but are used trough the same functions.
+	 * A path starting with '@' is placed in the abstract namespace and does not create an file.
+	 * tostr() returns the path (with leading '@' for abstract addresses) and port zero for such addresses.
+	 * @param path The file system path or abstract name
+	 * @return true if the address was valid, false otherwise
+	 */
+	bool fromunix(const std::string& path);
 	bool tostr(std::string& addressStr, unsigned int* port) const;
+	/**
+	 * Initializes this address from the raw IPv4 or IPv6 address bytes.
+	 * @param bytes The address in network byte order
+	 * @param length The number of bytes, 4 for IPv4 and 16 for IPv6
+	 * @param port The port number
+	 * @return true if the address was valid, false otherwise
+	 */
+	bool frombytes(const unsigned char* bytes, unsigned int length, unsigned int port);
+	/**
+	 * Reads the raw address bytes of an IPv4 or IPv6 address.
+	 * @param bytes The buffer to write the address in network byte order to, 16 bytes are enough for all addresses
+	 * @param length Where to store the number of bytes, 4 for IPv4 and 16 for IPv6
+	 * @param port Where to store the port number
+	 * @return true if the address was read, false if this is no IPv4 or IPv6 address
+	 */
+	bool tobytes(unsigned char* bytes, unsigned int* length, unsigned int* port) const;
+	/**
+	 * Writes the address as null terminated text into the supplied buffer without allocating memory.
+	 * The text is the same as returned by tostr(), which uses this function internally.
+	 * @param buffer The buffer to write the text to, INET_ADDRESS_LENGTH bytes are enough for all IPv4 and IPv6 addresses
+	 * @param capacity The size of the buffer
+	 * @param length Where to store the length of the text without the null termination
+	 * @param port Where to store the port number
+	 * @return true if the text was written, false if the address is not initialized or the buffer is too small
+	 */
+	bool format(char* buffer, unsigned int capacity, unsigned int* length, unsigned int* port) const;
 	int compare(const INetAddress& other) const;
 
 	INetAddress& operator=(const INetAddress& other);
@@ -43,6 +94,8 @@ public:
 
 typedef INetAddress inetaddr;
 
+class AddressFilter;
+
 /**
  * Resolves the supplied host string into a list of network addresses.
  * @param hostStr The host URL string
@@ -60,6 +113,146 @@ enum SocketType {
 	STREAM = 3
 };
 
+enum SocketOption {
+	OPT_RECEIVE_BUFFER = 0,	// SO_RCVBUF, size in bytes (reads back the doubled value reserved by the kernel on linux)
+	OPT_SEND_BUFFER = 1,	// SO_SNDBUF, size in bytes
+	OPT_BUSY_POLL = 2,		// SO_BUSY_POLL, time to busy poll the device queue on receive in us
+	OPT_QUICK_ACK = 3,		// TCP_QUICKACK, 1 to send ACKs immediately instead of delaying them
+	OPT_CORK = 4,			// TCP_CORK, 1 to only send full segments until cleared again
+	OPT_NOTSENT_LOWAT = 5,	// TCP_NOTSENT_LOWAT, limit of unsent bytes queued in the kernel in bytes
+	OPT_FAST_OPEN = 6,		// TCP_FASTOPEN, length of the fast open queue of an listen socket
+	OPT_PRIORITY = 7,		// SO_PRIORITY, queueing priority of outgoing packets (0-6 without privileges)
+	OPT_NO_DELAY = 8,		// TCP_NODELAY, 1 to disable the nagle buffering algorithm
+	OPT_DEFER_ACCEPT = 9,	// TCP_DEFER_ACCEPT, time in s an listen socket waits for the first data before accept() returns the connection
+	OPT_REUSE_ADDRESS = 10,	// SO_REUSEADDR, 1 to allow multiple sockets to bind the same address, required to share an multicast port
+	OPT_MULTICAST_TTL = 11,	// IP_MULTICAST_TTL/IPV6_MULTICAST_HOPS, number of hops outgoing multicast packets may travel
+	OPT_MULTICAST_LOOP = 12,// IP_MULTICAST_LOOP/IPV6_MULTICAST_LOOP, 1 to deliver outgoing multicast packets to local receivers
+	OPT_MULTICAST_INTERFACE = 13,// IP_MULTICAST_IF/IPV6_MULTICAST_IF, index of the interface to send multicast packets trough (can not be read back for IPv4)
+	OPT_MAX_PACING_RATE = 14,// SO_MAX_PACING_RATE, maximum send rate in bytes per second, enforced by the fq qdisc or TCP internal pacing (linux only)
+	OPT_COUNT = 15
+};
+
+/**
+ * A set of socket options which is applied as a whole when the socket is opened.
+ * Options with an value of -1 are left at their system default.
+ */
+struct SocketProfile {
+	int values[OPT_COUNT];
+
+	SocketProfile() {
+		for (int i = 0; i < OPT_COUNT; i++) values[i] = -1;
+	}
+
+	SocketProfile& set(SocketOption option, int value) {
+		values[option] = value;
+		return *this;
+	}
+
+	/**
+	 * Small kernel send queues and no delayed or buffered sends, for request/response traffic.
+	 * Busy polling (OPT_BUSY_POLL) is not part of the profile, since raising it requires CAP_NET_ADMIN.
+	 */
+	static SocketProfile lowLatency();
+
+	/**
+	 * Large kernel buffers and nagle buffering enabled, for transfers of large amounts of data.
+	 */
+	static SocketProfile bulkThroughput();
+};
+
+/**
+ * Kernel timestamps of an received or transmitted message, zero if not available.
+ */
+struct Timestamp {
+	/** Time the kernel received or transmitted the packet in ns since the epoch (CLOCK_REALTIME) */
+	unsigned long long software;
+	/** Time the network card received or transmitted the packet in ns of the hardware clock, only set if the driver supports it */
+	unsigned long long hardware;
+};
+
+/**
+ * An single datagram of an batch transfer.
+ */
+struct Datagram {
+	/** The sender (receive) or target (send) address */
+	inetaddr address;
+	/** The payload buffer */
+	char* buffer;
+	/** The capacity (receive) or length (send) of the buffer */
+	unsigned int length;
+	/** The number of bytes received */
+	unsigned int received;
+};
+
+/**
+ * An single buffer of an gathered send.
+ */
+struct SendBuffer {
+	/** The data to send */
+	const char* buffer;
+	/** The length of the data */
+	unsigned int length;
+};
+
+/**
+ * Telemetry of an TCP connection, read by Socket::getStats() and Socket::sampleStats().
+ * Fields the system does not report are zero, older linux kernels only report the fields up to totalRetransmits.
+ */
+struct ConnectionStats {
+	/** If the statistics were read, false for sockets skipped by sampleStats() */
+	bool valid;
+	/** Smoothed round trip time in us */
+	unsigned int rtt;
+	/** Variance of the round trip time in us */
+	unsigned int rttVariance;
+	/** Lowest round trip time seen on the connection in us */
+	unsigned int minRtt;
+	/** Maximum segment size in bytes */
+	unsigned int mss;
+	/** Congestion window in bytes */
+	unsigned int congestionWindow;
+	/** Slow start threshold in bytes, zero while still in the initial slow start */
+	unsigned int slowStartThreshold;
+	/** Receive window advertised by the peer in bytes */
+	unsigned int peerWindow;
+	/** Bytes sent but not yet acknowledged (segments times mss on linux) */
+	unsigned int unacked;
+	/** Bytes queued in the kernel which were not yet sent */
+	unsigned int notSent;
+	/** Number of retransmissions of the current segment, non zero while the connection is stalled */
+	unsigned int retransmits;
+	/** Number of segments retransmitted over the lifetime of the connection */
+	unsigned int totalRetransmits;
+	/** Number of segments currently considered lost */
+	unsigned int lost;
+	/** Bytes sent, including retransmissions */
+	unsigned long long bytesSent;
+	/** Bytes acknowledged by the peer */
+	unsigned long long bytesAcked;
+	/** Bytes received from the peer */
+	unsigned long long bytesReceived;
+	/** Bytes retransmitted */
+	unsigned long long bytesRetransmitted;
+	/** Most recent delivery rate estimate in bytes per second */
+	unsigned long long deliveryRate;
+	/** Current pacing rate in bytes per second */
+	unsigned long long pacingRate;
+	/** Time in us the connection was limited by the receive window of the peer */
+	unsigned long long receiveWindowLimited;
+	/** Time in us the connection was limited by the local send buffer */
+	unsigned long long sendBufferLimited;
+};
+
+/**
+ * Readiness events used by Socket::pollMany().
+ */
+enum SocketEvent {
+	EVENT_READ = 1,		// data can be received, or an connection can be accepted on LISTEN_TCP sockets
+	EVENT_WRITE = 2,	// data can be sent without blocking
+	EVENT_ERROR = 4,	// an error is pending on the socket, always reported
+	EVENT_CLOSED = 8	// the peer closed the connection, always reported
+};
+
 class Socket { // TODO overlapped/asynchronous mode for read/write
 
 public:
@@ -86,6 +279,34 @@ public:
 	 */
 	virtual bool getNagle(bool* enableBuffering) = 0;
 
+	/**
+	 * Sets an option on this socket.
+	 * TCP specific options are only supported on TCP sockets, not all options are supported on all platforms.
+	 * @param option The option to set
+	 * @param value The new value of the option
+	 * @return true if the option was set successfully, false otherwise
+	 */
+	virtual bool setOption(SocketOption option, int value) = 0;
+
+	/**
+	 * Reads the current value of an option of this socket.
+	 * @param option The option to read
+	 * @param value Where to store the value
+	 * @return true if the option was read successfully, false otherwise
+	 */
+	virtual bool getOption(SocketOption option, int* value) = 0;
+
+	/**
+	 * Configures the profile of options which is applied by listen(), bind(), connect() and accept(), before the socket becomes usable.
+	 * If any of the options can not be applied, the socket is closed again and the call fails, so it never runs with an partial profile.
+	 * Sockets initialized by accept() use the profile of the listen socket, if they have no own profile.
+	 * Options which are not available on the platform or for the socket type are skipped.
+	 * If this socket is already open, the profile is applied immediately.
+	 * @param profile The options to apply
+	 * @return true if the profile was stored (and applied if the socket is open), false otherwise
+	 */
+	virtual bool setProfile(const SocketProfile& profile) = 0;
+
 	/**
 	 * Creates a new TCP port that can accept incoming connections usign the accept() function
 	 * @param localAddress The local address to bind the socket to
@@ -96,11 +317,23 @@ public:
 	/**
 	 * Attempts to accept an incoming connection and initializes the supplied (unbound) socket for it as TCP stream socket.
 	 * This function blocks until an connection is received.
+	 * The peer address is stored with the socket, so getINet() on the new socket does not need an system call.
 	 * @param clientSocket The unbound socket to use for the incoming connection
 	 * @return true if an connection was accepted and the socket was initialized successfully, false otherwise
 	 */
 	virtual bool accept(Socket &clientSocket) = 0;
 
+	/**
+	 * Sets an address filter which is applied to peers before they reach the application (see netsocket_filter.hpp).
+	 * On LISTEN_TCP sockets accept() closes connections from denied peers immediately and waits for the next connection,
+	 * on LISTEN_UDP sockets the receivefrom functions drop datagrams from denied senders and continue receiving.
+	 * In non blocking mode the functions return as if nothing was received if only denied peers were pending.
+	 * The filter is not copied, it has to stay valid while it is set and must not be modified while the socket is in use.
+	 * @param filter The filter to apply, or null to allow all peers
+	 * @return true if the filter was set, false otherwise
+	 */
+	virtual bool setFilter(const AddressFilter* filter) = 0;
+
 	/**
 	 * Configures the read and write timeouts for this network socket.
 	 * @param readTimeout The timeout for reading from the socket in ms
@@ -127,6 +360,20 @@ public:
 	 */
 	virtual bool connect(const inetaddr& remoteAddress, unsigned long timeout) = 0;
 
+	/**
+	 * Attempts to establish a connection like connect() and sends the first data along with the connection request (TCP Fast Open).
+	 * The data is only carried by the SYN packet if the client holds an fast open cookie of the server, otherwise it is sent after the handshake.
+	 * The listen socket has to enable fast open using the OPT_FAST_OPEN option for the data to be accepted early.
+	 * A timeout of zero means to block indefinitely.
+	 * @param remoteAddress The address to connect to
+	 * @param timeout The timeout used for connecting, may be limited by the operating system
+	 * @param buffer The buffer holding the data
+	 * @param length The length of the data
+	 * @param fastOpenUsed Where to store if the data was actually accepted by the server as part of the SYN packet
+	 * @return true if an connection was successfully established and the data was sent, false otherwise
+	 */
+	virtual bool connectFastOpen(const inetaddr& remoteAddress, unsigned long timeout, const char* buffer, unsigned int length, bool* fastOpenUsed) = 0;
+
 	/**
 	 * Sends data trough the TCP connection.
 	 * @param buffer The buffer holding the data
@@ -146,6 +393,77 @@ public:
 	 */
 	virtual bool receive(char* buffer, unsigned int length, unsigned int* received) = 0;
 
+	/**
+	 * Puts the socket in blocking (default) or non blocking mode, may be called before the socket is opened.
+	 * In non blocking mode the receive functions return immediately with zero bytes if no data is available,
+	 * and accept() returns false without an error message if no connection is queued.
+	 * send() and sendto() still transmit the whole buffer, use trySend() to never block.
+	 * connect() always waits for the connection up to its timeout.
+	 * @param blocking If the socket should block
+	 * @return true if the mode was changed, false otherwise
+	 */
+	virtual bool setBlocking(bool blocking) = 0;
+
+	/**
+	 * Returns the mode set with setBlocking().
+	 * @param blocking Where to store if the socket is in blocking mode
+	 * @return true if the mode was read, false otherwise
+	 */
+	virtual bool getBlocking(bool* blocking) = 0;
+
+	/**
+	 * Sends as much data trough the TCP connection as possible without blocking, independent of the blocking mode.
+	 * @param buffer The buffer holding the data
+	 * @param length The length of the data
+	 * @param sent The number of bytes actually sent
+	 * @param wouldBlock Where to store if not all data could be sent because the send buffer is full, which is not an error
+	 * @return true if the function did return normally (no error occurred), false otherwise
+	 */
+	virtual bool trySend(const char* buffer, unsigned int length, unsigned int* sent, bool* wouldBlock) = 0;
+
+	/**
+	 * Same as trySend() but sends multiple buffers in order, as one continuous stream, with one system call where supported.
+	 * @param buffers The buffers to send, at most 64 are sent per call
+	 * @param count The number of buffers
+	 * @param sent The total number of bytes actually sent, the sent bytes of the last buffer might be incomplete
+	 * @param wouldBlock Where to store if not all data could be sent because the send buffer is full, which is not an error
+	 * @return true if the function did return normally (no error occurred), false otherwise
+	 */
+	virtual bool trySendGather(const SendBuffer* buffers, unsigned int count, unsigned int* sent, bool* wouldBlock) = 0;
+
+	/**
+	 * Receives data trough the TCP connection without blocking, independent of the blocking mode.
+	 * @param buffer The buffer to write the payload to
+	 * @param length The capacity of the buffer
+	 * @param received The actual number of bytes received
+	 * @param wouldBlock Where to store if no data was available, which is not an error
+	 * @return true if the function did return normally (no error occurred), false otherwise
+	 */
+	virtual bool tryReceive(char* buffer, unsigned int length, unsigned int* received, bool* wouldBlock) = 0;
+
+	/**
+	 * Waits until at least one of the sockets is ready for one of the requested events.
+	 * Shared memory sockets are not backed by an system handle and are not supported.
+	 * @param sockets The sockets to wait for
+	 * @param events The events to wait for per socket, an combination of EVENT_READ and EVENT_WRITE
+	 * @param readyEvents Where to store the events which are ready per socket, zero for sockets which are not ready
+	 * @param count The number of sockets
+	 * @param timeout The time to wait in ms, zero to return immediately, -1 to wait indefinitely
+	 * @param readyCount Where to store the number of ready sockets, zero if the timeout expired
+	 * @return true if the function did return normally (no error occurred), false otherwise
+	 */
+	static bool pollMany(Socket** sockets, const int* events, int* readyEvents, unsigned int count, int timeout, unsigned int* readyCount);
+
+	/**
+	 * Reads the telemetry of many TCP STREAM sockets, with one system call per socket and without allocations.
+	 * Sockets which are closed, not TCP or not backed by an handle are skipped silently, their stats are marked as not valid.
+	 * @param sockets The sockets to sample
+	 * @param stats Where to store the statistics per socket
+	 * @param count The number of sockets
+	 * @param sampledCount Where to store the number of sockets with valid statistics
+	 */
+	static void sampleStats(Socket** sockets, ConnectionStats* stats, unsigned int count, unsigned int* sampledCount);
+
 	/**
 	 * Creates and new socket configured for UDP transmissions
 	 * @return true if the port was successfully bound, false otherwise
@@ -174,7 +492,147 @@ public:
 	virtual bool sendto(const inetaddr& remoteAddress, const char* buffer, unsigned int length) = 0;
 
 	/**
-	 * Closes the port.
+	 * Receives multiple datagrams trough UDP transmissions with one system call where supported.
+	 * This function blocks until at least one datagram is received, and then returns all datagrams which are already queued, up to count.
+	 * @param datagrams The datagrams to fill, address and received are written, buffer and length have to be set by the caller
+	 * If an address filter is set, datagrams from denied senders are removed by swapping array entries, including their buffers.
+	 * @param count The number of datagrams in the array, at most 64 are received per call
+	 * @param receivedCount The number of datagrams actually received
+	 * @return true if the function did return normally (no error occurred), false otherwise
+	 */
+	virtual bool receivefromBatch(Datagram* datagrams, unsigned int count, unsigned int* receivedCount) = 0;
+
+	/**
+	 * Sends multiple datagrams trough UDP transmissions with one system call where supported.
+	 * @param datagrams The datagrams to send, address, buffer and length have to be set by the caller
+	 * @param count The number of datagrams in the array, at most 64 are sent per call
+	 * @param sentCount The number of datagrams actually sent, the remaining ones have to be sent again
+	 * @return true if the function did return normally (no error occurred), false otherwise
+	 */
+	virtual bool sendtoBatch(const Datagram* datagrams, unsigned int count, unsigned int* sentCount) = 0;
+
+	/**
+	 * Joins an multicast group on this UDP socket, received group traffic is returned by receivefrom().
+	 * The socket has to be bound to the group port (and usually the any address) of the same address family.
+	 * @param groupAddress The multicast group address, the port is ignored
+	 * @param sourceAddress The only source to receive packets from (source specific multicast), null to receive from any source
+	 * @param interfaceIndex The index of the interface to join the group on, zero to let the system choose
+	 * @return true if the group was joined, false otherwise
+	 */
+	virtual bool joinGroup(const inetaddr& groupAddress, const inetaddr* sourceAddress, unsigned int interfaceIndex) = 0;
+
+	/**
+	 * Leaves an multicast group previously joined with joinGroup().
+	 * @param groupAddress The multicast group address
+	 * @param sourceAddress The source address passed to joinGroup(), or null
+	 * @param interfaceIndex The interface index passed to joinGroup()
+	 * @return true if the group was left, false otherwise
+	 */
+	virtual bool leaveGroup(const inetaddr& groupAddress, const inetaddr* sourceAddress, unsigned int interfaceIndex) = 0;
+
+	/**
+	 * Passes an open socket to the peer of this unix domain STREAM socket (linux only).
+	 * The passed socket stays open in this process, both processes share the same underlying socket afterwards.
+	 * At least one byte of payload is transmitted with the handle, if length is zero a single zero byte is sent.
+	 * @param socket The open socket to pass
+	 * @param buffer The buffer holding the payload to send along with the handle
+	 * @param length The length of the payload
+	 * @return true if the handle was sent successfully, false otherwise
+	 */
+	virtual bool sendSocket(Socket& socket, const char* buffer, unsigned int length) = 0;
+
+	/**
+	 * Receives an socket passed by the peer of this unix domain STREAM socket using sendSocket() (linux only).
+	 * The supplied (unbound) socket is initialized with the received handle, its type is derived from the handle.
+	 * This function might block indefinitely until data is received.
+	 * @param socket The unbound socket to initialize with the received handle
+	 * @param buffer The buffer to write the payload to
+	 * @param length The capacity of the buffer
+	 * @param received The actual number of payload bytes received
+	 * @return true if an handle was received and the socket was initialized successfully, false otherwise
+	 */
+	virtual bool receiveSocket(Socket& socket, char* buffer, unsigned int length, unsigned int* received) = 0;
+
+	/**
+	 * Reads the credentials of the process on the other side of this unix domain socket (linux only).
+	 * The credentials are the ones of the peer at the time it called connect() or listen().
+	 * @param pid Where to store the process id
+	 * @param uid Where to store the user id
+	 * @param gid Where to store the group id
+	 * @return true if the credentials were read successfully, false otherwise
+	 */
+	virtual bool getPeerCredentials(int* pid, int* uid, int* gid) = 0;
+
+	/**
+	 * Selects the TCP congestion control algorithm of this STREAM or LISTEN_TCP socket (linux only).
+	 * Connections accepted by an listen socket inherit its algorithm.
+	 * Algorithms other than the ones listed in /proc/sys/net/ipv4/tcp_allowed_congestion_control require CAP_NET_ADMIN.
+	 * @param algorithm The name of the algorithm, for example "bbr" or "cubic", the kernel module has to be available
+	 * @return true if the algorithm was selected, false otherwise
+	 */
+	virtual bool setCongestionControl(const char* algorithm) = 0;
+
+	/**
+	 * Reads the TCP congestion control algorithm of this STREAM or LISTEN_TCP socket (linux only).
+	 * @param algorithm Where to store the name of the algorithm
+	 * @return true if the algorithm was read, false otherwise
+	 */
+	virtual bool getCongestionControl(std::string& algorithm) = 0;
+
+	/**
+	 * Reads the telemetry of this TCP STREAM socket from the kernel (TCP_INFO on linux, SIO_TCP_INFO on windows).
+	 * Combined with the previous sample this tells if an slow connection is limited by latency, losses, the congestion window or the peer.
+	 * @param stats Where to store the statistics
+	 * @return true if the statistics were read, false otherwise
+	 */
+	virtual bool getStats(ConnectionStats* stats) = 0;
+
+	/**
+	 * Enables kernel timestamping of received and/or transmitted packets (linux only).
+	 * Receive timestamps are returned by receiveTimestamped() and receivefromTimestamped(),
+	 * transmit timestamps are queued by the kernel and read with receiveTransmitTimestamp().
+	 * @param receive If receive timestamps should be recorded
+	 * @param transmit If transmit timestamps should be recorded
+	 * @return true if timestamping was configured, false otherwise
+	 */
+	virtual bool enableTimestamps(bool receive, bool transmit) = 0;
+
+	/**
+	 * Same as receive() but also returns the time the data arrived in the kernel.
+	 * For STREAM sockets the timestamp is the one of the last packet the returned data was part of.
+	 * @param buffer The buffer to write the data to
+	 * @param length The capacity of the buffer
+	 * @param received The actual number of bytes received
+	 * @param timestamp Where to store the receive timestamp, zero if timestamps are not enabled
+	 * @return true if the function did return normally (no error occurred), false otherwise
+	 */
+	virtual bool receiveTimestamped(char* buffer, unsigned int length, unsigned int* received, Timestamp* timestamp) = 0;
+
+	/**
+	 * Same as receivefrom() but also returns the time the datagram arrived in the kernel.
+	 * @param remoteAddress The sender address of the received package
+	 * @param buffer The buffer to write the data to
+	 * @param length The capacity of the buffer
+	 * @param received The actual number of bytes received
+	 * @param timestamp Where to store the receive timestamp, zero if timestamps are not enabled
+	 * @return true if the function did return normally (no error occurred), false otherwise
+	 */
+	virtual bool receivefromTimestamped(inetaddr& remoteAddress, char* buffer, unsigned int length, unsigned int* received, Timestamp* timestamp) = 0;
+
+	/**
+	 * Reads the next transmit timestamp queued by the kernel, does not block.
+	 * The id counts the datagrams sent on UDP sockets, on STREAM sockets it is the byte offset of the last byte of the send() call.
+	 * @param id Where to store the id of the transmitted message
+	 * @param timestamp Where to store the transmit timestamp
+	 * @param available Where to store if an timestamp was available
+	 * @return true if the function did return normally (no error occurred), false otherwise
+	 */
+	virtual bool receiveTransmitTimestamp(unsigned int* id, Timestamp* timestamp, bool* available) = 0;
+
+	/**
+	 * Closes the port, can be called from any thread.
+	 * Calls blocked on the socket in other threads return false, the handle itself is released once the last of them returned.
+	 * isOpen() returns false immediately, type() keeps the old type until the handle is released, the socket can not be opened again before.
 	 */
 	virtual void close() = 0;
 
@@ -191,6 +649,27 @@ public:
 
 NetSocket::Socket* newSocket();
 
+/**
+ * Hands an LISTEN_TCP socket over to the process on the other side of the supplied unix domain socket (linux only).
+ * Blocks until the other process confirmed to have taken over the socket using takeoverListener(), and then closes the local socket.
+ * Pending connections stay in the backlog of the socket and are accepted by the new process, none are dropped.
+ * No other thread should call accept() on the listen socket while the handover is in progress.
+ * @param channel The connected unix domain STREAM socket to the new process
+ * @param listenSocket The listen socket to hand over
+ * @param timeout The time to wait for the confirmation in ms, zero means to block indefinitely
+ * @return true if the new process took over the socket, false otherwise (the socket stays open in this case)
+ */
+bool handoverListener(Socket& channel, Socket& listenSocket, unsigned long timeout);
+
+/**
+ * Takes over an LISTEN_TCP socket from the process on the other side of the supplied unix domain socket (linux only).
+ * The counterpart to handoverListener().
+ * @param channel The connected unix domain STREAM socket to the old process
+ * @param listenSocket The unbound socket to initialize with the received listen socket
+ * @return true if the socket was received and confirmed, false otherwise
+ */
+bool takeoverListener(Socket& channel, Socket& listenSocket);
+
 }
 
 #endif /* NETWORK_HPP_ */
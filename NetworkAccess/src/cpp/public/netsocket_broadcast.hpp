@@ -0,0 +1,167 @@
+/*
+ * netsocket_broadcast.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETSOCKET_BROADCAST_HPP_
+#define NETSOCKET_BROADCAST_HPP_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include "netsocket.hpp"
+
+namespace NetSocket {
+
+/**
+ * An immutable payload shared by the queues of all subscribers it is sent to.
+ */
+typedef std::shared_ptr<const std::string> SharedMessage;
+
+/**
+ * Creates an shared message holding an copy of the data.
+ * @param buffer The buffer holding the data
+ * @param length The length of the data
+ * @return The new message
+ */
+SharedMessage makeMessage(const char* buffer, unsigned int length);
+
+/**
+ * What happens if an message would exceed the queue limit of an subscriber.
+ */
+enum LagPolicy {
+	LAG_DROP_OLDEST = 0,	// queued messages which were not started yet are dropped, oldest first, until the new one fits
+	LAG_DROP_NEWEST = 1,	// the new message is dropped for this subscriber
+	LAG_DISCONNECT = 2		// the subscriber is closed and removed
+};
+
+/**
+ * Called after an subscriber was removed because it lagged behind (LAG_DISCONNECT) or sending to it failed, the socket is already closed.
+ */
+typedef std::function<void(Socket& socket)> DisconnectHandler;
+
+/**
+ * Fan out of messages to many STREAM sockets without blocking on slow subscribers.
+ * publish() only appends an reference to the shared message to the queue of each subscriber, the payload is never copied.
+ * flush() writes the queued messages of each subscriber with one gathered, non blocking send (Socket::trySendGather()),
+ * data which does not fit into the send buffer stays queued. Subscribers which still have queued data after an flush
+ * are returned by backlogged(), an event loop waits for EVENT_WRITE on them with Socket::pollMany() and calls flush(socket).
+ * Messages are written back to back, framing is up to the caller.
+ * An socket must only be subscribed to one broadcaster at an time, since the queues would interleave otherwise.
+ * This class is not thread safe.
+ */
+class Broadcaster {
+
+public:
+	/**
+	 * Creates a new broadcaster without subscribers.
+	 * @param queueLimit The maximum number of bytes queued per subscriber
+	 * @param policy What to do if an message would exceed the limit
+	 */
+	Broadcaster(unsigned int queueLimit = 4 << 20, LagPolicy policy = LAG_DISCONNECT);
+
+	Broadcaster(const Broadcaster&) = delete;
+	Broadcaster& operator=(const Broadcaster&) = delete;
+
+	/**
+	 * Sets the function which is called when an subscriber was removed by the broadcaster.
+	 * @param handler The function to call
+	 */
+	void setDisconnectHandler(DisconnectHandler handler);
+
+	/**
+	 * Adds an subscriber, it receives all messages published afterwards.
+	 * @param socket The connected STREAM socket, has to stay valid until it is unsubscribed or the disconnect handler was called
+	 * @return true if the socket was added, false if it is not connected or already subscribed
+	 */
+	bool subscribe(Socket& socket);
+
+	/**
+	 * Removes an subscriber and drops its queued messages, an partially sent message stays incomplete.
+	 * @param socket The subscribed socket
+	 */
+	void unsubscribe(Socket& socket);
+
+	/**
+	 * Returns the number of subscribers.
+	 * @return The number of subscribers
+	 */
+	unsigned int subscribers() const;
+
+	/**
+	 * Queues an message for all subscribers, nothing is sent until flush() is called.
+	 * @param message The message to send
+	 */
+	void publish(const SharedMessage& message);
+
+	/**
+	 * Queues an message for an single subscriber, in order with the published messages.
+	 * @param socket The subscribed socket
+	 * @param message The message to send
+	 * @return true if the message was queued, false if the socket is not subscribed, the message was dropped or the subscriber was removed
+	 */
+	bool send(Socket& socket, const SharedMessage& message);
+
+	/**
+	 * Sends the queued messages of all subscribers, as much as their send buffers accept.
+	 * @return The number of subscribers which still have queued data
+	 */
+	unsigned int flush();
+
+	/**
+	 * Sends the queued messages of one subscriber, as much as its send buffer accepts.
+	 * @param socket The subscribed socket, usually reported writable by Socket::pollMany()
+	 * @return true if all queued data was sent, false if data is still queued or the subscriber was removed
+	 */
+	bool flush(Socket& socket);
+
+	/**
+	 * Returns the subscribers which still have queued data after the last flush, to wait for EVENT_WRITE on them.
+	 * @param sockets Where to store the sockets
+	 * @param capacity The capacity of the array
+	 * @return The number of sockets stored
+	 */
+	unsigned int backlogged(Socket** sockets, unsigned int capacity) const;
+
+	/**
+	 * Returns the number of bytes queued for an subscriber.
+	 * @param socket The subscribed socket
+	 * @return The number of bytes queued, zero if the socket is not subscribed
+	 */
+	unsigned long long queued(Socket& socket) const;
+
+	/**
+	 * Returns the number of messages dropped for lagging subscribers, including the queues of subscribers removed by the broadcaster.
+	 * @return The number of dropped messages since the broadcaster was created
+	 */
+	unsigned long long dropped() const;
+
+private:
+	struct Subscriber {
+		std::deque<SharedMessage> queue;
+		unsigned int offset;	// bytes of the first message already sent
+		unsigned long long queuedBytes;
+		bool backlogged;
+	};
+
+	unsigned int queueLimit;
+	LagPolicy policy;
+	DisconnectHandler handler;
+	std::unordered_map<Socket*, Subscriber> subscriberMap;
+	std::vector<Socket*> pending;
+	unsigned long long droppedCount;
+
+	bool enqueue(Socket* socket, Subscriber& subscriber, const SharedMessage& message);
+	bool write(Socket* socket, Subscriber& subscriber);
+	void disconnect(Socket* socket);
+
+};
+
+}
+
+#endif /* NETSOCKET_BROADCAST_HPP_ */
@@ -0,0 +1,188 @@
+/*
+ * netsocket_buffered.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETSOCKET_BUFFERED_HPP_
+#define NETSOCKET_BUFFERED_HPP_
+
+#include <vector>
+#include <functional>
+#include "netsocket.hpp"
+
+namespace NetSocket {
+
+/**
+ * User space write buffer on top of an STREAM socket, collects small writes and sends them with few system calls.
+ * The buffer is flushed when it reaches the flush threshold, when flush() is called or when tryFlush() is called,
+ * which event loops should do at the end of each iteration.
+ * If the socket is in blocking mode the threshold flush blocks until the data is sent, in non blocking mode only
+ * the data the kernel accepts is sent and the rest stays buffered.
+ * Buffered data above the high watermark marks the writer as not writable until it drained below the low watermark,
+ * producers should check isWritable() (or register an backpressure handler) and pause instead of writing further.
+ * This class is not thread safe.
+ */
+class BufferedWriter {
+
+public:
+	/**
+	 * Creates a new writer on the supplied socket.
+	 * @param socket The STREAM socket, has to stay valid while the writer is used
+	 * @param flushThreshold The number of buffered bytes which triggers an flush, writes of this size or larger bypass the buffer if it is empty
+	 * @param highWatermark The number of buffered bytes above which the writer reports not writable
+	 * @param lowWatermark The number of buffered bytes below which the writer reports writable again
+	 */
+	BufferedWriter(Socket& socket, unsigned int flushThreshold = 16384, unsigned int highWatermark = 1 << 20, unsigned int lowWatermark = 256 << 10);
+
+	/**
+	 * Appends data to the buffer, flushes if the threshold is reached.
+	 * The data is always accepted, even above the high watermark.
+	 * @param buffer The buffer holding the data
+	 * @param length The length of the data
+	 * @return true if the data was buffered or sent, false if sending failed
+	 */
+	bool write(const char* buffer, unsigned int length);
+
+	/**
+	 * Sends all buffered data, blocks until the kernel accepted all of it.
+	 * @return true if all data was sent, false if sending failed
+	 */
+	bool flush();
+
+	/**
+	 * Sends as much buffered data as possible without blocking.
+	 * @param drained Where to store if the buffer is empty afterwards, may be null
+	 * @return true if the function did return normally (no error occurred), false otherwise
+	 */
+	bool tryFlush(bool* drained);
+
+	/**
+	 * Returns if producers may continue writing, false between reaching the high watermark and draining below the low watermark.
+	 * @return true if the writer accepts more data without exceeding its memory budget
+	 */
+	bool isWritable() const;
+
+	/**
+	 * Returns the number of bytes waiting to be sent.
+	 * @return The number of buffered bytes
+	 */
+	unsigned int pending() const;
+
+	/**
+	 * Sets an function which is called whenever isWritable() changes.
+	 * @param handler The function to call with the new state, or an empty function
+	 */
+	void setBackpressureHandler(std::function<void(bool writable)> handler);
+
+private:
+	Socket& socket;
+	unsigned int flushThreshold;
+	unsigned int highWatermark;
+	unsigned int lowWatermark;
+	std::vector<char> buffer;
+	unsigned int offset;
+	bool writable;
+	std::function<void(bool writable)> backpressureHandler;
+
+	bool flushBuffer(bool block);
+	void updateWritable();
+
+};
+
+/**
+ * User space read buffer on top of an STREAM socket, fills an large buffer per system call and serves small reads from it.
+ * peek() and readUntil() return views into the internal buffer, which stay valid until the next call on the reader.
+ * Delimiters are searched with SIMD instructions where available, bytes already searched are not searched again when more data arrives.
+ * In non blocking mode the functions return false if not enough data is available yet without consuming anything,
+ * isClosed() tells this apart from an closed connection.
+ * This class is not thread safe.
+ */
+class BufferedReader {
+
+public:
+	/**
+	 * Creates a new reader on the supplied socket.
+	 * @param socket The STREAM socket, has to stay valid while the reader is used
+	 * @param capacity The size of the internal buffer, also limits the length of peek() and readUntil()
+	 */
+	BufferedReader(Socket& socket, unsigned int capacity = 65536);
+
+	/**
+	 * Returns the number of bytes buffered and readable without an system call.
+	 * @return The number of buffered bytes
+	 */
+	unsigned int available() const;
+
+	/**
+	 * Returns if the connection was closed or failed while receiving, the buffered data can still be read.
+	 * @return true if no more data will arrive
+	 */
+	bool isClosed() const;
+
+	/**
+	 * Receives data into the internal buffer until at least the requested number of bytes is buffered.
+	 * @param length The number of bytes required, at most the capacity
+	 * @return true if the data is buffered, false if the connection was closed or the length exceeds the capacity
+	 */
+	bool fill(unsigned int length);
+
+	/**
+	 * Returns an view of the next bytes without consuming them.
+	 * @param length The number of bytes to look at, at most the capacity
+	 * @param data Where to store the pointer to the bytes
+	 * @return true if the bytes are available, false if the connection was closed before
+	 */
+	bool peek(unsigned int length, const char** data);
+
+	/**
+	 * Consumes bytes previously returned by peek().
+	 * @param length The number of bytes to consume, at most available()
+	 */
+	void consume(unsigned int length);
+
+	/**
+	 * Reads exactly the requested number of bytes, larger reads are received directly into the supplied buffer.
+	 * In non blocking mode the length is limited to the capacity.
+	 * @param buffer The buffer to write the data to
+	 * @param length The number of bytes to read
+	 * @return true if all bytes were read, false if the connection was closed before or the length exceeds the capacity in non blocking mode
+	 */
+	bool readExact(char* buffer, unsigned int length);
+
+	/**
+	 * Reads whatever is available, blocks only if the buffer is empty.
+	 * @param buffer The buffer to write the data to
+	 * @param length The capacity of the buffer
+	 * @param received The actual number of bytes read
+	 * @return true if the function did return normally (no error occurred), false otherwise
+	 */
+	bool read(char* buffer, unsigned int length, unsigned int* received);
+
+	/**
+	 * Reads until and including the next occurrence of the delimiter and returns an view of the data.
+	 * @param delimiter The delimiter bytes, for example "\n" or "\r\n\r\n"
+	 * @param delimiterLength The number of delimiter bytes
+	 * @param maxLength The maximum number of bytes including the delimiter, at most the capacity
+	 * @param data Where to store the pointer to the data
+	 * @param length Where to store the length of the data including the delimiter
+	 * @return true if the delimiter was found, false if the connection was closed or the delimiter was not found within maxLength
+	 */
+	bool readUntil(const char* delimiter, unsigned int delimiterLength, unsigned int maxLength, const char** data, unsigned int* length);
+
+private:
+	Socket& socket;
+	std::vector<char> buffer;
+	unsigned int start;
+	unsigned int end;
+	unsigned int scanned;
+	bool closed;
+
+	bool receiveMore();
+
+};
+
+}
+
+#endif /* NETSOCKET_BUFFERED_HPP_ */
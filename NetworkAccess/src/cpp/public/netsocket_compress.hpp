@@ -0,0 +1,139 @@
+/*
+ * netsocket_compress.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETSOCKET_COMPRESS_HPP_
+#define NETSOCKET_COMPRESS_HPP_
+
+#include <string>
+#include <vector>
+#include "netsocket.hpp"
+#include "netsocket_buffered.hpp"
+
+/**
+ * Message compression on top of STREAM sockets.
+ * The codecs are only available on builds with NETSOCKET_LZ4 or NETSOCKET_ZSTD defined (see lz4Support and zstdSupport in build.meta),
+ * which require liblz4 and libzstd. Uncompressed messages can always be sent and received.
+ */
+
+namespace NetSocket {
+
+/*
+ * Number of message bytes per frame, longer messages are split into multiple frames
+ */
+#define COMPRESSION_BLOCK_SIZE 65536
+
+enum CompressionCodec {
+	COMPRESSION_NONE = 0,
+	COMPRESSION_LZ4 = 1,
+	COMPRESSION_ZSTD = 2
+};
+
+struct CompressionConfig {
+	/** The codec used for outgoing messages, incoming messages are decoded with the codec the peer used */
+	CompressionCodec codec = COMPRESSION_ZSTD;
+	/** The zstd compression level or the LZ4 acceleration factor, 0 selects the library default */
+	int level = 0;
+	/** An dictionary for small similar messages, both peers have to use the same dictionary, empty for none */
+	std::string dictionary;
+	/** If compression is skipped while the connection is not congested or the data does not compress */
+	bool adaptive = true;
+	/** The largest message accepted by receiveMessage() in bytes, larger messages fail the stream */
+	unsigned int maxMessage = 16 << 20;
+};
+
+/**
+ * Sends and receives messages over an STREAM socket with streaming compression.
+ * The compression contexts persist across messages, so later messages are compressed against the history of earlier ones,
+ * which works much better for small similar messages than compressing each message on its own.
+ * All buffers and contexts are allocated once per stream and reused for every message.
+ * In adaptive mode messages are only compressed while the kernel send buffer is full (the link is the bottleneck),
+ * and compression is paused for an growing number of messages if it did not save at least an eighth of the size.
+ * Both peers have to use an CompressedStream, the socket has to be in blocking mode and must not be used directly while the stream is used.
+ * This class is not thread safe.
+ */
+class CompressedStream {
+
+public:
+	/**
+	 * Creates a new stream on the supplied socket.
+	 * If the codec is not available in this build, messages are sent uncompressed.
+	 * @param socket The STREAM socket, has to stay valid while the stream is used
+	 * @param config The codec and compression settings
+	 */
+	CompressedStream(Socket& socket, const CompressionConfig& config);
+	~CompressedStream();
+
+	CompressedStream(const CompressedStream&) = delete;
+	CompressedStream& operator=(const CompressedStream&) = delete;
+
+	/**
+	 * Compresses and sends an message, blocks until all of it was passed to the kernel.
+	 * @param buffer The buffer holding the message
+	 * @param length The length of the message
+	 * @return true if the message was sent, false if sending or compressing failed
+	 */
+	bool sendMessage(const char* buffer, unsigned int length);
+
+	/**
+	 * Receives and decompresses the next message, blocks until it was received completely.
+	 * After invalid data or an message exceeding the configured maximum size was received, the stream is no longer in sync
+	 * with the peer and all further calls fail.
+	 * @param message The vector to store the message in, it is resized to the message length and can be reused to avoid allocations
+	 * @return true if an message was received, false if the connection was closed or the data was invalid
+	 */
+	bool receiveMessage(std::vector<char>& message);
+
+	/**
+	 * Returns the codec used for outgoing messages.
+	 * @return The codec, COMPRESSION_NONE if the configured codec is not available
+	 */
+	CompressionCodec codec() const;
+
+	/**
+	 * Returns the number of message bytes passed to sendMessage().
+	 * @return The number of uncompressed bytes
+	 */
+	unsigned long long originalBytes() const;
+
+	/**
+	 * Returns the number of bytes actually sent, including the frame headers.
+	 * @return The number of bytes written to the socket
+	 */
+	unsigned long long sentBytes() const;
+
+private:
+	Socket& socket;
+	BufferedReader reader;
+	CompressionCodec sendCodec;
+	int level;
+	std::string dictionary;
+	bool adaptive;
+	unsigned int maxMessage;
+	bool receiveFailed;
+	std::vector<char> frame;
+	void* encoder;
+	void* decoderLZ4;
+	void* decoderZSTD;
+	std::vector<char> encodeHistory;	// LZ4 needs the previous block at its original location
+	std::vector<char> decodeHistory;
+	unsigned int encodeSlot;
+	unsigned int decodeSlot;
+	unsigned int congestion;
+	unsigned int skipRemaining;
+	unsigned int backoff;
+	unsigned long long originalCount;
+	unsigned long long sentCount;
+
+	bool compressBlock(const char* buffer, unsigned int length, char* output, unsigned int* compressed);
+	bool decompressBlock(CompressionCodec codec, const char* buffer, unsigned int length, char* output, unsigned int originalLength);
+	bool sendFrame(unsigned int length, bool* blocked);
+
+};
+
+}
+
+#endif /* NETSOCKET_COMPRESS_HPP_ */
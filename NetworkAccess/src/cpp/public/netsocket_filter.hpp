@@ -0,0 +1,143 @@
+/*
+ * netsocket_filter.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETSOCKET_FILTER_HPP_
+#define NETSOCKET_FILTER_HPP_
+
+#include <vector>
+#include "netsocket.hpp"
+
+namespace NetSocket {
+
+/*
+ * Buffer size required by CIDR::format() for any IPv4 or IPv6 network, including the null termination
+ */
+#define CIDR_LENGTH 50
+
+/**
+ * An IPv4 or IPv6 network in CIDR notation, an address and the number of leading bits which identify the network.
+ */
+struct CIDR {
+	unsigned char address[16];	// the network address in network byte order, only the first 4 bytes are used for IPv4
+	unsigned char length;		// the length of the address in bytes, 4 for IPv4 and 16 for IPv6
+	unsigned char prefix;		// the number of leading address bits which belong to the network
+
+	/**
+	 * Parses an network like "10.0.0.0/8" or "2001:db8::/32", an address without prefix is parsed as network with only this address.
+	 * Host bits set behind the prefix are ignored when matching.
+	 * @param str The network text, does not have to be null terminated
+	 * @param length The length of the text
+	 * @return true if the text was an valid network, false otherwise
+	 */
+	bool parse(const char* str, unsigned int length);
+
+	/**
+	 * Initializes the network from an IPv4 or IPv6 address and an prefix length.
+	 * @param address The address, the port is ignored
+	 * @param prefix The number of leading bits, at most 32 for IPv4 and 128 for IPv6
+	 * @return true if the network was initialized, false if the address is no IPv4 or IPv6 address or the prefix is too long
+	 */
+	bool fromaddress(const INetAddress& address, unsigned int prefix);
+
+	/**
+	 * Writes the network as null terminated text in CIDR notation.
+	 * @param buffer The buffer to write the text to, CIDR_LENGTH bytes are enough for all networks
+	 * @param capacity The size of the buffer
+	 * @param length Where to store the length of the text without the null termination
+	 * @return true if the text was written, false if the buffer is too small
+	 */
+	bool format(char* buffer, unsigned int capacity, unsigned int* length) const;
+
+	/**
+	 * Checks if the address belongs to this network, IPv4 mapped IPv6 addresses (::ffff:a.b.c.d) match IPv4 networks.
+	 * @param address The address, the port is ignored
+	 * @return true if the address is within the network, false otherwise
+	 */
+	bool contains(const INetAddress& address) const;
+};
+
+/**
+ * An longest prefix match index of allowed and denied networks, used to filter peers by their address.
+ * The networks are stored in an path compressed binary trie per address family, so an lookup visits at most one node per
+ * stored prefix length on the path to the address and does not allocate memory.
+ * IPv4 mapped IPv6 addresses (::ffff:a.b.c.d), which dual stack sockets report for IPv4 peers, are looked up in the IPv4 networks.
+ * Lookups on an constant filter are thread safe, modifications have to be synchronized with all lookups by the caller.
+ */
+class AddressFilter {
+
+public:
+	/**
+	 * Creates an empty filter.
+	 * @param allowByDefault If addresses which do not match any network are allowed
+	 */
+	AddressFilter(bool allowByDefault = true);
+
+	/**
+	 * Adds an network or replaces the action of an network with the same address and prefix.
+	 * The network with the longest prefix that contains an address decides if it is allowed.
+	 * @param network The network to add
+	 * @param allow If addresses in this network are allowed or denied
+	 * @return true if the network was added, false if it is invalid
+	 */
+	bool add(const CIDR& network, bool allow);
+
+	/**
+	 * Removes an network previously added with the same address and prefix.
+	 * @param network The network to remove
+	 * @return true if the network was removed, false if it was not in the filter
+	 */
+	bool remove(const CIDR& network);
+
+	/**
+	 * Removes all networks.
+	 */
+	void clear();
+
+	/**
+	 * Changes if addresses which do not match any network are allowed.
+	 * @param allowByDefault If unmatched addresses are allowed
+	 */
+	void setDefault(bool allowByDefault);
+
+	/**
+	 * Looks up the action for an address given in network byte order.
+	 * @param address The address bytes
+	 * @param length The number of address bytes, 4 for IPv4 and 16 for IPv6
+	 * @return true if the address is allowed, false otherwise
+	 */
+	bool isAllowed(const unsigned char* address, unsigned int length) const;
+
+	/**
+	 * Looks up the action for an address, addresses which are neither IPv4 nor IPv6 (unix domain sockets) get the default action.
+	 * @param address The address, the port is ignored
+	 * @return true if the address is allowed, false otherwise
+	 */
+	bool isAllowed(const INetAddress& address) const;
+
+private:
+	/*
+	 * The key holds the address bits in host order, the first address bit is the highest bit of key[0]
+	 * children and roots are indices into the node vector, zero marks an missing node since node zero is an unused placeholder
+	 */
+	struct Node {
+		unsigned long long key[2];
+		unsigned int children[2];
+		unsigned char prefix;
+		signed char action;	// -1 for branch nodes without own network, 0 deny, 1 allow
+	};
+
+	std::vector<Node> nodes;
+	unsigned int roots[2];	// IPv4 and IPv6
+	bool allowByDefault;
+
+	unsigned int createNode(const unsigned long long* key, unsigned int prefix, int action);
+
+};
+
+}
+
+#endif /* NETSOCKET_FILTER_HPP_ */
@@ -0,0 +1,155 @@
+/*
+ * netsocket_handle.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETSOCKET_HANDLE_HPP_
+#define NETSOCKET_HANDLE_HPP_
+
+#include "netsocket.hpp"
+#include "netsocket_native.hpp"
+
+namespace NetSocket {
+
+/**
+ * An owned stream connection stored as value, for tables with many mostly idle connections.
+ * The handle holds only the platform handle and an packed flag word, there is no heap object, no vtable pointer and no profile or address copy per connection.
+ * On linux an handle takes 8 bytes, on 64 bit windows 16 bytes (SOCKET is pointer sized), so an std::vector<SocketHandle> with one million
+ * connections needs 8 MB on linux, compared to an pointer plus an SocketLin heap object of several hundred bytes for newSocket().
+ * The handle can only be moved, the moved from handle is closed, the connection is closed when the owning handle is destroyed.
+ * Functions which are rarely needed per connection (profiles, timeouts, peer address, ...) are available by moving the connection into an Socket with release().
+ */
+class SocketHandle final {
+
+public:
+	SocketHandle() : handle(invalidHandle()), flags(0) {}
+
+	~SocketHandle() {
+		close();
+	}
+
+	SocketHandle(SocketHandle&& other) : handle(other.handle), flags(other.flags) {
+		other.handle = invalidHandle();
+		other.flags = 0;
+	}
+
+	SocketHandle& operator=(SocketHandle&& other) {
+		if (this == &other)
+			return *this;
+		close();
+		this->handle = other.handle;
+		this->flags = other.flags;
+		other.handle = invalidHandle();
+		other.flags = 0;
+		return *this;
+	}
+
+	SocketHandle(const SocketHandle&) = delete;
+	SocketHandle& operator=(const SocketHandle&) = delete;
+
+	/**
+	 * Accepts the next connection of an listening socket, see Socket::accept().
+	 * The profile and address filter of the listening socket are applied, the handle is in blocking mode afterwards.
+	 * @param listenSocket An plain platform socket in LISTEN_TCP mode created by newSocket()
+	 * @return true if an connection was accepted, false otherwise (including no connection queued on non blocking listen sockets)
+	 */
+	bool accept(Socket& listenSocket);
+
+	/**
+	 * Connects to an remote address, see Socket::connect().
+	 * @param address The address to connect to
+	 * @param timeout The timeout in milliseconds for the connection to be established
+	 * @return true if the connection was established, false otherwise
+	 */
+	bool connect(const INetAddress& address, unsigned long timeout);
+
+	/**
+	 * Takes over the connection of an socket, the socket is unbound afterwards but keeps its profile and can be reused.
+	 * The blocking mode of the socket is kept, an address filter and cached peer address are not.
+	 * @param socket An plain platform socket in STREAM mode created by newSocket()
+	 * @return true if the connection was taken over, false if the socket is no connected plain platform socket or this handle is still open
+	 */
+	bool adopt(Socket& socket);
+
+	/**
+	 * Moves the connection into an unbound socket, to use functions not provided by the handle, this handle is closed afterwards.
+	 * @param socket An unbound plain platform socket created by newSocket()
+	 * @return true if the connection was moved, false if the socket is no unbound plain platform socket or this handle is closed
+	 */
+	bool release(Socket& socket);
+
+	/**
+	 * Closes the connection, does nothing if the handle is already closed.
+	 */
+	void close();
+
+	/**
+	 * Checks if the handle holds an connection, this does not detect connections closed by the peer, see Socket::isOpen().
+	 * @return true if the handle holds an connection
+	 */
+	bool isOpen() const {
+		return this->handle != invalidHandle();
+	}
+
+	/**
+	 * Returns the platform handle, for example to register it in an poll set owned by the caller.
+	 * @return The platform handle, -1 or INVALID_SOCKET if the handle is closed
+	 */
+	NativeHandle native() const {
+		return this->handle;
+	}
+
+	/**
+	 * Same as Socket::setBlocking().
+	 */
+	bool setBlocking(bool blocking);
+
+	/**
+	 * Returns the blocking mode set by setBlocking().
+	 * @return true if the handle is in blocking mode
+	 */
+	bool isBlocking() const {
+		return (this->flags & FLAG_NON_BLOCKING) == 0;
+	}
+
+	/**
+	 * Same as Socket::send().
+	 */
+	bool send(const char* buffer, unsigned int length);
+
+	/**
+	 * Same as Socket::receive().
+	 */
+	bool receive(char* buffer, unsigned int length, unsigned int* received);
+
+	/**
+	 * Same as Socket::trySend().
+	 */
+	bool trySend(const char* buffer, unsigned int length, unsigned int* sent, bool* wouldBlock);
+
+	/**
+	 * Same as Socket::tryReceive().
+	 */
+	bool tryReceive(char* buffer, unsigned int length, unsigned int* received, bool* wouldBlock);
+
+private:
+	enum HandleFlags : unsigned int {
+		FLAG_NON_BLOCKING = 1
+	};
+
+	static constexpr NativeHandle invalidHandle() {
+		return (NativeHandle) -1; // equals INVALID_SOCKET on windows
+	}
+
+	NativeHandle handle;
+	unsigned int flags;
+
+};
+
+static_assert(sizeof(SocketHandle) <= 2 * sizeof(NativeHandle), "SocketHandle has to stay an platform handle plus one packed word");
+
+}
+
+#endif /* NETSOCKET_HANDLE_HPP_ */
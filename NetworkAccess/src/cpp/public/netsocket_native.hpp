@@ -0,0 +1,210 @@
+/*
+ * netsocket_native.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETSOCKET_NATIVE_HPP_
+#define NETSOCKET_NATIVE_HPP_
+
+#include <atomic>
+#include "netsocket.hpp"
+
+#if defined(PLATFORM_LIN)
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#elif defined(PLATFORM_WIN)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#error "netsocket_native.hpp requires PLATFORM_LIN or PLATFORM_WIN to be defined, the same as for the library build"
+#endif
+
+namespace NetSocket {
+
+#ifdef PLATFORM_WIN
+typedef SOCKET NativeHandle;
+#else
+typedef int NativeHandle;
+#endif
+
+/**
+ * Statically dispatched access to the I/O functions of an plain platform socket created by newSocket().
+ * The functions are defined in this header, so hot loops can inline the system call instead of calling trough the virtual Socket interface.
+ * Only the case that completes immediately is handled inline, everything else (waiting in blocking mode, errors, closed connections)
+ * is delegated to the attached socket, so the results are the same as calling the socket directly.
+ * The state is read trough the attached socket on every call, so the view stays valid if the socket is closed and opened again.
+ * Operations completed inline are not recorded by the latency tracing (see netsocket_trace.hpp).
+ * Unlike the calls trough the socket, the inline path holds no reference on the handle, so the socket must not be closed
+ * by another thread while an function of the view is running.
+ */
+class NativeSocket final {
+
+public:
+	NativeSocket() : target(0), handle(0), stype(0), family(0), filter(0) {}
+
+	/**
+	 * Attaches this view to an socket, which has to stay valid while the view is used.
+	 * TLS and shared memory sockets can not be attached, since their data does not go directly trough the handle.
+	 * @param socket The socket created by newSocket()
+	 * @return true if the view was attached, false if the socket is no plain platform socket
+	 */
+	bool attach(Socket& socket);
+
+	/**
+	 * Returns the attached socket, for all functions which are not on the hot path.
+	 * @return The attached socket, or null if the view is not attached
+	 */
+	Socket* socket() const {
+		return this->target;
+	}
+
+	/**
+	 * Same as Socket::send(), the view has to be attached.
+	 */
+	bool send(const char* buffer, unsigned int length) {
+#ifdef PLATFORM_LIN
+		if (*this->stype == STREAM) {
+			ssize_t result = ::send(*this->handle, buffer, length, MSG_DONTWAIT | MSG_NOSIGNAL);
+			if (result == (ssize_t) length) return true;
+			if (result > 0) {
+				buffer += result;
+				length -= result;
+			}
+		}
+#else
+		if (*this->stype == STREAM) {
+			int result = ::send(*this->handle, buffer, length, 0);
+			if (result == (int) length) return true;
+			if (result > 0) {
+				buffer += result;
+				length -= result;
+			} else if (result == SOCKET_ERROR && WSAGetLastError() == WSAETIMEDOUT) {
+				return true; // timed out
+			}
+		}
+#endif
+		return this->target->send(buffer, length);
+	}
+
+	/**
+	 * Same as Socket::receive(), the view has to be attached.
+	 */
+	bool receive(char* buffer, unsigned int length, unsigned int* received) {
+#ifdef PLATFORM_LIN
+		if (*this->stype == STREAM) {
+			ssize_t result = ::recv(*this->handle, buffer, length, MSG_DONTWAIT);
+			if (result > 0) {
+				*received = result;
+				return true;
+			}
+		}
+#else
+		if (*this->stype == STREAM) {
+			int result = ::recv(*this->handle, buffer, length, 0);
+			if (result > 0) {
+				*received = result;
+				return true;
+			} else if (result == SOCKET_ERROR && (WSAGetLastError() == WSAETIMEDOUT || WSAGetLastError() == WSAEWOULDBLOCK)) {
+				*received = 0;
+				return true; // timed out or nothing to read in non blocking mode
+			}
+		}
+#endif
+		return this->target->receive(buffer, length, received);
+	}
+
+	/**
+	 * Same as Socket::trySend(), the view has to be attached.
+	 */
+	bool trySend(const char* buffer, unsigned int length, unsigned int* sent, bool* wouldBlock) {
+#ifdef PLATFORM_LIN
+		if (*this->stype == STREAM) {
+			ssize_t result = ::send(*this->handle, buffer, length, MSG_DONTWAIT | MSG_NOSIGNAL);
+			if (result >= 0 || errno == EAGAIN || errno == EWOULDBLOCK) {
+				*sent = result > 0 ? result : 0;
+				*wouldBlock = *sent < length;
+				return true;
+			}
+		}
+#endif
+		return this->target->trySend(buffer, length, sent, wouldBlock);
+	}
+
+	/**
+	 * Same as Socket::tryReceive(), the view has to be attached.
+	 */
+	bool tryReceive(char* buffer, unsigned int length, unsigned int* received, bool* wouldBlock) {
+#ifdef PLATFORM_LIN
+		if (*this->stype == STREAM) {
+			ssize_t result = ::recv(*this->handle, buffer, length, MSG_DONTWAIT);
+			if (result > 0 || (result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+				*received = result > 0 ? result : 0;
+				*wouldBlock = result < 0;
+				return true;
+			}
+		}
+#endif
+		return this->target->tryReceive(buffer, length, received, wouldBlock);
+	}
+
+	/**
+	 * Same as Socket::sendto(), the view has to be attached.
+	 */
+	bool sendto(const inetaddr& address, const char* buffer, unsigned int length) {
+		unsigned short addressFamily = ((const sockaddr*) address.addr)->sa_family;
+		if (*this->stype == LISTEN_UDP && addressFamily == *this->family && (addressFamily == AF_INET || addressFamily == AF_INET6)) {
+#ifdef PLATFORM_LIN
+			if (::sendto(*this->handle, buffer, length, MSG_DONTWAIT, (const sockaddr*) address.addr, addressFamily == AF_INET ? sizeof(sockaddr_in) : sizeof(sockaddr_in6)) >= 0)
+				return true;
+#else
+			if (::sendto(*this->handle, buffer, length, 0, (const sockaddr*) address.addr, addressFamily == AF_INET ? sizeof(SOCKADDR_IN) : sizeof(SOCKADDR_IN6)) != SOCKET_ERROR)
+				return true;
+#endif
+		}
+		return this->target->sendto(address, buffer, length);
+	}
+
+	/**
+	 * Same as Socket::receivefrom(), the view has to be attached.
+	 * Sockets with an address filter always use the attached socket.
+	 */
+	bool receivefrom(inetaddr& address, char* buffer, unsigned int length, unsigned int* received) {
+		if (*this->stype == LISTEN_UDP && *this->filter == 0 && (*this->family == AF_INET || *this->family == AF_INET6)) {
+#ifdef PLATFORM_LIN
+			socklen_t addressLength = sizeof(sockaddr_in6);
+			ssize_t result = ::recvfrom(*this->handle, buffer, length, MSG_DONTWAIT, (sockaddr*) address.addr, &addressLength);
+			if (result >= 0) {
+				*received = result;
+				return result > 0; // an empty datagram is reported like an closed connection
+			}
+#else
+			int addressLength = sizeof(SOCKADDR_IN6);
+			int result = ::recvfrom(*this->handle, buffer, length, 0, (sockaddr*) address.addr, &addressLength);
+			if (result != SOCKET_ERROR) {
+				*received = result;
+				return result > 0;
+			} else if (WSAGetLastError() == WSAETIMEDOUT || WSAGetLastError() == WSAEWOULDBLOCK) {
+				*received = 0;
+				return true; // timed out or nothing to read in non blocking mode
+			}
+#endif
+		}
+		return this->target->receivefrom(address, buffer, length, received);
+	}
+
+private:
+	Socket* target;
+	const std::atomic<NativeHandle>* handle;
+	const std::atomic<SocketType>* stype;
+	const unsigned short* family;
+	const AddressFilter* const* filter;
+
+};
+
+}
+
+#endif /* NETSOCKET_NATIVE_HPP_ */
@@ -0,0 +1,71 @@
+/*
+ * netsocket_pacer.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETSOCKET_PACER_HPP_
+#define NETSOCKET_PACER_HPP_
+
+#include <chrono>
+#include "netsocket.hpp"
+
+namespace NetSocket {
+
+/**
+ * User space token bucket pacing for UDP senders, on top of Socket::sendtoBatch().
+ * The bucket is tracked as the time the next datagram is allowed to be sent (generic cell rate algorithm),
+ * so the rate is exact over time without an timer refilling tokens.
+ * send() never sleeps, it sends what the rate allows and returns, waitTime() tells an event loop when to call it again,
+ * for example as the timeout of Socket::pollMany().
+ * Only the payload bytes are counted, IP and UDP headers are not included in the rate.
+ * This class is not thread safe.
+ */
+class UdpPacer {
+
+public:
+	/**
+	 * Creates a new pacer for the supplied socket.
+	 * @param socket The bound LISTEN_UDP socket, has to stay valid while the pacer is used
+	 * @param rate The send rate in bytes per second, 0 for unlimited
+	 * @param burst The number of bytes which may be sent back to back after an idle period
+	 */
+	UdpPacer(Socket& socket, unsigned long long rate, unsigned int burst = 16384);
+
+	/**
+	 * Changes the rate and burst size, the time already earned or owed is kept.
+	 * @param rate The send rate in bytes per second, 0 for unlimited
+	 * @param burst The number of bytes which may be sent back to back after an idle period
+	 */
+	void setRate(unsigned long long rate, unsigned int burst);
+
+	/**
+	 * Sends the datagrams the rate currently allows, in batches of up to 64 datagrams per system call.
+	 * The first datagram is always allowed if the pacer was idle long enough, even if it is larger than the burst size.
+	 * @param datagrams The datagrams to send, address, buffer and length have to be set by the caller
+	 * @param count The number of datagrams in the array
+	 * @param sentCount The number of datagrams sent, the remaining ones have to be passed again later
+	 * @return true if the function did return normally (no error occurred), false otherwise
+	 */
+	bool send(const Datagram* datagrams, unsigned int count, unsigned int* sentCount);
+
+	/**
+	 * Returns the time until the rate allows the next datagram.
+	 * @return The time to wait in us, 0 if an datagram can be sent now
+	 */
+	unsigned long long waitTime() const;
+
+private:
+	Socket& socket;
+	unsigned long long rate;
+	unsigned long long burstTime;	// ns of sending the burst size may be ahead of the current time
+	std::chrono::steady_clock::time_point nextSend;
+
+	unsigned long long sendTime(unsigned int length) const;
+
+};
+
+}
+
+#endif /* NETSOCKET_PACER_HPP_ */
@@ -0,0 +1,177 @@
+/*
+ * netsocket_rpc.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETSOCKET_RPC_HPP_
+#define NETSOCKET_RPC_HPP_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <chrono>
+#include "netsocket.hpp"
+#include "netsocket_buffered.hpp"
+
+namespace NetSocket {
+
+enum RpcStatus {
+	RPC_OK = 0,			// the peer responded normally
+	RPC_ERROR = 1,		// the peer responded with an application error
+	RPC_TIMEOUT = 2,	// the deadline passed before the response arrived
+	RPC_REJECTED = 3,	// the peer had too many requests in flight
+	RPC_CLOSED = 4		// the connection was closed before the response arrived
+};
+
+struct RpcResult {
+	RpcStatus status;
+	std::string response;
+};
+
+/**
+ * Called once per request with the status and the response, the data is only valid during the call.
+ */
+typedef std::function<void(RpcStatus status, const char* data, unsigned int length)> RpcCallback;
+
+/**
+ * Called for each incoming request, the request has to be answered with respond(), which may happen later and on any thread.
+ * The data is only valid during the call.
+ */
+typedef std::function<void(unsigned int id, const char* data, unsigned int length)> RpcHandler;
+
+/**
+ * Request/response channel on top of an STREAM socket, with many requests in flight on the one connection.
+ * Each request is tagged with an stream id, responses may arrive in any order and complete the matching callback or future.
+ * Both peers can send requests and answer requests of the other peer.
+ * Flow control: each peer announces how many of its incoming requests may be unanswered at once, call() returns false
+ * while that many requests are in flight, the peer is assumed to accept one request until its announcement arrived.
+ * Requests can have an deadline, update() completes them with RPC_TIMEOUT and tells the peer to drop them.
+ * Frames of concurrent callers are coalesced: while one thread writes to the socket, the frames of other threads are
+ * collected and sent with the next write, cork() additionally collects frames of an single thread until uncork().
+ * All functions are thread safe, process() is expected to be called by one thread in an loop, callbacks and the request handler
+ * run on the thread calling process() or update() (timeouts) and must not call process() themselves.
+ */
+class RpcChannel {
+
+public:
+	/**
+	 * Creates a new channel on the supplied socket and announces the window to the peer.
+	 * @param socket The connected STREAM socket in blocking mode, has to stay valid while the channel is used
+	 * @param window The number of incoming requests which may be unanswered at once, further requests are rejected
+	 * @param maxMessage The maximum length of an incoming request or response, longer messages close the channel
+	 */
+	RpcChannel(Socket& socket, unsigned int window = 256, unsigned int maxMessage = 16 << 20);
+
+	/**
+	 * Completes all requests in flight with RPC_CLOSED, the socket is not closed.
+	 */
+	~RpcChannel();
+
+	RpcChannel(const RpcChannel&) = delete;
+	RpcChannel& operator=(const RpcChannel&) = delete;
+
+	/**
+	 * Sets the function which receives the requests of the peer, requests arriving without handler are answered with RPC_ERROR.
+	 * @param handler The function to call for each request
+	 */
+	void setRequestHandler(RpcHandler handler);
+
+	/**
+	 * Sends an request, the callback is called once when the response arrives or the request failed.
+	 * @param buffer The buffer holding the request
+	 * @param length The length of the request
+	 * @param timeout The deadline in milliseconds, 0 for none
+	 * @param callback The function to call with the response
+	 * @return true if the request was sent, false if the window of the peer is full or the channel is closed, the callback is not called then
+	 */
+	bool call(const char* buffer, unsigned int length, unsigned long timeout, RpcCallback callback);
+
+	/**
+	 * Sends an request and returns an future for the response.
+	 * @param buffer The buffer holding the request
+	 * @param length The length of the request
+	 * @param timeout The deadline in milliseconds, 0 for none
+	 * @return The future, completed with RPC_REJECTED if the window of the peer is full or with RPC_CLOSED if the channel is closed
+	 */
+	std::future<RpcResult> call(const char* buffer, unsigned int length, unsigned long timeout);
+
+	/**
+	 * Answers an request received by the request handler.
+	 * @param id The id passed to the request handler
+	 * @param buffer The buffer holding the response
+	 * @param length The length of the response
+	 * @param status RPC_OK or RPC_ERROR for an application error
+	 * @return true if the response was sent, false if the request is unknown or was dropped by the peer, or sending failed
+	 */
+	bool respond(unsigned int id, const char* buffer, unsigned int length, RpcStatus status = RPC_OK);
+
+	/**
+	 * Receives and processes the next frame, blocks until one arrives.
+	 * @return true if an frame was processed, false if the connection was closed or the peer sent invalid data
+	 */
+	bool process();
+
+	/**
+	 * Completes requests whose deadline passed with RPC_TIMEOUT, has to be called regularly if deadlines are used.
+	 */
+	void update();
+
+	/**
+	 * Collects all following frames of this channel until uncork() or until an large amount of data is collected.
+	 */
+	void cork();
+
+	/**
+	 * Sends all frames collected since cork().
+	 * @return true if the frames were sent, false otherwise
+	 */
+	bool uncork();
+
+	/**
+	 * Returns the number of own requests waiting for an response.
+	 * @return The number of requests in flight
+	 */
+	unsigned int inFlight();
+
+private:
+	struct Call {
+		std::chrono::steady_clock::time_point deadline;
+		bool hasDeadline;
+		RpcCallback callback;
+	};
+
+	Socket& socket;
+	BufferedReader reader;
+	unsigned int window;
+	unsigned int maxMessage;
+	std::vector<char> payload;
+
+	std::mutex lock;
+	std::unordered_map<unsigned int, Call> calls;
+	std::unordered_set<unsigned int> incoming;
+	unsigned int peerWindow;
+	unsigned int nextId;
+	bool closed;
+	RpcHandler handler;
+
+	std::mutex writeLock;
+	std::vector<char> pending;
+	std::vector<char> sending;
+	bool writing;
+	bool corked;
+
+	bool writeFrame(unsigned int type, unsigned int status, unsigned int id, const char* buffer, unsigned int length);
+	bool flushPending(std::unique_lock<std::mutex>& guard);
+	void closeChannel();
+
+};
+
+}
+
+#endif /* NETSOCKET_RPC_HPP_ */
@@ -0,0 +1,133 @@
+/*
+ * netsocket_rudp.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETSOCKET_RUDP_HPP_
+#define NETSOCKET_RUDP_HPP_
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include "netsocket.hpp"
+
+namespace NetSocket {
+
+enum DeliveryMode {
+	UNRELIABLE = 0,			// may be lost, duplicated fragments are dropped
+	RELIABLE = 1,			// retransmitted until acknowledged, delivered in arrival order
+	RELIABLE_ORDERED = 2	// retransmitted until acknowledged, delivered in the order it was sent
+};
+
+/**
+ * Bounds the memory an peer can make the channel allocate, since all state is created by unauthenticated datagrams.
+ */
+struct ReliableUdpLimits {
+	/** The largest message sent or accepted in bytes, fragmented messages announcing more fragments than needed for it are dropped */
+	unsigned int maxMessage = 1 << 20;
+	/** The bytes of incomplete fragmented messages and out of order messages buffered for all peers together */
+	unsigned long long maxBuffered = 64ULL << 20;
+	/** The number of peers tracked at the same time, datagrams from further addresses are dropped until disconnect() removes an peer */
+	unsigned int maxPeers = 4096;
+};
+
+/**
+ * Message channel with selective reliability on top of an LISTEN_UDP socket.
+ * Any number of peers are multiplexed on the one bound socket, each peer has its own sequence numbers, acknowledgments and retransmission timer.
+ * Messages larger than the maximum payload are split into fragments and reassembled by the receiver.
+ * Reliable packets are acknowledged with the highest received sequence number and an bitmap of the 32 sequence numbers before it,
+ * so single lost acknowledgments do not cause retransmissions.
+ * All functions are thread safe, receive() is expected to be called by one thread while others send and call update().
+ */
+class ReliableUdp {
+
+public:
+	/**
+	 * Creates a new channel on the supplied socket.
+	 * @param socket The bound LISTEN_UDP socket, has to stay valid while the channel is used
+	 * @param maxPayload The maximum number of message bytes per datagram, larger messages are fragmented
+	 * @param limits The memory limits for state created by received datagrams
+	 */
+	ReliableUdp(Socket& socket, unsigned int maxPayload = 1200, const ReliableUdpLimits& limits = ReliableUdpLimits());
+	~ReliableUdp();
+
+	/**
+	 * Sends an message to the peer.
+	 * @param peer The address of the peer
+	 * @param buffer The buffer holding the message
+	 * @param length The length of the message
+	 * @param mode The delivery guarantees of the message
+	 * @return true if the message was queued and sent, false if the send window of the peer is full, the message exceeds the maximum size,
+	 * the peer limit is reached or sending failed
+	 */
+	bool send(const INetAddress& peer, const char* buffer, unsigned int length, DeliveryMode mode);
+
+	/**
+	 * Receives the next complete message from any peer.
+	 * This function blocks until an message is available, acknowledgments and fragments are processed internally.
+	 * @param peer Where to store the address of the sender
+	 * @param message Where to store the message
+	 * @param mode Where to store the delivery mode of the message, may be null
+	 * @return true if an message was received, false if the socket failed or was closed
+	 */
+	bool receive(INetAddress& peer, std::string& message, DeliveryMode* mode);
+
+	/**
+	 * Retransmits unacknowledged packets whose retransmission timeout expired and drops stale fragments.
+	 * An peer whose reliable message stays incomplete for 30 seconds is dropped like an peer which does not acknowledge.
+	 * Has to be called regularly (every few milliseconds) by the application.
+	 */
+	void update();
+
+	/**
+	 * Returns the next peer that was dropped because reliable packets could not be delivered after the maximum number of retries,
+	 * or because an reliable message it sent could not be reassembled in time.
+	 * @param peer Where to store the address of the peer
+	 * @return true if an lost peer was returned, false if there are none
+	 */
+	bool lostPeer(INetAddress& peer);
+
+	/**
+	 * Reads the round trip time statistics of an peer.
+	 * @param peer The address of the peer
+	 * @param smoothedRtt Where to store the smoothed round trip time in us
+	 * @param rttVariance Where to store the round trip time variance in us
+	 * @param pending Where to store the number of unacknowledged reliable packets
+	 * @return true if the peer is known, false otherwise
+	 */
+	bool getPeerStats(const INetAddress& peer, unsigned long* smoothedRtt, unsigned long* rttVariance, unsigned int* pending);
+
+	/**
+	 * Drops all state of an peer, including unacknowledged packets.
+	 * @param peer The address of the peer
+	 */
+	void disconnect(const INetAddress& peer);
+
+private:
+	struct Peer;
+	struct Message;
+
+	Socket& socket;
+	unsigned int maxPayload;
+	ReliableUdpLimits limits;
+	unsigned long long buffered;
+	std::mutex lock;
+	std::map<INetAddress, Peer*> peers;
+	std::deque<INetAddress> lostPeers;
+	std::deque<Message*> messages;
+
+	Peer* getPeer(const INetAddress& address);
+	void removePeer(std::map<INetAddress, Peer*>::iterator entry);
+	bool transmit(const INetAddress& address, const std::string& packet);
+	void processPacket(const INetAddress& address, const char* packet, unsigned int length);
+	void processAck(Peer* peer, unsigned int ackSequence, unsigned int ackBits, std::chrono::steady_clock::time_point now);
+	void sendAck(const INetAddress& address, Peer* peer, unsigned int ackSequence);
+
+};
+
+}
+
+#endif /* NETSOCKET_RUDP_HPP_ */
@@ -0,0 +1,38 @@
+/*
+ * netsocket_shm.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETSOCKET_SHM_HPP_
+#define NETSOCKET_SHM_HPP_
+
+#include "netsocket.hpp"
+
+/**
+ * Shared memory transport for peers on the same host (linux only).
+ */
+
+namespace NetSocket {
+
+/**
+ * Creates a new unbound shared memory socket.
+ * The returned socket is used like an normal STREAM socket, but the payload is exchanged trough two single producer/single consumer
+ * ring buffers in an shared memory region instead of the network stack. Idle receivers spin shortly before they sleep on an futex,
+ * so an waiting peer receives data without any system call.
+ * listen() and connect() require an unix domain address (see INetAddress::fromunix()), which is only used to exchange the shared memory.
+ * Sockets passed to accept() on an shared memory listen socket have to be shared memory sockets too.
+ * Only one thread may send and one thread may receive on an socket at the same time.
+ * UDP operations (bind, receivefrom, sendto) are not supported.
+ * The shared memory is sealed against resizing, and accept() gives up if the client does not send it within 5 seconds.
+ * An non blocking accept() does not wait for the shared memory, it is received by the first send or receive on the accepted socket.
+ * Until then the non blocking receive calls return no data, and after the 5 seconds the connection is closed.
+ * @param capacity The size of each ring buffer in bytes, rounded up to an power of two, only used by connect(), at most 2 GB
+ * @return The new socket, or null if the capacity is too large
+ */
+NetSocket::Socket* newShmSocket(unsigned int capacity = 1 << 20);
+
+}
+
+#endif /* NETSOCKET_SHM_HPP_ */
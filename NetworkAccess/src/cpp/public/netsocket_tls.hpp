@@ -0,0 +1,75 @@
+/*
+ * netsocket_tls.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETSOCKET_TLS_HPP_
+#define NETSOCKET_TLS_HPP_
+
+#include "netsocket.hpp"
+
+/**
+ * TLS encrypted STREAM sockets.
+ * Only available on linux builds with NETSOCKET_TLS defined (see tlsSupport in build.meta), requires OpenSSL.
+ */
+
+namespace NetSocket {
+
+struct TLSConfig {
+	/** PEM file holding the certificate (chain) presented to the peer, required for listen/accept */
+	std::string certificateFile;
+	/** PEM file holding the private key of the certificate */
+	std::string privateKeyFile;
+	/** PEM file with the trusted CA certificates, the system defaults are used if empty */
+	std::string trustedCertificatesFile;
+	/** The host name to send as SNI and to verify the peer certificate against, only used by connect(), required if verifyPeer is set */
+	std::string serverName;
+	/** If the peer certificate has to be verified, connect() fails if this is set but serverName is empty */
+	bool verifyPeer = true;
+	/** If the record encryption should be offloaded to the kernel (kTLS) after the handshake, if supported */
+	bool kernelOffload = true;
+	/** Time in ms the handshake in connect() and accept() may take, zero to wait indefinitely */
+	unsigned long handshakeTimeout = 10000;
+};
+
+/**
+ * Creates a new unbound TLS socket.
+ * The returned socket behaves like an normal STREAM socket, but the handshake is performed during connect() and accept().
+ * Sockets passed to accept() on an TLS listen socket have to be TLS sockets too, they inherit the configuration of the listen socket.
+ * If the handshake of an accepted client fails or exceeds the handshake timeout, the client is dropped and an blocking accept()
+ * continues with the next connection, an non blocking accept() returns false.
+ * An non blocking accept() does not wait for the client, the handshake is completed by the first send or receive on the accepted socket.
+ * Until then the non blocking receive calls return no data, and if it fails or exceeds the handshake timeout the connection is closed.
+ * UDP operations (bind, receivefrom, sendto) are not supported.
+ * close() is safe from any thread, but sending and receiving from different threads at the same time is not, since OpenSSL does not allow it on one connection.
+ * @param config The certificate and verification settings
+ * @return The new socket, or nullptr if the configuration could not be loaded
+ */
+NetSocket::Socket* newTLSSocket(const TLSConfig& config);
+
+/**
+ * Checks if the record encryption of the supplied TLS socket is handled by the kernel.
+ * When enabled the TCP_ULP "tls" is installed on the socket and no encryption happens in user space.
+ * @param socket The connected TLS socket
+ * @param kernelSend Where to store if sending is offloaded
+ * @param kernelReceive Where to store if receiving is offloaded
+ * @return true if the state was read successfully, false otherwise
+ */
+bool getKernelTLS(Socket& socket, bool* kernelSend, bool* kernelReceive);
+
+/**
+ * Sends the content of an file trough the TLS connection.
+ * If kernel offloading is active for sending, the data is transfered without being copied into user space.
+ * @param socket The connected TLS socket
+ * @param fileHandle The file descriptor to read from
+ * @param offset The offset in the file to start reading from
+ * @param length The number of bytes to send
+ * @return true if the data was sent successfully, false otherwise
+ */
+bool sendFileTLS(Socket& socket, int fileHandle, long long offset, unsigned long long length);
+
+}
+
+#endif /* NETSOCKET_TLS_HPP_ */
@@ -0,0 +1,107 @@
+/*
+ * netsocket_trace.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETSOCKET_TRACE_HPP_
+#define NETSOCKET_TRACE_HPP_
+
+#include <string>
+
+/**
+ * Latency tracing of socket operations (linux only).
+ * The tracing hooks are only compiled into the library if the latencyTracing switch in build.meta is enabled (defines NETSOCKET_TRACING),
+ * otherwise all functions in this header report that tracing is not available.
+ * Each thread records the spans of its socket operations into its own lock free ring buffer and histograms,
+ * so tracing does not add any synchronization between threads that use different sockets.
+ */
+
+namespace NetSocket {
+
+enum TraceOperation {
+	TRACE_CONNECT = 0,		// connect() and connectFastOpen(), from the creation of the socket until the connection is established
+	TRACE_ACCEPT_WAIT = 1,	// time blocked in accept() until an connection was taken from the accept queue
+	TRACE_RECEIVE_WAIT = 2,	// time blocked in the poll loop of the receive functions until data was available
+	TRACE_RECEIVE = 3,		// duration of the receive system call
+	TRACE_SEND = 4,			// duration of the send system call
+	TRACE_OPERATION_COUNT = 5
+};
+
+/*
+ * Number of log linear histogram buckets, values up to 15ns are counted exactly, above that each power of two is split into 16 buckets (6.25% precision)
+ */
+#define TRACE_BUCKETS 976
+
+/**
+ * An histogram of operation durations in ns.
+ */
+struct TraceHistogram {
+	unsigned long long count;
+	unsigned long long minimum;
+	unsigned long long maximum;
+	unsigned long long total;
+	unsigned long long buckets[TRACE_BUCKETS];
+
+	/**
+	 * Returns the smallest value which falls into the bucket.
+	 * @param bucket The index of the bucket
+	 * @return The lower bound of the bucket in ns
+	 */
+	static unsigned long long bucketValue(unsigned int bucket);
+
+	/**
+	 * Returns the duration below which the supplied fraction of the recorded operations completed.
+	 * @param percentile The fraction, between 0.0 and 100.0
+	 * @return The duration in ns, with the precision of the histogram buckets
+	 */
+	unsigned long long percentile(double percentile) const;
+};
+
+/**
+ * Returns if the tracing hooks were compiled into the library.
+ * @return true if tracing is available, false otherwise
+ */
+bool isTracingAvailable();
+
+/**
+ * Enables or disables the recording of new spans, tracing is enabled by default if it is available.
+ * @param enabled If spans should be recorded
+ */
+void setTracing(bool enabled);
+
+/**
+ * Discards all recorded spans and histograms.
+ * Spans recorded while this function runs might be lost.
+ */
+void resetTrace();
+
+/**
+ * Merges the histograms of all threads for the supplied operation.
+ * @param operation The traced operation
+ * @param histogram The histogram to write the result to
+ * @return true if the histogram was read, false if tracing is not available
+ */
+bool getTraceHistogram(TraceOperation operation, TraceHistogram& histogram);
+
+/**
+ * Writes the merged histogram of the supplied operation as an HdrHistogram percentile distribution (values in us),
+ * which can be plotted by the usual HdrHistogram tools.
+ * @param operation The traced operation
+ * @param fileName The file to write to
+ * @return true if the file was written, false otherwise
+ */
+bool exportTraceHistogram(TraceOperation operation, const std::string& fileName);
+
+/**
+ * Writes the spans still held in the ring buffers of all threads as Chrome trace event JSON,
+ * which can be opened in chrome://tracing or Perfetto.
+ * @param fileName The file to write to
+ * @return true if the file was written, false otherwise
+ */
+bool exportChromeTrace(const std::string& fileName);
+
+}
+
+#endif /* NETSOCKET_TRACE_HPP_ */
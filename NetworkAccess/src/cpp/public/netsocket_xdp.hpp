@@ -0,0 +1,43 @@
+/*
+ * netsocket_xdp.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETSOCKET_XDP_HPP_
+#define NETSOCKET_XDP_HPP_
+
+#include "netsocket.hpp"
+
+/**
+ * AF_XDP kernel bypass for high rate UDP traffic (linux only).
+ */
+
+namespace NetSocket {
+
+/**
+ * Creates a new unbound UDP socket which transfers its datagrams trough an AF_XDP socket on one queue of an network interface.
+ * bind() opens an normal UDP socket on the address (which reserves the port and serves as fallback path) and attaches an XDP program
+ * to the interface, which redirects the UDP packets for the bound address and port into rings shared with this process, bypassing the network stack.
+ * Packets the program does not redirect (other queues, IP options, fragments, IPv6 extension headers, packets larger than an frame)
+ * arrive trough the normal socket, receivefrom() and receivefromBatch() return the datagrams of both paths.
+ * sendto() and sendtoBatch() build the ethernet, IP and UDP headers in user space and use the XDP ring only for peers this socket
+ * already received an packet from on the interface (the ethernet address of the next hop is learned from it), datagrams to other peers
+ * and datagrams which do not fit into the MTU are sent trough the normal socket.
+ * Requires CAP_NET_ADMIN and CAP_BPF (or root) and linux 5.9 or later, only one XDP socket can be bound per interface and
+ * the interface must not have another XDP program attached. Only IPv4 and IPv6 addresses are supported, TCP operations are not supported.
+ * Socket::pollMany() reports EVENT_READ for both paths, but never EVENT_WRITE for this socket.
+ * Only one thread may send and one thread may receive on an socket at the same time.
+ * @param interfaceName The name of the network interface, for example "eth0" or "lo"
+ * @param queue The receive queue of the interface to attach to, packets arriving on other queues take the normal path
+ * @param nativeMode false for generic XDP, which works on every interface (including veth pairs and loopback) but copies each packet,
+ * true to attach the program in the driver, which lets the driver place the packets directly into the shared frames if it supports zero copy
+ * @param frameCount The number of 4 KB frames shared with the kernel, half of them for receiving and half for sending, rounded up to an power of two
+ * @return The new socket
+ */
+NetSocket::Socket* newXdpSocket(const char* interfaceName, unsigned int queue = 0, bool nativeMode = false, unsigned int frameCount = 2048);
+
+}
+
+#endif /* NETSOCKET_XDP_HPP_ */
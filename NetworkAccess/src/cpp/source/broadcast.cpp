@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <algorithm>
+#include "netsocket_broadcast.hpp"
+
+/*
+ * Maximum number of messages passed to one gathered send
+ */
+#define BROADCAST_GATHER_SIZE 64
+
+NetSocket::SharedMessage NetSocket::makeMessage(const char* buffer, unsigned int length) {
+	return std::make_shared<const std::string>(buffer, length);
+}
+
+NetSocket::Broadcaster::Broadcaster(unsigned int queueLimit, LagPolicy policy) {
+	this->queueLimit = queueLimit;
+	this->policy = policy;
+	this->droppedCount = 0;
+}
+
+void NetSocket::Broadcaster::setDisconnectHandler(DisconnectHandler handler) {
+	this->handler = handler;
+}
+
+bool NetSocket::Broadcaster::subscribe(Socket& socket) {
+	if (socket.type() != STREAM || !socket.isOpen()) {
+		printf("tried to call Broadcaster:subscribe() with non connected STREAM socket!\n");
+		return false;
+	}
+	if (this->subscriberMap.count(&socket) != 0)
+		return false;
+	Subscriber& subscriber = this->subscriberMap[&socket];
+	subscriber.offset = 0;
+	subscriber.queuedBytes = 0;
+	subscriber.backlogged = false;
+	return true;
+}
+
+void NetSocket::Broadcaster::unsubscribe(Socket& socket) {
+	auto entry = this->subscriberMap.find(&socket);
+	if (entry == this->subscriberMap.end()) return;
+	if (entry->second.backlogged)
+		this->pending.erase(std::remove(this->pending.begin(), this->pending.end(), &socket), this->pending.end());
+	this->subscriberMap.erase(entry);
+}
+
+unsigned int NetSocket::Broadcaster::subscribers() const {
+	return this->subscriberMap.size();
+}
+
+unsigned long long NetSocket::Broadcaster::dropped() const {
+	return this->droppedCount;
+}
+
+unsigned long long NetSocket::Broadcaster::queued(Socket& socket) const {
+	auto entry = this->subscriberMap.find(&socket);
+	return entry == this->subscriberMap.end() ? 0 : entry->second.queuedBytes;
+}
+
+/*
+ * Appends the message to the queue of an subscriber, dropping messages as the lag policy requires
+ * Returns false if the message was not queued
+ */
+bool NetSocket::Broadcaster::enqueue(Socket* socket, Subscriber& subscriber, const SharedMessage& message) {
+	if (subscriber.queuedBytes + message->size() > this->queueLimit) {
+		if (this->policy == LAG_DISCONNECT) {
+			this->droppedCount++;
+			return false;
+		}
+		if (this->policy == LAG_DROP_OLDEST) {
+			// an partially sent message has to be completed, otherwise the stream would be corrupted
+			unsigned int first = subscriber.offset > 0 ? 1 : 0;
+			while (subscriber.queuedBytes + message->size() > this->queueLimit && subscriber.queue.size() > first) {
+				subscriber.queuedBytes -= subscriber.queue[first]->size();
+				subscriber.queue.erase(subscriber.queue.begin() + first);
+				this->droppedCount++;
+			}
+		}
+		if (subscriber.queuedBytes + message->size() > this->queueLimit) {
+			this->droppedCount++;
+			return false;
+		}
+	}
+
+	subscriber.queue.push_back(message);
+	subscriber.queuedBytes += message->size();
+	if (!subscriber.backlogged) {
+		subscriber.backlogged = true;
+		this->pending.push_back(socket);
+	}
+	return true;
+}
+
+void NetSocket::Broadcaster::publish(const SharedMessage& message) {
+	std::vector<Socket*> laggards;
+	for (auto& entry : this->subscriberMap) {
+		if (!enqueue(entry.first, entry.second, message) && this->policy == LAG_DISCONNECT)
+			laggards.push_back(entry.first);
+	}
+	for (Socket* socket : laggards)
+		disconnect(socket);
+}
+
+bool NetSocket::Broadcaster::send(Socket& socket, const SharedMessage& message) {
+	auto entry = this->subscriberMap.find(&socket);
+	if (entry == this->subscriberMap.end())
+		return false;
+	if (!enqueue(&socket, entry->second, message)) {
+		if (this->policy == LAG_DISCONNECT) disconnect(&socket);
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Sends the queue of an subscriber until it is empty or the send buffer is full
+ * Returns false if sending failed
+ */
+bool NetSocket::Broadcaster::write(Socket* socket, Subscriber& subscriber) {
+	while (!subscriber.queue.empty()) {
+		SendBuffer buffers[BROADCAST_GATHER_SIZE];
+		unsigned int count = 0;
+		for (auto message = subscriber.queue.begin(); message != subscriber.queue.end() && count < BROADCAST_GATHER_SIZE; message++, count++) {
+			unsigned int skip = count == 0 ? subscriber.offset : 0;
+			buffers[count].buffer = (*message)->data() + skip;
+			buffers[count].length = (*message)->size() - skip;
+		}
+
+		unsigned int sent = 0;
+		bool wouldBlock = false;
+		if (!socket->trySendGather(buffers, count, &sent, &wouldBlock))
+			return false;
+
+		subscriber.queuedBytes -= sent;
+		while (!subscriber.queue.empty()) {
+			unsigned int remaining = subscriber.queue.front()->size() - subscriber.offset;
+			if (sent < remaining) {
+				subscriber.offset += sent;
+				break;
+			}
+			sent -= remaining;
+			subscriber.queue.pop_front();
+			subscriber.offset = 0;
+		}
+		if (wouldBlock) break;
+	}
+	return true;
+}
+
+void NetSocket::Broadcaster::disconnect(Socket* socket) {
+	auto entry = this->subscriberMap.find(socket);
+	if (entry == this->subscriberMap.end()) return;
+	this->droppedCount += entry->second.queue.size();
+	unsubscribe(*socket);
+	socket->close();
+	if (this->handler) this->handler(*socket);
+}
+
+unsigned int NetSocket::Broadcaster::flush() {
+	std::vector<Socket*> sockets;
+	sockets.swap(this->pending);
+	std::vector<Socket*> failed;
+	for (Socket* socket : sockets) {
+		auto entry = this->subscriberMap.find(socket);
+		if (entry == this->subscriberMap.end()) continue;
+		Subscriber& subscriber = entry->second;
+		subscriber.backlogged = false;
+		if (!write(socket, subscriber)) {
+			failed.push_back(socket);
+		} else if (!subscriber.queue.empty()) {
+			subscriber.backlogged = true;
+			this->pending.push_back(socket);
+		}
+	}
+	for (Socket* socket : failed)
+		disconnect(socket);
+	return this->pending.size();
+}
+
+bool NetSocket::Broadcaster::flush(Socket& socket) {
+	auto entry = this->subscriberMap.find(&socket);
+	if (entry == this->subscriberMap.end())
+		return false;
+	// the entry in the pending list is left in place, flush() and backlogged() skip subscribers with empty queues
+	if (!write(&socket, entry->second)) {
+		disconnect(&socket);
+		return false;
+	}
+	return entry->second.queue.empty();
+}
+
+unsigned int NetSocket::Broadcaster::backlogged(Socket** sockets, unsigned int capacity) const {
+	unsigned int count = 0;
+	for (Socket* socket : this->pending) {
+		if (count == capacity) break;
+		auto entry = this->subscriberMap.find(socket);
+		if (entry != this->subscriberMap.end() && !entry->second.queue.empty())
+			sockets[count++] = socket;
+	}
+	return count;
+}
@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <string.h>
+#include "netsocket_buffered.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+NetSocket::BufferedWriter::BufferedWriter(Socket& socket, unsigned int flushThreshold, unsigned int highWatermark, unsigned int lowWatermark) : socket(socket) {
+	this->flushThreshold = flushThreshold;
+	this->highWatermark = highWatermark;
+	this->lowWatermark = lowWatermark < highWatermark ? lowWatermark : highWatermark;
+	this->offset = 0;
+	this->writable = true;
+	this->buffer.reserve(flushThreshold);
+}
+
+unsigned int NetSocket::BufferedWriter::pending() const {
+	return this->buffer.size() - this->offset;
+}
+
+bool NetSocket::BufferedWriter::isWritable() const {
+	return this->writable;
+}
+
+void NetSocket::BufferedWriter::setBackpressureHandler(std::function<void(bool writable)> handler) {
+	this->backpressureHandler = handler;
+}
+
+void NetSocket::BufferedWriter::updateWritable() {
+	bool writable = this->writable ? pending() <= this->highWatermark : pending() <= this->lowWatermark;
+	if (writable == this->writable) return;
+	this->writable = writable;
+	if (this->backpressureHandler) this->backpressureHandler(writable);
+}
+
+/*
+ * Sends the buffered data, either until all is sent or until the kernel would block
+ */
+bool NetSocket::BufferedWriter::flushBuffer(bool block) {
+	bool result = true;
+	if (block) {
+		result = pending() == 0 || this->socket.send(this->buffer.data() + this->offset, pending());
+		if (result) this->offset = this->buffer.size();
+	} else {
+		while (pending() > 0) {
+			unsigned int sent = 0;
+			bool wouldBlock = false;
+			if (!this->socket.trySend(this->buffer.data() + this->offset, pending(), &sent, &wouldBlock)) {
+				result = false;
+				break;
+			}
+			this->offset += sent;
+			if (wouldBlock) break;
+		}
+	}
+
+	// compact only when the sent part dominates, so partial flushes do not move the data every time
+	if (this->offset == this->buffer.size()) {
+		this->buffer.clear();
+		this->offset = 0;
+	} else if (this->offset > this->buffer.size() / 2) {
+		this->buffer.erase(this->buffer.begin(), this->buffer.begin() + this->offset);
+		this->offset = 0;
+	}
+
+	updateWritable();
+	return result;
+}
+
+bool NetSocket::BufferedWriter::write(const char* buffer, unsigned int length) {
+	bool blocking = true;
+	this->socket.getBlocking(&blocking);
+
+	if (pending() == 0 && length >= this->flushThreshold) {
+		// large writes gain nothing from the copy
+		if (blocking)
+			return this->socket.send(buffer, length);
+		unsigned int sent = 0;
+		bool wouldBlock = false;
+		if (!this->socket.trySend(buffer, length, &sent, &wouldBlock))
+			return false;
+		buffer += sent;
+		length -= sent;
+	}
+
+	this->buffer.insert(this->buffer.end(), buffer, buffer + length);
+	if (pending() >= this->flushThreshold)
+		return flushBuffer(blocking);
+	updateWritable();
+	return true;
+}
+
+bool NetSocket::BufferedWriter::flush() {
+	return flushBuffer(true);
+}
+
+bool NetSocket::BufferedWriter::tryFlush(bool* drained) {
+	bool result = flushBuffer(false);
+	if (drained != 0) *drained = pending() == 0;
+	return result;
+}
+
+/*
+ * Finds the first occurrence of the delimiter, single bytes use memchr (which is vectorized by the C library),
+ * longer delimiters compare the first and the last delimiter byte for 16 positions at once and verify only the candidates
+ */
+static const char* findDelimiter(const char* data, unsigned int length, const char* delimiter, unsigned int delimiterLength) {
+	if (delimiterLength == 1) return (const char*) memchr(data, delimiter[0], length);
+	if (length < delimiterLength) return 0;
+	unsigned int last = length - delimiterLength; // last possible start of the delimiter
+	unsigned int i = 0;
+#if defined(__SSE2__)
+	const __m128i first = _mm_set1_epi8(delimiter[0]);
+	const __m128i tail = _mm_set1_epi8(delimiter[delimiterLength - 1]);
+	for (; i + 16 <= last + 1; i += 16) {
+		__m128i blockFirst = _mm_loadu_si128((const __m128i*) (data + i));
+		__m128i blockLast = _mm_loadu_si128((const __m128i*) (data + i + delimiterLength - 1));
+		unsigned int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, tail)));
+		while (mask != 0) {
+			unsigned int bit = __builtin_ctz(mask);
+			if (memcmp(data + i + bit + 1, delimiter + 1, delimiterLength - 2) == 0) return data + i + bit;
+			mask &= mask - 1;
+		}
+	}
+#elif defined(__ARM_NEON)
+	const uint8x16_t first = vdupq_n_u8(delimiter[0]);
+	const uint8x16_t tail = vdupq_n_u8(delimiter[delimiterLength - 1]);
+	for (; i + 16 <= last + 1; i += 16) {
+		uint8x16_t blockFirst = vld1q_u8((const uint8_t*) (data + i));
+		uint8x16_t blockLast = vld1q_u8((const uint8_t*) (data + i + delimiterLength - 1));
+		uint8x16_t equal = vandq_u8(vceqq_u8(blockFirst, first), vceqq_u8(blockLast, tail));
+		// narrow each byte to 4 bits to get an 64 bit mask
+		uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(equal), 4)), 0);
+		while (mask != 0) {
+			unsigned int bit = __builtin_ctzll(mask) >> 2;
+			if (memcmp(data + i + bit + 1, delimiter + 1, delimiterLength - 2) == 0) return data + i + bit;
+			mask &= ~(0xFULL << (bit << 2));
+		}
+	}
+#endif
+	for (; i <= last; i++)
+		if (data[i] == delimiter[0] && memcmp(data + i + 1, delimiter + 1, delimiterLength - 1) == 0) return data + i;
+	return 0;
+}
+
+NetSocket::BufferedReader::BufferedReader(Socket& socket, unsigned int capacity) : socket(socket), buffer(capacity) {
+	this->start = 0;
+	this->end = 0;
+	this->scanned = 0;
+	this->closed = false;
+}
+
+unsigned int NetSocket::BufferedReader::available() const {
+	return this->end - this->start;
+}
+
+bool NetSocket::BufferedReader::isClosed() const {
+	return this->closed;
+}
+
+/*
+ * Receives once into the free space at the end of the buffer, moves the buffered data to the front if the end is reached
+ */
+bool NetSocket::BufferedReader::receiveMore() {
+	if (this->end == this->buffer.size()) {
+		if (this->start == 0) return false; // full
+		memmove(this->buffer.data(), this->buffer.data() + this->start, this->end - this->start);
+		this->end -= this->start;
+		this->scanned -= this->start;
+		this->start = 0;
+	}
+
+	unsigned int received = 0;
+	while (received == 0) {
+		if (this->closed || !this->socket.receive(this->buffer.data() + this->end, this->buffer.size() - this->end, &received)) {
+			this->closed = true;
+			return false;
+		}
+		if (received == 0) {
+			bool blocking = true;
+			this->socket.getBlocking(&blocking);
+			if (!blocking) return false; // nothing available yet
+		}
+	}
+	this->end += received;
+	return true;
+}
+
+bool NetSocket::BufferedReader::fill(unsigned int length) {
+	if (length > this->buffer.size()) {
+		printf("tried to call BufferedReader:fill() with length larger than the capacity!\n");
+		return false;
+	}
+	if (this->start + length > this->buffer.size()) {
+		// not enough space behind the data, move it to the front
+		memmove(this->buffer.data(), this->buffer.data() + this->start, this->end - this->start);
+		this->end -= this->start;
+		this->scanned -= this->start;
+		this->start = 0;
+	}
+	while (available() < length)
+		if (!receiveMore()) return false;
+	return true;
+}
+
+bool NetSocket::BufferedReader::peek(unsigned int length, const char** data) {
+	if (!fill(length)) return false;
+	*data = this->buffer.data() + this->start;
+	return true;
+}
+
+void NetSocket::BufferedReader::consume(unsigned int length) {
+	this->start += length < available() ? length : available();
+	if (this->scanned < this->start) this->scanned = this->start;
+	if (this->start == this->end) {
+		this->start = this->end = this->scanned = 0;
+	}
+}
+
+bool NetSocket::BufferedReader::readExact(char* buffer, unsigned int length) {
+	if (length <= this->buffer.size()) {
+		if (!fill(length)) return false;
+		memcpy(buffer, this->buffer.data() + this->start, length);
+		consume(length);
+		return true;
+	}
+
+	// the data received directly can not be put back, so an non blocking read could not return false without consuming anything
+	bool blocking = true;
+	this->socket.getBlocking(&blocking);
+	if (!blocking) {
+		printf("tried to call BufferedReader:readExact() with length larger than the capacity in non blocking mode!\n");
+		return false;
+	}
+
+	// larger than the buffer, copy what is buffered and receive the rest directly
+	unsigned int copied = available();
+	memcpy(buffer, this->buffer.data() + this->start, copied);
+	while (copied < length) {
+		unsigned int received = 0;
+		if (!this->socket.receive(buffer + copied, length - copied, &received)) {
+			this->closed = true;
+			return false; // the partial data is lost with the connection
+		}
+		copied += received;
+	}
+	consume(available());
+	return true;
+}
+
+bool NetSocket::BufferedReader::read(char* buffer, unsigned int length, unsigned int* received) {
+	*received = 0;
+	if (available() == 0) {
+		if (length >= this->buffer.size() && !this->closed) {
+			// nothing to gain from the copy
+			if (!this->socket.receive(buffer, length, received)) this->closed = true;
+			return !this->closed;
+		}
+		if (!receiveMore())
+			return !this->closed;
+	}
+	unsigned int count = length < available() ? length : available();
+	memcpy(buffer, this->buffer.data() + this->start, count);
+	consume(count);
+	*received = count;
+	return true;
+}
+
+bool NetSocket::BufferedReader::readUntil(const char* delimiter, unsigned int delimiterLength, unsigned int maxLength, const char** data, unsigned int* length) {
+	if (maxLength > this->buffer.size()) maxLength = this->buffer.size();
+	if (delimiterLength == 0 || delimiterLength > maxLength) {
+		printf("tried to call BufferedReader:readUntil() with invalid delimiter length!\n");
+		return false;
+	}
+
+	while (true) {
+		// continue where the last search stopped, minus the bytes of an delimiter which might have been cut off
+		unsigned int from = this->scanned > this->start + delimiterLength - 1 ? this->scanned - (delimiterLength - 1) : this->start;
+		unsigned int limit = this->start + maxLength < this->end ? this->start + maxLength : this->end;
+		const char* found = limit > from ? findDelimiter(this->buffer.data() + from, limit - from, delimiter, delimiterLength) : 0;
+		if (found != 0) {
+			*data = this->buffer.data() + this->start;
+			*length = found + delimiterLength - *data;
+			this->start += *length;
+			this->scanned = this->start;
+			// the view has to stay valid, so the buffer is only reset on the next call
+			return true;
+		}
+		this->scanned = limit;
+
+		if (available() >= maxLength) {
+			printf("delimiter not found within %u bytes in BufferedReader:readUntil()!\n", maxLength);
+			return false;
+		}
+		if (this->start + maxLength > this->buffer.size()) {
+			memmove(this->buffer.data(), this->buffer.data() + this->start, this->end - this->start);
+			this->end -= this->start;
+			this->scanned -= this->start;
+			this->start = 0;
+		}
+		if (!receiveMore()) return false;
+	}
+}
@@ -0,0 +1,372 @@
+#include <stdio.h>
+#include <string.h>
+#include "netsocket_compress.hpp"
+
+#ifdef NETSOCKET_LZ4
+#include <lz4.h>
+#endif
+#ifdef NETSOCKET_ZSTD
+#include <zstd.h>
+#endif
+
+/*
+ * Each frame starts with an 8 byte header:
+ * byte 0: codec, the highest bit marks the last frame of an message
+ * byte 1-3: number of message bytes in the frame (little endian)
+ * byte 4-7: number of payload bytes following the header (little endian)
+ */
+#define FRAME_HEADER_LENGTH 8
+#define FRAME_LAST 0x80
+
+/*
+ * Upper bound for the payload of one frame, larger than the worst case expansion of both codecs for one block
+ */
+#define FRAME_PAYLOAD_CAPACITY (COMPRESSION_BLOCK_SIZE + COMPRESSION_BLOCK_SIZE / 128 + 64)
+
+/*
+ * Number of messages compression stays enabled after the kernel send buffer was found full in adaptive mode
+ */
+#define ADAPTIVE_CONGESTION_MESSAGES 64
+
+/*
+ * Maximum number of messages compression is paused for after it did not pay off
+ */
+#define ADAPTIVE_MAX_BACKOFF 64
+
+#if defined(NETSOCKET_LZ4)
+static_assert(LZ4_COMPRESSBOUND(COMPRESSION_BLOCK_SIZE) <= FRAME_PAYLOAD_CAPACITY, "frame capacity below LZ4 bound");
+#endif
+#if defined(NETSOCKET_ZSTD)
+static_assert(ZSTD_COMPRESSBOUND(COMPRESSION_BLOCK_SIZE) + 32 <= FRAME_PAYLOAD_CAPACITY, "frame capacity below zstd bound");
+#endif
+
+static inline void writeHeader(char* header, unsigned int codec, unsigned int originalLength, unsigned int payloadLength) {
+	header[0] = codec;
+	header[1] = originalLength;
+	header[2] = originalLength >> 8;
+	header[3] = originalLength >> 16;
+	header[4] = payloadLength;
+	header[5] = payloadLength >> 8;
+	header[6] = payloadLength >> 16;
+	header[7] = payloadLength >> 24;
+}
+
+static inline unsigned int readLength(const char* bytes, unsigned int count) {
+	unsigned int value = 0;
+	for (unsigned int i = 0; i < count; i++)
+		value |= (unsigned int) (unsigned char) bytes[i] << (i * 8);
+	return value;
+}
+
+NetSocket::CompressedStream::CompressedStream(Socket& socket, const CompressionConfig& config) :
+		socket(socket), reader(socket, FRAME_HEADER_LENGTH + FRAME_PAYLOAD_CAPACITY), frame(FRAME_HEADER_LENGTH + FRAME_PAYLOAD_CAPACITY) {
+	this->sendCodec = config.codec;
+	this->level = config.level;
+	this->dictionary = config.dictionary;
+	this->adaptive = config.adaptive;
+	this->maxMessage = config.maxMessage;
+	this->receiveFailed = false;
+	this->encoder = 0;
+	this->decoderLZ4 = 0;
+	this->decoderZSTD = 0;
+	this->encodeSlot = 0;
+	this->decodeSlot = 0;
+	this->congestion = 0;
+	this->skipRemaining = 0;
+	this->backoff = 0;
+	this->originalCount = 0;
+	this->sentCount = 0;
+
+	switch (this->sendCodec) {
+#ifdef NETSOCKET_LZ4
+	case COMPRESSION_LZ4: {
+		LZ4_stream_t* stream = LZ4_createStream();
+		if (stream == 0) {
+			printf("failed to create LZ4 stream, messages are sent uncompressed!\n");
+			this->sendCodec = COMPRESSION_NONE;
+			break;
+		}
+		if (!this->dictionary.empty())
+			LZ4_loadDict(stream, this->dictionary.data(), this->dictionary.size());
+		this->encodeHistory.resize(2 * COMPRESSION_BLOCK_SIZE);
+		this->encoder = stream;
+		break;
+	}
+#endif
+#ifdef NETSOCKET_ZSTD
+	case COMPRESSION_ZSTD: {
+		ZSTD_CCtx* context = ZSTD_createCCtx();
+		if (context == 0) {
+			printf("failed to create zstd context, messages are sent uncompressed!\n");
+			this->sendCodec = COMPRESSION_NONE;
+			break;
+		}
+		if (this->level != 0)
+			ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, this->level);
+		if (!this->dictionary.empty() && ZSTD_isError(ZSTD_CCtx_loadDictionary(context, this->dictionary.data(), this->dictionary.size())))
+			printf("failed to load zstd dictionary, messages are compressed without it!\n");
+		this->encoder = context;
+		break;
+	}
+#endif
+	case COMPRESSION_NONE:
+		break;
+	default:
+		printf("tried to create CompressedStream with codec %d not available in this build, messages are sent uncompressed!\n", this->sendCodec);
+		this->sendCodec = COMPRESSION_NONE;
+		break;
+	}
+}
+
+NetSocket::CompressedStream::~CompressedStream() {
+#ifdef NETSOCKET_LZ4
+	if (this->sendCodec == COMPRESSION_LZ4) LZ4_freeStream((LZ4_stream_t*) this->encoder);
+	if (this->decoderLZ4 != 0) LZ4_freeStreamDecode((LZ4_streamDecode_t*) this->decoderLZ4);
+#endif
+#ifdef NETSOCKET_ZSTD
+	if (this->sendCodec == COMPRESSION_ZSTD) ZSTD_freeCCtx((ZSTD_CCtx*) this->encoder);
+	if (this->decoderZSTD != 0) ZSTD_freeDCtx((ZSTD_DCtx*) this->decoderZSTD);
+#endif
+}
+
+NetSocket::CompressionCodec NetSocket::CompressedStream::codec() const {
+	return this->sendCodec;
+}
+
+unsigned long long NetSocket::CompressedStream::originalBytes() const {
+	return this->originalCount;
+}
+
+unsigned long long NetSocket::CompressedStream::sentBytes() const {
+	return this->sentCount;
+}
+
+bool NetSocket::CompressedStream::compressBlock(const char* buffer, unsigned int length, char* output, unsigned int* compressed) {
+	switch (this->sendCodec) {
+#ifdef NETSOCKET_LZ4
+	case COMPRESSION_LZ4: {
+		// the previous block has to stay at its location as history, so blocks alternate between two halves of the history buffer
+		char* block = this->encodeHistory.data() + this->encodeSlot * COMPRESSION_BLOCK_SIZE;
+		memcpy(block, buffer, length);
+		int result = LZ4_compress_fast_continue((LZ4_stream_t*) this->encoder, block, output, length, FRAME_PAYLOAD_CAPACITY, this->level > 0 ? this->level : 1);
+		if (result <= 0) {
+			printf("error in CompressedStream:compressBlock:LZ4_compress_fast_continue()\n");
+			return false;
+		}
+		this->encodeSlot ^= 1;
+		*compressed = result;
+		return true;
+	}
+#endif
+#ifdef NETSOCKET_ZSTD
+	case COMPRESSION_ZSTD: {
+		// flushing ends the block without ending the frame, so the window carries over to the next message
+		ZSTD_inBuffer input = { buffer, length, 0 };
+		ZSTD_outBuffer out = { output, FRAME_PAYLOAD_CAPACITY, 0 };
+		size_t remaining;
+		do {
+			remaining = ZSTD_compressStream2((ZSTD_CCtx*) this->encoder, &out, &input, ZSTD_e_flush);
+			if (ZSTD_isError(remaining)) {
+				printf("error in CompressedStream:compressBlock:ZSTD_compressStream2(): %s\n", ZSTD_getErrorName(remaining));
+				return false;
+			}
+		} while (remaining != 0 && out.pos < out.size);
+		if (remaining != 0) {
+			printf("error in CompressedStream:compressBlock:ZSTD_compressStream2(): output exceeds frame capacity\n");
+			return false;
+		}
+		*compressed = out.pos;
+		return true;
+	}
+#endif
+	default:
+#if !defined(NETSOCKET_LZ4) && !defined(NETSOCKET_ZSTD)
+		(void) buffer; (void) length; (void) output; (void) compressed;
+#endif
+		return false;
+	}
+}
+
+bool NetSocket::CompressedStream::decompressBlock(CompressionCodec codec, const char* buffer, unsigned int length, char* output, unsigned int originalLength) {
+	switch (codec) {
+#ifdef NETSOCKET_LZ4
+	case COMPRESSION_LZ4: {
+		if (this->decoderLZ4 == 0) {
+			this->decoderLZ4 = LZ4_createStreamDecode();
+			if (this->decoderLZ4 == 0) {
+				printf("failed to create LZ4 stream decoder!\n");
+				return false;
+			}
+			if (!this->dictionary.empty())
+				LZ4_setStreamDecode((LZ4_streamDecode_t*) this->decoderLZ4, this->dictionary.data(), this->dictionary.size());
+			this->decodeHistory.resize(2 * COMPRESSION_BLOCK_SIZE);
+		}
+		// decoded into the same alternating halves the sender compressed from, so the history matches
+		char* block = this->decodeHistory.data() + this->decodeSlot * COMPRESSION_BLOCK_SIZE;
+		int result = LZ4_decompress_safe_continue((LZ4_streamDecode_t*) this->decoderLZ4, buffer, block, length, COMPRESSION_BLOCK_SIZE);
+		if (result < 0 || (unsigned int) result != originalLength) {
+			printf("error in CompressedStream:decompressBlock:LZ4_decompress_safe_continue(): invalid data\n");
+			return false;
+		}
+		memcpy(output, block, originalLength);
+		this->decodeSlot ^= 1;
+		return true;
+	}
+#endif
+#ifdef NETSOCKET_ZSTD
+	case COMPRESSION_ZSTD: {
+		if (this->decoderZSTD == 0) {
+			this->decoderZSTD = ZSTD_createDCtx();
+			if (this->decoderZSTD == 0) {
+				printf("failed to create zstd decompression context!\n");
+				return false;
+			}
+			if (!this->dictionary.empty() && ZSTD_isError(ZSTD_DCtx_loadDictionary((ZSTD_DCtx*) this->decoderZSTD, this->dictionary.data(), this->dictionary.size())))
+				printf("failed to load zstd dictionary, messages are decompressed without it!\n");
+		}
+		ZSTD_inBuffer input = { buffer, length, 0 };
+		ZSTD_outBuffer out = { output, originalLength, 0 };
+		while (input.pos < input.size || out.pos < out.size) {
+			size_t inputPosition = input.pos;
+			size_t outputPosition = out.pos;
+			size_t result = ZSTD_decompressStream((ZSTD_DCtx*) this->decoderZSTD, &out, &input);
+			if (ZSTD_isError(result)) {
+				printf("error in CompressedStream:decompressBlock:ZSTD_decompressStream(): %s\n", ZSTD_getErrorName(result));
+				return false;
+			}
+			if (input.pos == inputPosition && out.pos == outputPosition) {
+				printf("error in CompressedStream:decompressBlock:ZSTD_decompressStream(): invalid data\n");
+				return false;
+			}
+		}
+		return true;
+	}
+#endif
+	default:
+#if !defined(NETSOCKET_LZ4) && !defined(NETSOCKET_ZSTD)
+		(void) buffer; (void) length; (void) output; (void) originalLength;
+#endif
+		printf("received frame with codec %d not available in this build!\n", codec);
+		return false;
+	}
+}
+
+bool NetSocket::CompressedStream::sendFrame(unsigned int length, bool* blocked) {
+	const char* buffer = this->frame.data();
+	this->sentCount += length;
+
+	// an full kernel send buffer shows that the link and not the CPU limits the throughput
+	unsigned int sent = 0;
+	bool wouldBlock = false;
+	if (!this->socket.trySend(buffer, length, &sent, &wouldBlock))
+		return false;
+	if (!wouldBlock)
+		return true;
+	*blocked = true;
+	return this->socket.send(buffer + sent, length - sent);
+}
+
+bool NetSocket::CompressedStream::sendMessage(const char* buffer, unsigned int length) {
+	this->originalCount += length;
+
+	bool compress = this->sendCodec != COMPRESSION_NONE;
+	if (compress && this->adaptive) {
+		if (this->skipRemaining > 0) {
+			this->skipRemaining--;
+			compress = false;
+		} else if (this->congestion == 0) {
+			compress = false;
+		}
+	}
+
+	unsigned long long compressedLength = 0;
+	unsigned int offset = 0;
+	bool blocked = false;
+	do {
+		unsigned int blockLength = length - offset < COMPRESSION_BLOCK_SIZE ? length - offset : COMPRESSION_BLOCK_SIZE;
+		unsigned int last = offset + blockLength == length ? FRAME_LAST : 0;
+		char* payload = this->frame.data() + FRAME_HEADER_LENGTH;
+		unsigned int payloadLength = blockLength;
+
+		// once compressed the block is part of the codec history, so its output has to be sent even if it is larger
+		if (compress && blockLength > 0) {
+			if (!compressBlock(buffer + offset, blockLength, payload, &payloadLength))
+				return false;
+			writeHeader(this->frame.data(), this->sendCodec | last, blockLength, payloadLength);
+		} else {
+			memcpy(payload, buffer + offset, blockLength);
+			writeHeader(this->frame.data(), COMPRESSION_NONE | last, blockLength, payloadLength);
+		}
+		compressedLength += payloadLength;
+
+		if (!sendFrame(FRAME_HEADER_LENGTH + payloadLength, &blocked))
+			return false;
+		offset += blockLength;
+	} while (offset < length);
+
+	if (blocked)
+		this->congestion = ADAPTIVE_CONGESTION_MESSAGES;
+	else if (this->congestion > 0)
+		this->congestion--;
+
+	if (compress && length > 0) {
+		if (compressedLength * 8 > (unsigned long long) length * 7) {
+			// did not save an eighth, pause for exponentially more messages before probing again
+			this->backoff = this->backoff == 0 ? 1 : this->backoff * 2 > ADAPTIVE_MAX_BACKOFF ? ADAPTIVE_MAX_BACKOFF : this->backoff * 2;
+			this->skipRemaining = this->backoff;
+		} else {
+			this->backoff = 0;
+		}
+	}
+	return true;
+}
+
+bool NetSocket::CompressedStream::receiveMessage(std::vector<char>& message) {
+	if (this->receiveFailed) {
+		printf("tried to call receiveMessage() on stream which received invalid data!\n");
+		return false;
+	}
+
+	unsigned int length = 0;
+	while (true) {
+		const char* header;
+		if (!this->reader.peek(FRAME_HEADER_LENGTH, &header))
+			return false;
+		unsigned int codec = (unsigned char) header[0] & ~FRAME_LAST;
+		bool last = ((unsigned char) header[0] & FRAME_LAST) != 0;
+		unsigned int originalLength = readLength(header + 1, 3);
+		unsigned int payloadLength = readLength(header + 4, 4);
+		if (originalLength > COMPRESSION_BLOCK_SIZE || payloadLength > FRAME_PAYLOAD_CAPACITY ||
+			(codec == COMPRESSION_NONE && payloadLength != originalLength)) {
+			printf("received invalid frame header in CompressedStream:receiveMessage()!\n");
+			this->receiveFailed = true;
+			return false;
+		}
+		if (originalLength > this->maxMessage - length) {
+			printf("received message exceeding maximum size in CompressedStream:receiveMessage()!\n");
+			this->receiveFailed = true;
+			return false;
+		}
+
+		const char* frame;
+		if (!this->reader.peek(FRAME_HEADER_LENGTH + payloadLength, &frame))
+			return false;
+		const char* payload = frame + FRAME_HEADER_LENGTH;
+		if (message.size() < length + originalLength)
+			message.resize(length + originalLength);
+
+		if (codec == COMPRESSION_NONE) {
+			memcpy(message.data() + length, payload, originalLength);
+		} else if (originalLength > 0 && !decompressBlock((CompressionCodec) codec, payload, payloadLength, message.data() + length, originalLength)) {
+			this->receiveFailed = true;
+			return false;
+		}
+		this->reader.consume(FRAME_HEADER_LENGTH + payloadLength);
+		length += originalLength;
+
+		if (last) {
+			message.resize(length);
+			return true;
+		}
+	}
+}
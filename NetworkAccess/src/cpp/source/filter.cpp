@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <string.h>
+#include "netsocket_filter.hpp"
+#include "inetformat.hpp"
+
+/*
+ * Converts an address in network byte order into the two 64 bit words used as trie key, the first address bit becomes the highest bit
+ */
+static inline void toKey(const unsigned char* address, unsigned int length, unsigned long long* key) {
+	key[0] = key[1] = 0;
+	for (unsigned int i = 0; i < length; i++)
+		key[i >> 3] |= (unsigned long long) address[i] << (56 - (i & 7) * 8);
+}
+
+/*
+ * Checks if the first prefix bits of both keys are equal
+ */
+static inline bool prefixMatches(const unsigned long long* a, const unsigned long long* b, unsigned int prefix) {
+	if (prefix == 0) return true;
+	if (prefix <= 64) return ((a[0] ^ b[0]) >> (64 - prefix)) == 0;
+	return a[0] == b[0] && ((a[1] ^ b[1]) >> (128 - prefix)) == 0;
+}
+
+/*
+ * Returns the number of equal leading bits of both keys, at most the limit
+ */
+static inline unsigned int commonPrefix(const unsigned long long* a, const unsigned long long* b, unsigned int limit) {
+	unsigned long long difference = a[0] ^ b[0];
+	unsigned int common = difference != 0 ? __builtin_clzll(difference) : (a[1] ^ b[1]) != 0 ? 64 + __builtin_clzll(a[1] ^ b[1]) : 128;
+	return common < limit ? common : limit;
+}
+
+static inline unsigned int keyBit(const unsigned long long* key, unsigned int bit) {
+	return bit < 64 ? (key[0] >> (63 - bit)) & 1 : (key[1] >> (127 - bit)) & 1;
+}
+
+/*
+ * Clears all bits behind the prefix
+ */
+static inline void maskKey(unsigned long long* key, unsigned int prefix) {
+	if (prefix < 64) {
+		key[0] = prefix == 0 ? 0 : key[0] & (~0ULL << (64 - prefix));
+		key[1] = 0;
+	} else if (prefix < 128) {
+		key[1] = prefix == 64 ? 0 : key[1] & (~0ULL << (128 - prefix));
+	}
+}
+
+/*
+ * IPv4 mapped IPv6 addresses are handled as their IPv4 address
+ */
+static inline bool isMapped(const unsigned char* address, unsigned int length) {
+	static const unsigned char mappedPrefix[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF };
+	return length == 16 && memcmp(address, mappedPrefix, 12) == 0;
+}
+
+bool NetSocket::CIDR::parse(const char* str, unsigned int length) {
+	const char* slash = (const char*) memchr(str, '/', length);
+	unsigned int addressLength = slash != 0 ? slash - str : length;
+	if (parseInet4(str, addressLength, this->address)) {
+		this->length = 4;
+	} else if (parseInet6(str, addressLength, this->address)) {
+		this->length = 16;
+	} else {
+		return false;
+	}
+
+	if (slash == 0) {
+		this->prefix = this->length * 8;
+		return true;
+	}
+	unsigned int digits = length - addressLength - 1;
+	if (digits == 0 || digits > 3 || (digits > 1 && slash[1] == '0')) return false;
+	unsigned int prefix = 0;
+	for (unsigned int i = 1; i <= digits; i++) {
+		if (slash[i] < '0' || slash[i] > '9') return false;
+		prefix = prefix * 10 + (slash[i] - '0');
+	}
+	if (prefix > this->length * 8u) return false;
+	this->prefix = prefix;
+	return true;
+}
+
+bool NetSocket::CIDR::fromaddress(const INetAddress& address, unsigned int prefix) {
+	unsigned int length = 0;
+	unsigned int port = 0;
+	if (!address.tobytes(this->address, &length, &port) || prefix > length * 8) return false;
+	this->length = length;
+	this->prefix = prefix;
+	return true;
+}
+
+bool NetSocket::CIDR::format(char* buffer, unsigned int capacity, unsigned int* length) const {
+	if (capacity < (this->length == 4 ? INET4_FORMAT_LENGTH : INET6_FORMAT_LENGTH) + 5) {
+		printf("tried to call CIDR:format() with too small buffer!\n");
+		return false;
+	}
+	unsigned int position = this->length == 4 ? formatInet4(this->address, buffer) : formatInet6(this->address, buffer);
+	position += snprintf(buffer + position, capacity - position, "/%u", this->prefix);
+	*length = position;
+	return true;
+}
+
+bool NetSocket::CIDR::contains(const INetAddress& address) const {
+	unsigned char bytes[16];
+	unsigned int length = 0;
+	unsigned int port = 0;
+	if (!address.tobytes(bytes, &length, &port)) return false;
+	const unsigned char* compared = bytes;
+	if (this->length == 4 && isMapped(bytes, length)) {
+		compared = bytes + 12;
+		length = 4;
+	}
+	if (length != this->length) return false;
+	unsigned long long key[2], network[2];
+	toKey(compared, length, key);
+	toKey(this->address, this->length, network);
+	return prefixMatches(key, network, this->prefix);
+}
+
+NetSocket::AddressFilter::AddressFilter(bool allowByDefault) {
+	this->allowByDefault = allowByDefault;
+	clear();
+}
+
+void NetSocket::AddressFilter::clear() {
+	this->nodes.clear();
+	this->nodes.push_back(Node()); // placeholder, index zero marks missing nodes
+	this->roots[0] = this->roots[1] = 0;
+}
+
+void NetSocket::AddressFilter::setDefault(bool allowByDefault) {
+	this->allowByDefault = allowByDefault;
+}
+
+unsigned int NetSocket::AddressFilter::createNode(const unsigned long long* key, unsigned int prefix, int action) {
+	Node node;
+	node.key[0] = key[0];
+	node.key[1] = key[1];
+	maskKey(node.key, prefix);
+	node.children[0] = node.children[1] = 0;
+	node.prefix = prefix;
+	node.action = action;
+	this->nodes.push_back(node);
+	return this->nodes.size() - 1;
+}
+
+bool NetSocket::AddressFilter::add(const CIDR& network, bool allow) {
+	if ((network.length != 4 && network.length != 16) || network.prefix > network.length * 8) {
+		printf("tried to call AddressFilter:add() with invalid network!\n");
+		return false;
+	}
+
+	unsigned long long key[2];
+	toKey(network.address, network.length, key);
+	maskKey(key, network.prefix);
+	unsigned int prefix = network.prefix;
+
+	// the link to the current node is tracked as parent and child slot, since adding nodes may move the vector
+	unsigned int parent = 0;
+	unsigned int slot = network.length == 4 ? 0 : 1;
+	while (true) {
+		unsigned int current = parent == 0 ? this->roots[slot] : this->nodes[parent].children[slot];
+		unsigned int inserted;
+
+		if (current == 0) {
+			inserted = createNode(key, prefix, allow);
+		} else {
+			Node& node = this->nodes[current];
+			unsigned int common = commonPrefix(key, node.key, prefix < node.prefix ? prefix : node.prefix);
+			if (common == node.prefix && common == prefix) {
+				node.action = allow;
+				return true;
+			} else if (common == node.prefix) {
+				// the node is an prefix of the network, continue below it
+				parent = current;
+				slot = keyBit(key, node.prefix);
+				continue;
+			} else if (common == prefix) {
+				// the network is an prefix of the node, insert it above
+				unsigned int below = keyBit(node.key, prefix);
+				inserted = createNode(key, prefix, allow);
+				this->nodes[inserted].children[below] = current;
+			} else {
+				// the network and the node differ behind the common prefix, insert an branch node
+				unsigned int below = keyBit(node.key, common);
+				inserted = createNode(key, common, -1);
+				unsigned int leaf = createNode(key, prefix, allow);
+				this->nodes[inserted].children[below] = current;
+				this->nodes[inserted].children[below ^ 1] = leaf;
+			}
+		}
+
+		if (parent == 0)
+			this->roots[slot] = inserted;
+		else
+			this->nodes[parent].children[slot] = inserted;
+		return true;
+	}
+}
+
+bool NetSocket::AddressFilter::remove(const CIDR& network) {
+	if (network.length != 4 && network.length != 16) return false;
+	unsigned long long key[2];
+	toKey(network.address, network.length, key);
+	maskKey(key, network.prefix);
+
+	// the node stays in the trie as branch node, clear() releases the memory
+	unsigned int current = this->roots[network.length == 4 ? 0 : 1];
+	while (current != 0) {
+		Node& node = this->nodes[current];
+		if (node.prefix > network.prefix || !prefixMatches(key, node.key, node.prefix)) return false;
+		if (node.prefix == network.prefix) {
+			bool found = node.action != -1;
+			node.action = -1;
+			return found;
+		}
+		current = node.children[keyBit(key, node.prefix)];
+	}
+	return false;
+}
+
+bool NetSocket::AddressFilter::isAllowed(const unsigned char* address, unsigned int length) const {
+	if (isMapped(address, length)) {
+		address += 12;
+		length = 4;
+	} else if (length != 4 && length != 16) {
+		return this->allowByDefault;
+	}
+
+	unsigned long long key[2];
+	toKey(address, length, key);
+	unsigned int bits = length * 8;
+	int action = -1;
+	unsigned int current = this->roots[length == 4 ? 0 : 1];
+	while (current != 0) {
+		const Node& node = this->nodes[current];
+		if (!prefixMatches(key, node.key, node.prefix)) break;
+		action = node.action != -1 ? node.action : action;
+		if (node.prefix == bits) break;
+		current = node.children[keyBit(key, node.prefix)];
+	}
+	return action == -1 ? this->allowByDefault : action == 1;
+}
+
+bool NetSocket::AddressFilter::isAllowed(const INetAddress& address) const {
+	unsigned char bytes[16];
+	unsigned int length = 0;
+	unsigned int port = 0;
+	if (!address.tobytes(bytes, &length, &port)) return this->allowByDefault;
+	return isAllowed(bytes, length);
+}
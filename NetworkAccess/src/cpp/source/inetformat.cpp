@@ -0,0 +1,272 @@
+#include <string.h>
+#include "inetformat.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Longest text accepted by the parser, INET6_ADDRSTRLEN without the null termination, rounded up to the SIMD width
+ */
+#define INET_PARSE_CAPACITY 48
+
+/*
+ * Per character classification of an address string, bit i of each mask belongs to character i
+ * values holds the decimal or hex digit value of each character (undefined for non digits)
+ */
+struct CharClasses {
+	unsigned long long decimal;
+	unsigned long long hex;
+	unsigned long long colon;
+	unsigned long long dot;
+	unsigned char values[INET_PARSE_CAPACITY];
+};
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+static inline unsigned long long movemask(uint8x16_t mask) {
+	static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	uint8x16_t bits = vandq_u8(mask, vld1q_u8(weights));
+	return vaddv_u8(vget_low_u8(bits)) | (vaddv_u8(vget_high_u8(bits)) << 8);
+}
+#endif
+
+/*
+ * Classifies 16 characters per step, the input is copied into an zero padded buffer so that the loads never read past the string
+ * The capacity is an constant at each call site, so IPv4 parsing only touches one 16 byte block
+ */
+template<unsigned int capacity>
+static inline void classify(const char* str, unsigned int length, CharClasses& classes) {
+	unsigned char padded[capacity];
+	memset(padded, 0, capacity);
+	memcpy(padded, str, length);
+	classes.decimal = classes.hex = classes.colon = classes.dot = 0;
+
+#if defined(__SSE2__)
+	const __m128i zero = _mm_set1_epi8('0');
+	const __m128i nine = _mm_set1_epi8(9);
+	const __m128i lowerCase = _mm_set1_epi8(0x20);
+	const __m128i letterA = _mm_set1_epi8('a');
+	const __m128i five = _mm_set1_epi8(5);
+	const __m128i ten = _mm_set1_epi8(10);
+	const __m128i colon = _mm_set1_epi8(':');
+	const __m128i dot = _mm_set1_epi8('.');
+	for (unsigned int i = 0; i < length; i += 16) {
+		__m128i chars = _mm_loadu_si128((const __m128i*) (padded + i));
+		__m128i decimal = _mm_sub_epi8(chars, zero);
+		__m128i isDecimal = _mm_cmpeq_epi8(_mm_min_epu8(decimal, nine), decimal);
+		__m128i letter = _mm_sub_epi8(_mm_or_si128(chars, lowerCase), letterA);
+		__m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, five), letter);
+		__m128i values = _mm_or_si128(_mm_and_si128(isDecimal, decimal), _mm_and_si128(isLetter, _mm_add_epi8(letter, ten)));
+		_mm_storeu_si128((__m128i*) (classes.values + i), values);
+		classes.decimal |= (unsigned long long) _mm_movemask_epi8(isDecimal) << i;
+		classes.hex |= (unsigned long long) _mm_movemask_epi8(_mm_or_si128(isDecimal, isLetter)) << i;
+		classes.colon |= (unsigned long long) _mm_movemask_epi8(_mm_cmpeq_epi8(chars, colon)) << i;
+		classes.dot |= (unsigned long long) _mm_movemask_epi8(_mm_cmpeq_epi8(chars, dot)) << i;
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	const uint8x16_t zero = vdupq_n_u8('0');
+	const uint8x16_t nine = vdupq_n_u8(9);
+	const uint8x16_t lowerCase = vdupq_n_u8(0x20);
+	const uint8x16_t letterA = vdupq_n_u8('a');
+	const uint8x16_t five = vdupq_n_u8(5);
+	const uint8x16_t ten = vdupq_n_u8(10);
+	const uint8x16_t colon = vdupq_n_u8(':');
+	const uint8x16_t dot = vdupq_n_u8('.');
+	for (unsigned int i = 0; i < length; i += 16) {
+		uint8x16_t chars = vld1q_u8(padded + i);
+		uint8x16_t decimal = vsubq_u8(chars, zero);
+		uint8x16_t isDecimal = vcleq_u8(decimal, nine);
+		uint8x16_t letter = vsubq_u8(vorrq_u8(chars, lowerCase), letterA);
+		uint8x16_t isLetter = vcleq_u8(letter, five);
+		uint8x16_t values = vorrq_u8(vandq_u8(isDecimal, decimal), vandq_u8(isLetter, vaddq_u8(letter, ten)));
+		vst1q_u8(classes.values + i, values);
+		classes.decimal |= movemask(isDecimal) << i;
+		classes.hex |= movemask(vorrq_u8(isDecimal, isLetter)) << i;
+		classes.colon |= movemask(vceqq_u8(chars, colon)) << i;
+		classes.dot |= movemask(vceqq_u8(chars, dot)) << i;
+	}
+#else
+	for (unsigned int i = 0; i < length; i++) {
+		unsigned char decimal = padded[i] - '0';
+		unsigned char letter = (padded[i] | 0x20) - 'a';
+		if (decimal <= 9) {
+			classes.values[i] = decimal;
+			classes.decimal |= 1ULL << i;
+			classes.hex |= 1ULL << i;
+		} else if (letter <= 5) {
+			classes.values[i] = letter + 10;
+			classes.hex |= 1ULL << i;
+		} else if (padded[i] == ':') {
+			classes.colon |= 1ULL << i;
+		} else if (padded[i] == '.') {
+			classes.dot |= 1ULL << i;
+		}
+	}
+#endif
+
+	unsigned long long valid = (1ULL << length) - 1;
+	classes.decimal &= valid;
+	classes.hex &= valid;
+	classes.colon &= valid;
+	classes.dot &= valid;
+}
+
+/*
+ * Returns the index of the first set bit at or after the position, or the length if there is none
+ */
+static inline unsigned int nextBit(unsigned long long mask, unsigned int position, unsigned int length) {
+	mask >>= position;
+	return mask == 0 ? length : position + __builtin_ctzll(mask);
+}
+
+bool parseInet4(const char* str, unsigned int length, unsigned char* address) {
+	if (length < 7 || length > 15) return false;
+	CharClasses classes;
+	classify<16>(str, length, classes);
+	if ((classes.decimal | classes.dot) != (1ULL << length) - 1 || __builtin_popcountll(classes.dot) != 3)
+		return false;
+
+	unsigned int position = 0;
+	for (unsigned int octet = 0; octet < 4; octet++) {
+		unsigned int end = nextBit(classes.dot, position, length);
+		unsigned int digits = end - position;
+		if (digits == 0 || digits > 3 || (digits > 1 && classes.values[position] == 0))
+			return false;
+		unsigned int value = 0;
+		for (unsigned int i = position; i < end; i++)
+			value = value * 10 + classes.values[i];
+		if (value > 255) return false;
+		address[octet] = value;
+		position = end + 1;
+	}
+	return true;
+}
+
+bool parseInet6(const char* str, unsigned int length, unsigned char* address) {
+	if (length < 2 || length > INET_PARSE_CAPACITY - 3) return false;
+	CharClasses classes;
+	classify<INET_PARSE_CAPACITY>(str, length, classes);
+	if ((classes.hex | classes.colon | classes.dot) != (1ULL << length) - 1)
+		return false;
+
+	unsigned short groups[8];
+	unsigned int count = 0;
+	int gap = -1;
+	unsigned int position = 0;
+	if (str[0] == ':') {
+		if (str[1] != ':') return false;
+		gap = 0;
+		position = 2;
+	}
+	while (position < length) {
+		if (count == 8) return false;
+		unsigned int end = nextBit(classes.colon, position, length);
+		if (nextBit(classes.dot, position, length) < end) {
+			// dotted quad in the last 32 bits
+			unsigned char tail[4];
+			if (end != length || count > 6 || !parseInet4(str + position, length - position, tail))
+				return false;
+			groups[count++] = tail[0] << 8 | tail[1];
+			groups[count++] = tail[2] << 8 | tail[3];
+			break;
+		}
+		unsigned int digits = end - position;
+		if (digits == 0 || digits > 4) return false;
+		unsigned int value = 0;
+		for (unsigned int i = position; i < end; i++)
+			value = value << 4 | classes.values[i];
+		groups[count++] = value;
+		if (end == length) break;
+		position = end + 1;
+		if (position == length) return false; // trailing single colon
+		if (str[position] == ':') {
+			if (gap >= 0) return false; // only one "::" allowed
+			gap = count;
+			position++;
+		}
+	}
+
+	if (gap >= 0) {
+		if (count == 8) return false; // "::" has to stand for at least one group
+		unsigned int moved = count - gap;
+		memmove(groups + 8 - moved, groups + gap, moved * sizeof(unsigned short));
+		for (unsigned int i = gap; i < 8 - moved; i++) groups[i] = 0;
+	} else if (count != 8) {
+		return false;
+	}
+	for (unsigned int i = 0; i < 8; i++) {
+		address[i * 2] = groups[i] >> 8;
+		address[i * 2 + 1] = groups[i];
+	}
+	return true;
+}
+
+static inline char* writeDecimal(char* buffer, unsigned int value) {
+	if (value >= 100) {
+		*buffer++ = '0' + value / 100;
+		value %= 100;
+		*buffer++ = '0' + value / 10;
+	} else if (value >= 10) {
+		*buffer++ = '0' + value / 10;
+	}
+	*buffer++ = '0' + value % 10;
+	return buffer;
+}
+
+unsigned int formatInet4(const unsigned char* address, char* buffer) {
+	char* position = buffer;
+	for (unsigned int octet = 0; octet < 4; octet++) {
+		if (octet > 0) *position++ = '.';
+		position = writeDecimal(position, address[octet]);
+	}
+	return position - buffer;
+}
+
+unsigned int formatInet6(const unsigned char* address, char* buffer) {
+	static const char hexDigits[] = "0123456789abcdef";
+	unsigned int groups[8];
+	for (unsigned int i = 0; i < 8; i++)
+		groups[i] = address[i * 2] << 8 | address[i * 2 + 1];
+
+	// the first longest run of at least two zero groups is replaced by "::"
+	int gapStart = -1;
+	int gapLength = 0;
+	for (int i = 0; i < 8;) {
+		if (groups[i] != 0) {
+			i++;
+			continue;
+		}
+		int run = i;
+		while (run < 8 && groups[run] == 0) run++;
+		if (run - i > gapLength) {
+			gapStart = i;
+			gapLength = run - i;
+		}
+		i = run;
+	}
+	if (gapLength < 2) gapStart = -1;
+
+	char* position = buffer;
+	for (int i = 0; i < 8; i++) {
+		if (i == gapStart) {
+			*position++ = ':';
+			i += gapLength - 1;
+			if (i == 7) *position++ = ':';
+			continue;
+		}
+		if (i > 0) *position++ = ':';
+		if (i == 6 && gapStart == 0 && (gapLength == 6 || (gapLength == 5 && groups[5] == 0xFFFF))) {
+			// IPv4 compatible and mapped addresses end in dotted quad notation
+			position += formatInet4(address + 12, position);
+			break;
+		}
+		unsigned int value = groups[i];
+		if (value >= 0x1000) *position++ = hexDigits[value >> 12];
+		if (value >= 0x100) *position++ = hexDigits[(value >> 8) & 0xF];
+		if (value >= 0x10) *position++ = hexDigits[(value >> 4) & 0xF];
+		*position++ = hexDigits[value & 0xF];
+	}
+	return position - buffer;
+}
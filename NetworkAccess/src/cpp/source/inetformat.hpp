@@ -0,0 +1,42 @@
+/*
+ * inetformat.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef INETFORMAT_HPP_
+#define INETFORMAT_HPP_
+
+/*
+ * Allocation free conversion of IPv4 and IPv6 addresses between text and network byte order, used by INetAddress on all platforms
+ * The accepted syntax is the same as inet_pton() and the output the same as inet_ntop() of glibc, but the functions do not print on invalid input
+ */
+
+/*
+ * Maximum number of characters written by formatInet4() and formatInet6()
+ */
+#define INET4_FORMAT_LENGTH 15
+#define INET6_FORMAT_LENGTH 45
+
+/*
+ * Parses an dotted quad IPv4 address, octets with leading zeros are rejected like inet_pton() does
+ */
+bool parseInet4(const char* str, unsigned int length, unsigned char* address);
+
+/*
+ * Parses an IPv6 address in hex notation with optional "::" compression and optional dotted quad in the last 32 bits
+ */
+bool parseInet6(const char* str, unsigned int length, unsigned char* address);
+
+/*
+ * Writes the dotted quad notation without null termination and returns its length
+ */
+unsigned int formatInet4(const unsigned char* address, char* buffer);
+
+/*
+ * Writes the RFC 5952 notation without null termination and returns its length
+ */
+unsigned int formatInet6(const unsigned char* address, char* buffer);
+
+#endif /* INETFORMAT_HPP_ */
@@ -0,0 +1,388 @@
+#ifdef NETSOCKET_JNI
+
+#include <jni.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "netsocket.hpp"
+
+/*
+ * Maximum number of datagrams passed to one receivefromBatch()/sendtoBatch() call
+ */
+#define JNI_BATCH_SIZE 64
+
+/*
+ * Layout of one entry in the metadata buffer of an DatagramBatch (native byte order), has to match DatagramBatch.java
+ */
+#define JNI_ENTRY_SIZE 32
+#define JNI_ENTRY_LENGTH 0
+#define JNI_ENTRY_PORT 4
+#define JNI_ENTRY_ADDRESS_LENGTH 8
+#define JNI_ENTRY_SLOT 12
+#define JNI_ENTRY_ADDRESS 16
+
+/*
+ * Fields of de.m_marvin.netsocket.INetAddress, looked up once in JNI_OnLoad()
+ */
+static jclass addressClass = 0;
+static jmethodID addressInit = 0;
+static jfieldID addressBytes = 0;
+static jfieldID addressLength = 0;
+static jfieldID addressPort = 0;
+
+/*
+ * Per thread address and datagram objects, so the calls do not allocate native memory
+ */
+static thread_local NetSocket::inetaddr scratchAddress;
+static thread_local NetSocket::Datagram scratchDatagrams[JNI_BATCH_SIZE];
+
+/*
+ * Copies an java INetAddress into an native address
+ * Returns false if the java address is not set
+ */
+static bool toNative(JNIEnv* env, jobject address, NetSocket::inetaddr& nativeAddress) {
+	jint length = env->GetIntField(address, addressLength);
+	if (length != 4 && length != 16) {
+		printf("tried to use an INetAddress which is not set!\n");
+		return false;
+	}
+	jbyte bytes[16];
+	jbyteArray array = (jbyteArray) env->GetObjectField(address, addressBytes);
+	env->GetByteArrayRegion(array, 0, length, bytes);
+	env->DeleteLocalRef(array);
+	return nativeAddress.frombytes((const unsigned char*) bytes, length, env->GetIntField(address, addressPort));
+}
+
+/*
+ * Copies an native address into an java INetAddress
+ * Returns false if the native address is not an IPv4 or IPv6 address
+ */
+static bool toJava(JNIEnv* env, const NetSocket::inetaddr& nativeAddress, jobject address) {
+	unsigned char bytes[16];
+	unsigned int length = 0;
+	unsigned int port = 0;
+	if (!nativeAddress.tobytes(bytes, &length, &port))
+		return false;
+	jbyteArray array = (jbyteArray) env->GetObjectField(address, addressBytes);
+	env->SetByteArrayRegion(array, 0, length, (const jbyte*) bytes);
+	env->DeleteLocalRef(array);
+	env->SetIntField(address, addressLength, length);
+	env->SetIntField(address, addressPort, port);
+	return true;
+}
+
+/*
+ * Returns the memory of an direct ByteBuffer, the java side checks that the buffer is direct and the range is within its limit
+ */
+static char* bufferAddress(JNIEnv* env, jobject buffer, jint offset) {
+	char* memory = (char*) env->GetDirectBufferAddress(buffer);
+	return memory == 0 ? 0 : memory + offset;
+}
+
+static inline NetSocket::Socket* socketOf(jlong pointer) {
+	return (NetSocket::Socket*) (intptr_t) pointer;
+}
+
+// de.m_marvin.netsocket.Socket
+
+static jlong JNICALL newSocket0(JNIEnv*, jclass) {
+	return (jlong) (intptr_t) NetSocket::newSocket();
+}
+
+static void JNICALL free0(JNIEnv*, jclass, jlong pointer) {
+	delete socketOf(pointer);
+}
+
+static void JNICALL close0(JNIEnv*, jclass, jlong pointer) {
+	socketOf(pointer)->close();
+}
+
+static jboolean JNICALL isOpen0(JNIEnv*, jclass, jlong pointer) {
+	return socketOf(pointer)->isOpen();
+}
+
+static jint JNICALL type0(JNIEnv*, jclass, jlong pointer) {
+	return socketOf(pointer)->type();
+}
+
+static jboolean JNICALL setBlocking0(JNIEnv*, jclass, jlong pointer, jboolean blocking) {
+	return socketOf(pointer)->setBlocking(blocking);
+}
+
+static jboolean JNICALL setNagle0(JNIEnv*, jclass, jlong pointer, jboolean enableBuffering) {
+	return socketOf(pointer)->setNagle(enableBuffering);
+}
+
+static jboolean JNICALL getINet0(JNIEnv* env, jclass, jlong pointer, jobject address) {
+	if (!socketOf(pointer)->getINet(scratchAddress)) return false;
+	return toJava(env, scratchAddress, address);
+}
+
+static jboolean JNICALL listen0(JNIEnv* env, jclass, jlong pointer, jobject address) {
+	if (!toNative(env, address, scratchAddress)) return false;
+	return socketOf(pointer)->listen(scratchAddress);
+}
+
+static jboolean JNICALL bind0(JNIEnv* env, jclass, jlong pointer, jobject address) {
+	if (!toNative(env, address, scratchAddress)) return false;
+	return socketOf(pointer)->bind(scratchAddress);
+}
+
+static jboolean JNICALL connect0(JNIEnv* env, jclass, jlong pointer, jobject address, jlong timeout) {
+	if (!toNative(env, address, scratchAddress)) return false;
+	return socketOf(pointer)->connect(scratchAddress, timeout);
+}
+
+static jboolean JNICALL accept0(JNIEnv*, jclass, jlong pointer, jlong clientPointer) {
+	return socketOf(pointer)->accept(*socketOf(clientPointer));
+}
+
+static jboolean JNICALL send0(JNIEnv* env, jclass, jlong pointer, jobject buffer, jint offset, jint length) {
+	const char* memory = bufferAddress(env, buffer, offset);
+	if (memory == 0) return false;
+	return socketOf(pointer)->send(memory, length);
+}
+
+static jint JNICALL receive0(JNIEnv* env, jclass, jlong pointer, jobject buffer, jint offset, jint length) {
+	char* memory = bufferAddress(env, buffer, offset);
+	if (memory == 0) return -1;
+	unsigned int received = 0;
+	if (!socketOf(pointer)->receive(memory, length, &received)) return -1;
+	return received;
+}
+
+static jint JNICALL trySend0(JNIEnv* env, jclass, jlong pointer, jobject buffer, jint offset, jint length) {
+	const char* memory = bufferAddress(env, buffer, offset);
+	if (memory == 0) return -1;
+	unsigned int sent = 0;
+	bool wouldBlock = false;
+	if (!socketOf(pointer)->trySend(memory, length, &sent, &wouldBlock)) return -1;
+	return sent;
+}
+
+static jint JNICALL tryReceive0(JNIEnv* env, jclass, jlong pointer, jobject buffer, jint offset, jint length) {
+	char* memory = bufferAddress(env, buffer, offset);
+	if (memory == 0) return -1;
+	unsigned int received = 0;
+	bool wouldBlock = false;
+	if (!socketOf(pointer)->tryReceive(memory, length, &received, &wouldBlock)) return -1;
+	return received;
+}
+
+static jint JNICALL trySendGather0(JNIEnv* env, jclass, jlong pointer, jobjectArray buffers, jintArray ranges, jint count) {
+	NetSocket::SendBuffer gather[JNI_BATCH_SIZE];
+	jint range[JNI_BATCH_SIZE * 2];
+	if (count > JNI_BATCH_SIZE) count = JNI_BATCH_SIZE;
+	env->GetIntArrayRegion(ranges, 0, count * 2, range);
+	for (jint i = 0; i < count; i++) {
+		jobject buffer = env->GetObjectArrayElement(buffers, i);
+		gather[i].buffer = bufferAddress(env, buffer, range[i * 2]);
+		gather[i].length = range[i * 2 + 1];
+		env->DeleteLocalRef(buffer);
+		if (gather[i].buffer == 0) return -1;
+	}
+	unsigned int sent = 0;
+	bool wouldBlock = false;
+	if (!socketOf(pointer)->trySendGather(gather, count, &sent, &wouldBlock)) return -1;
+	return sent;
+}
+
+static jboolean JNICALL sendto0(JNIEnv* env, jclass, jlong pointer, jobject address, jobject buffer, jint offset, jint length) {
+	const char* memory = bufferAddress(env, buffer, offset);
+	if (memory == 0 || !toNative(env, address, scratchAddress)) return false;
+	return socketOf(pointer)->sendto(scratchAddress, memory, length);
+}
+
+static jint JNICALL receivefrom0(JNIEnv* env, jclass, jlong pointer, jobject address, jobject buffer, jint offset, jint length) {
+	char* memory = bufferAddress(env, buffer, offset);
+	if (memory == 0) return -1;
+	unsigned int received = 0;
+	if (!socketOf(pointer)->receivefrom(scratchAddress, memory, length, &received)) return -1;
+	if (received > 0) toJava(env, scratchAddress, address);
+	return received;
+}
+
+static jint JNICALL sendtoBatch0(JNIEnv* env, jclass, jlong pointer, jobject payload, jobject metadata, jint slotSize, jint count) {
+	char* memory = bufferAddress(env, payload, 0);
+	unsigned char* entries = (unsigned char*) bufferAddress(env, metadata, 0);
+	if (memory == 0 || entries == 0) return -1;
+	NetSocket::Socket* socket = socketOf(pointer);
+
+	jint total = 0;
+	while (total < count) {
+		unsigned int batch = 0;
+		for (; batch < JNI_BATCH_SIZE && total + (jint) batch < count; batch++) {
+			const unsigned char* entry = entries + (total + batch) * JNI_ENTRY_SIZE;
+			NetSocket::Datagram& datagram = scratchDatagrams[batch];
+			datagram.buffer = memory + (total + batch) * slotSize;
+			datagram.length = *(const jint*) (entry + JNI_ENTRY_LENGTH);
+			if (!datagram.address.frombytes(entry + JNI_ENTRY_ADDRESS, *(const jint*) (entry + JNI_ENTRY_ADDRESS_LENGTH), *(const jint*) (entry + JNI_ENTRY_PORT))) {
+				printf("tried to call Socket:sendtoBatch() with datagram without address!\n");
+				return total > 0 ? total : -1;
+			}
+		}
+		unsigned int sent = 0;
+		if (!socket->sendtoBatch(scratchDatagrams, batch, &sent))
+			return total > 0 ? total : -1;
+		total += sent;
+		if (sent < batch) break; // send buffer full
+	}
+	return total;
+}
+
+static jint JNICALL receivefromBatch0(JNIEnv* env, jclass, jlong pointer, jobject payload, jobject metadata, jint slotSize, jint count) {
+	char* memory = bufferAddress(env, payload, 0);
+	unsigned char* entries = (unsigned char*) bufferAddress(env, metadata, 0);
+	if (memory == 0 || entries == 0) return -1;
+	if (count > JNI_BATCH_SIZE) count = JNI_BATCH_SIZE;
+	for (jint i = 0; i < count; i++) {
+		scratchDatagrams[i].buffer = memory + i * slotSize;
+		scratchDatagrams[i].length = slotSize;
+	}
+
+	unsigned int received = 0;
+	if (!socketOf(pointer)->receivefromBatch(scratchDatagrams, count, &received))
+		return -1;
+
+	for (unsigned int i = 0; i < received; i++) {
+		const NetSocket::Datagram& datagram = scratchDatagrams[i];
+		unsigned char* entry = entries + i * JNI_ENTRY_SIZE;
+		unsigned int length = 0;
+		unsigned int port = 0;
+		if (!datagram.address.tobytes(entry + JNI_ENTRY_ADDRESS, &length, &port)) length = port = 0;
+		*(jint*) (entry + JNI_ENTRY_LENGTH) = datagram.received;
+		*(jint*) (entry + JNI_ENTRY_PORT) = port;
+		*(jint*) (entry + JNI_ENTRY_ADDRESS_LENGTH) = length;
+		// an address filter swaps datagrams including their buffers, so the slot is not necessarily the entry index
+		*(jint*) (entry + JNI_ENTRY_SLOT) = (datagram.buffer - memory) / slotSize;
+	}
+	return received;
+}
+
+// de.m_marvin.netsocket.INetAddress
+
+static jboolean JNICALL parse0(JNIEnv* env, jclass, jobject address, jstring text, jint port) {
+	const char* chars = env->GetStringUTFChars(text, 0);
+	if (chars == 0) return false;
+	bool parsed = scratchAddress.parse(chars, strlen(chars), port);
+	env->ReleaseStringUTFChars(text, chars);
+	return parsed && toJava(env, scratchAddress, address);
+}
+
+static jstring JNICALL format0(JNIEnv* env, jclass, jobject address) {
+	if (!toNative(env, address, scratchAddress)) return 0;
+	char buffer[INET_ADDRESS_LENGTH];
+	unsigned int length = 0;
+	unsigned int port = 0;
+	if (!scratchAddress.format(buffer, sizeof(buffer), &length, &port)) return 0;
+	return env->NewStringUTF(buffer);
+}
+
+// de.m_marvin.netsocket.NetSocket
+
+static jobjectArray JNICALL resolveInet0(JNIEnv* env, jclass, jstring host, jstring port, jboolean lookForUDP) {
+	const char* hostChars = env->GetStringUTFChars(host, 0);
+	const char* portChars = env->GetStringUTFChars(port, 0);
+	std::vector<NetSocket::inetaddr> addresses;
+	bool resolved = hostChars != 0 && portChars != 0 && NetSocket::resolveInet(hostChars, portChars, lookForUDP, addresses);
+	if (hostChars != 0) env->ReleaseStringUTFChars(host, hostChars);
+	if (portChars != 0) env->ReleaseStringUTFChars(port, portChars);
+	if (!resolved) return 0;
+
+	// unix addresses can not be represented on the java side and are skipped
+	std::vector<jobject> results;
+	for (NetSocket::inetaddr& address : addresses) {
+		jobject result = env->NewObject(addressClass, addressInit);
+		if (result == 0) return 0;
+		if (toJava(env, address, result))
+			results.push_back(result);
+		else
+			env->DeleteLocalRef(result);
+	}
+	jobjectArray array = env->NewObjectArray(results.size(), addressClass, 0);
+	if (array == 0) return 0;
+	for (unsigned int i = 0; i < results.size(); i++)
+		env->SetObjectArrayElement(array, i, results[i]);
+	return array;
+}
+
+static const JNINativeMethod socketMethods[] = {
+	{ (char*) "newSocket0", (char*) "()J", (void*) newSocket0 },
+	{ (char*) "free0", (char*) "(J)V", (void*) free0 },
+	{ (char*) "close0", (char*) "(J)V", (void*) close0 },
+	{ (char*) "isOpen0", (char*) "(J)Z", (void*) isOpen0 },
+	{ (char*) "type0", (char*) "(J)I", (void*) type0 },
+	{ (char*) "setBlocking0", (char*) "(JZ)Z", (void*) setBlocking0 },
+	{ (char*) "setNagle0", (char*) "(JZ)Z", (void*) setNagle0 },
+	{ (char*) "getINet0", (char*) "(JLde/m_marvin/netsocket/INetAddress;)Z", (void*) getINet0 },
+	{ (char*) "listen0", (char*) "(JLde/m_marvin/netsocket/INetAddress;)Z", (void*) listen0 },
+	{ (char*) "bind0", (char*) "(JLde/m_marvin/netsocket/INetAddress;)Z", (void*) bind0 },
+	{ (char*) "connect0", (char*) "(JLde/m_marvin/netsocket/INetAddress;J)Z", (void*) connect0 },
+	{ (char*) "accept0", (char*) "(JJ)Z", (void*) accept0 },
+	{ (char*) "send0", (char*) "(JLjava/nio/ByteBuffer;II)Z", (void*) send0 },
+	{ (char*) "receive0", (char*) "(JLjava/nio/ByteBuffer;II)I", (void*) receive0 },
+	{ (char*) "trySend0", (char*) "(JLjava/nio/ByteBuffer;II)I", (void*) trySend0 },
+	{ (char*) "tryReceive0", (char*) "(JLjava/nio/ByteBuffer;II)I", (void*) tryReceive0 },
+	{ (char*) "trySendGather0", (char*) "(J[Ljava/nio/ByteBuffer;[II)I", (void*) trySendGather0 },
+	{ (char*) "sendto0", (char*) "(JLde/m_marvin/netsocket/INetAddress;Ljava/nio/ByteBuffer;II)Z", (void*) sendto0 },
+	{ (char*) "receivefrom0", (char*) "(JLde/m_marvin/netsocket/INetAddress;Ljava/nio/ByteBuffer;II)I", (void*) receivefrom0 },
+	{ (char*) "sendtoBatch0", (char*) "(JLjava/nio/ByteBuffer;Ljava/nio/ByteBuffer;II)I", (void*) sendtoBatch0 },
+	{ (char*) "receivefromBatch0", (char*) "(JLjava/nio/ByteBuffer;Ljava/nio/ByteBuffer;II)I", (void*) receivefromBatch0 }
+};
+
+static const JNINativeMethod addressMethods[] = {
+	{ (char*) "parse0", (char*) "(Lde/m_marvin/netsocket/INetAddress;Ljava/lang/String;I)Z", (void*) parse0 },
+	{ (char*) "format0", (char*) "(Lde/m_marvin/netsocket/INetAddress;)Ljava/lang/String;", (void*) format0 }
+};
+
+static const JNINativeMethod netSocketMethods[] = {
+	{ (char*) "resolveInet0", (char*) "(Ljava/lang/String;Ljava/lang/String;Z)[Lde/m_marvin/netsocket/INetAddress;", (void*) resolveInet0 }
+};
+
+/*
+ * Registers the native methods of an java class
+ * Returns false if the class or one of the methods was not found
+ */
+static bool registerMethods(JNIEnv* env, const char* className, const JNINativeMethod* methods, jint count) {
+	jclass clazz = env->FindClass(className);
+	if (clazz == 0) return false;
+	bool registered = env->RegisterNatives(clazz, methods, count) == 0;
+	env->DeleteLocalRef(clazz);
+	return registered;
+}
+
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void*) {
+	JNIEnv* env = 0;
+	if (vm->GetEnv((void**) &env, JNI_VERSION_1_6) != JNI_OK)
+		return JNI_ERR;
+
+	jclass clazz = env->FindClass("de/m_marvin/netsocket/INetAddress");
+	if (clazz == 0) return JNI_ERR;
+	addressClass = (jclass) env->NewGlobalRef(clazz);
+	env->DeleteLocalRef(clazz);
+	addressInit = env->GetMethodID(addressClass, "<init>", "()V");
+	addressBytes = env->GetFieldID(addressClass, "address", "[B");
+	addressLength = env->GetFieldID(addressClass, "length", "I");
+	addressPort = env->GetFieldID(addressClass, "port", "I");
+	if (addressInit == 0 || addressBytes == 0 || addressLength == 0 || addressPort == 0)
+		return JNI_ERR;
+
+	if (!registerMethods(env, "de/m_marvin/netsocket/Socket", socketMethods, sizeof(socketMethods) / sizeof(JNINativeMethod)) ||
+		!registerMethods(env, "de/m_marvin/netsocket/INetAddress", addressMethods, sizeof(addressMethods) / sizeof(JNINativeMethod)) ||
+		!registerMethods(env, "de/m_marvin/netsocket/NetSocket", netSocketMethods, sizeof(netSocketMethods) / sizeof(JNINativeMethod)))
+		return JNI_ERR;
+
+	if (!NetSocket::InetInit())
+		return JNI_ERR;
+	return JNI_VERSION_1_6;
+}
+
+JNIEXPORT void JNICALL JNI_OnUnload(JavaVM* vm, void*) {
+	NetSocket::InetCleanup();
+	JNIEnv* env = 0;
+	if (vm->GetEnv((void**) &env, JNI_VERSION_1_6) == JNI_OK && addressClass != 0)
+		env->DeleteGlobalRef(addressClass);
+	addressClass = 0;
+}
+
+#endif
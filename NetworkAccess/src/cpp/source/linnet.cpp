@@ -1,24 +1,9 @@
 #ifdef PLATFORM_LIN
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <sys/types.h>
-#include <sys/socket.h>
-#include <poll.h>
-#include <arpa/inet.h>
-#include <netinet/in.h>
-#include <netdb.h>
-#include <unistd.h>
-#include <fcntl.h>
-#include <netinet/tcp.h>
-#include "netsocket.hpp"
-
-/*
- * On linux read functions may never return if the socket is closed or other special conditions occur
- * So we have to define an timeout and use poll() to wait for read-readiness on the socket
- */
-#define READ_SOCKET_TIMEOUT 2000
+#include <typeinfo>
+#include "linnet.hpp"
+#include "netsocket_native.hpp"
+#include "netsocket_handle.hpp"
 
 bool NetSocket::InetInit() {
 	return true;
@@ -32,12 +17,6 @@ void printError(const char* format) {
 	printf(format, errorCode, strerror(errorCode));
 }
 
-typedef union {
-		sockaddr sockaddrU;
-		sockaddr_in sockaddr4;
-		sockaddr_in6 sockaddr6;
-} addr_t;
-
 NetSocket::INetAddress::INetAddress() {
 	this->addr = new addr_t;
 }
@@ -64,6 +43,8 @@ int NetSocket::INetAddress::compare(const INetAddress& other) const {
 		return i;
 	} else if (((addr_t*) this->addr)->sockaddrU.sa_family == AF_INET6) {
 		return memcmp(&((addr_t*) this->addr)->sockaddr6, &((addr_t*) other.addr)->sockaddr6, sizeof(sockaddr_in6));
+	} else if (((addr_t*) this->addr)->sockaddrU.sa_family == AF_UNIX) {
+		return memcmp(&((addr_t*) this->addr)->sockaddrUn, &((addr_t*) other.addr)->sockaddrUn, sizeof(sockaddr_un));
 	} else {
 		return memcmp(&((addr_t*) this->addr)->sockaddr4, &((addr_t*) other.addr)->sockaddr4, sizeof(sockaddr_in));
 	}
@@ -81,46 +62,126 @@ bool NetSocket::INetAddress::operator==(const NetSocket::INetAddress& other) con
 	return compare(other) == 0;
 }
 
+bool NetSocket::INetAddress::parse(const char* addressStr, unsigned int length, unsigned int port) {
+	addr_t* address = (addr_t*) this->addr;
+	if (parseInet4(addressStr, length, (unsigned char*) &address->sockaddr4.sin_addr)) {
+		address->sockaddr4.sin_family = AF_INET;
+		address->sockaddr4.sin_port = htons(port);
+		memset(address->sockaddr4.sin_zero, 0, sizeof(address->sockaddr4.sin_zero));
+		return true;
+	} else if (parseInet6(addressStr, length, (unsigned char*) &address->sockaddr6.sin6_addr)) {
+		address->sockaddr6.sin6_family = AF_INET6;
+		address->sockaddr6.sin6_port = htons(port);
+		address->sockaddr6.sin6_flowinfo = 0;
+		address->sockaddr6.sin6_scope_id = 0;
+		return true;
+	}
+	return false;
+}
+
 bool NetSocket::INetAddress::fromstr(std::string& addressStr, unsigned int port) {
-	if (inet_pton(AF_INET, addressStr.c_str(), &((addr_t*) this->addr)->sockaddr4.sin_addr) == 1) {
-		((addr_t*) this->addr)->sockaddr4.sin_family = AF_INET;
-		((addr_t*) this->addr)->sockaddr4.sin_port = htons(port);
+	if (!parse(addressStr.c_str(), addressStr.length(), port)) {
+		printf("INetAddress:fromstr() failed for AF_INET and AF_INET6!\n");
+		return false;
+	}
+	return true;
+}
+
+bool NetSocket::INetAddress::frombytes(const unsigned char* bytes, unsigned int length, unsigned int port) {
+	addr_t* address = (addr_t*) this->addr;
+	if (length == 4) {
+		memset(&address->sockaddr4, 0, sizeof(sockaddr_in));
+		address->sockaddr4.sin_family = AF_INET;
+		address->sockaddr4.sin_port = htons(port);
+		memcpy(&address->sockaddr4.sin_addr, bytes, 4);
 		return true;
-	} else if (inet_pton(AF_INET6, addressStr.c_str(), &((addr_t*) this->addr)->sockaddr6.sin6_addr) == 1) {
-		((addr_t*) this->addr)->sockaddr6.sin6_family = AF_INET6;
-		((addr_t*) this->addr)->sockaddr6.sin6_port = htons(port);
+	} else if (length == 16) {
+		memset(&address->sockaddr6, 0, sizeof(sockaddr_in6));
+		address->sockaddr6.sin6_family = AF_INET6;
+		address->sockaddr6.sin6_port = htons(port);
+		memcpy(&address->sockaddr6.sin6_addr, bytes, 16);
 		return true;
-	} else {
-		printf("INetAddress:fromstr:inet_pton() failed for AF_INET and AF_INET6!\n");
+	}
+	printf("INetAddress:frombytes() with length other than 4 or 16 bytes!\n");
+	return false;
+}
+
+bool NetSocket::INetAddress::tobytes(unsigned char* bytes, unsigned int* length, unsigned int* port) const {
+	const addr_t* address = (addr_t*) this->addr;
+	if (address->sockaddrU.sa_family == AF_INET) {
+		memcpy(bytes, &address->sockaddr4.sin_addr, 4);
+		*length = 4;
+		*port = ntohs(address->sockaddr4.sin_port);
+		return true;
+	} else if (address->sockaddrU.sa_family == AF_INET6) {
+		memcpy(bytes, &address->sockaddr6.sin6_addr, 16);
+		*length = 16;
+		*port = ntohs(address->sockaddr6.sin6_port);
+		return true;
+	}
+	return false;
+}
+
+bool NetSocket::INetAddress::fromunix(const std::string& path) {
+	sockaddr_un* address = &((addr_t*) this->addr)->sockaddrUn;
+	if (path.empty() || path.length() >= sizeof(address->sun_path)) {
+		printf("INetAddress:fromunix() with empty or too long path!\n");
 		return false;
 	}
+	memset(address, 0, sizeof(sockaddr_un));
+	address->sun_family = AF_UNIX;
+	memcpy(address->sun_path, path.c_str(), path.length());
+	if (path[0] == '@')
+		address->sun_path[0] = '\0'; // abstract namespace
+	return true;
 }
 
-bool NetSocket::INetAddress::tostr(std::string& addressStr, unsigned int* port) const {
-	if (((addr_t*) this->addr)->sockaddrU.sa_family == AF_INET) {
-		char addrStr[INET_ADDRSTRLEN];
-		if (inet_ntop(AF_INET, &((addr_t*) this->addr)->sockaddr4.sin_addr, addrStr, INET_ADDRSTRLEN) == 0) {
-			printError("error %d in INetAddress:tostr:inet_ntop(): %s\n");
+bool NetSocket::INetAddress::format(char* buffer, unsigned int capacity, unsigned int* length, unsigned int* port) const {
+	const addr_t* address = (addr_t*) this->addr;
+	if (address->sockaddrU.sa_family == AF_INET || address->sockaddrU.sa_family == AF_INET6) {
+		bool inet4 = address->sockaddrU.sa_family == AF_INET;
+		if (capacity < (inet4 ? INET4_FORMAT_LENGTH : INET6_FORMAT_LENGTH) + 1) {
+			printf("tried to call INetAddress:format() with too small buffer!\n");
 			return false;
 		}
-		*port = htons(((addr_t*) this->addr)->sockaddr4.sin_port);
-		addressStr = std::string(addrStr);
-		return true;
-	} else if (((addr_t*) this->addr)->sockaddrU.sa_family == AF_INET6) {
-		char addrStr[INET6_ADDRSTRLEN];
-		if (inet_ntop(((addr_t*) this->addr)->sockaddr6.sin6_family, &((addr_t*) this->addr)->sockaddr6.sin6_addr, addrStr, INET6_ADDRSTRLEN) == 0) {
-			printError("error %d in INetAddress:tostr:inet_ntop(): %s\n");
-			return false;
+		if (inet4) {
+			*length = formatInet4((const unsigned char*) &address->sockaddr4.sin_addr, buffer);
+			*port = ntohs(address->sockaddr4.sin_port);
+		} else {
+			*length = formatInet6((const unsigned char*) &address->sockaddr6.sin6_addr, buffer);
+			*port = ntohs(address->sockaddr6.sin6_port);
 		}
-		*port = htons(((addr_t*) this->addr)->sockaddr6.sin6_port);
-		addressStr = std::string(addrStr);
+		buffer[*length] = '\0';
+		return true;
+	} else if (address->sockaddrU.sa_family == AF_UNIX) {
+		const sockaddr_un* unixAddress = &address->sockaddrUn;
+		bool abstract = unixAddress->sun_path[0] == '\0';
+		unsigned int pathLength = abstract ? strnlen(unixAddress->sun_path + 1, sizeof(unixAddress->sun_path) - 1) + 1 : strnlen(unixAddress->sun_path, sizeof(unixAddress->sun_path));
+		if (capacity < pathLength + 1) {
+			printf("tried to call INetAddress:format() with too small buffer!\n");
+			return false;
+		}
+		memcpy(buffer, unixAddress->sun_path, pathLength);
+		if (abstract) buffer[0] = '@';
+		buffer[pathLength] = '\0';
+		*length = pathLength;
+		*port = 0;
 		return true;
 	} else {
-		printf("INetAddress:tostr:str_to_inet() with non AF_INET or AF_INET6 address!\n");
+		printf("INetAddress:format() with non AF_INET, AF_INET6 or AF_UNIX address!\n");
 		return false;
 	}
 }
 
+bool NetSocket::INetAddress::tostr(std::string& addressStr, unsigned int* port) const {
+	char buffer[sizeof(sockaddr_un::sun_path) + 1];
+	unsigned int length = 0;
+	if (!format(buffer, sizeof(buffer), &length, port))
+		return false;
+	addressStr.assign(buffer, length);
+	return true;
+}
+
 bool NetSocket::resolveInet(const std::string& hostStr, const std::string& portStr, bool lookForUDP, std::vector<NetSocket::INetAddress>& addresses) {
 
 	struct addrinfo hints {0};
@@ -147,419 +208,392 @@ bool NetSocket::resolveInet(const std::string& hostStr, const std::string& portS
 	return true;
 }
 
-class SocketLin : public NetSocket::Socket {
-
-public:
-	NetSocket::SocketType stype;
-	int handle;
-	struct pollfd pollfd;
-	unsigned short addrType;
+NetSocket::Socket* NetSocket::newSocket() {
+	return new SocketLin();
+}
 
-	SocketLin() {
-		this->stype = NetSocket::UNBOUND;
-		this->handle = -1;
-		this->addrType = 0;
+bool NetSocket::NativeSocket::attach(Socket& socket) {
+	// derived sockets (TLS) do not transfer their data directly trough the handle
+	if (typeid(socket) != typeid(SocketLin)) {
+		printf("tried to call NativeSocket:attach() with non platform socket!\n");
+		return false;
 	}
+	SocketLin& platformSocket = (SocketLin&) socket;
+	this->target = &socket;
+	this->handle = &platformSocket.handle;
+	this->stype = &platformSocket.stype;
+	this->family = &platformSocket.addrType;
+	this->filter = &platformSocket.filter;
+	return true;
+}
 
-	~SocketLin() override {
-		if (this->stype != NetSocket::UNBOUND) {
-			close();
-		}
+bool NetSocket::SocketHandle::accept(Socket& listenSocket) {
+	if (isOpen()) {
+		printf("tried to call SocketHandle:accept() on open handle!\n");
+		return false;
 	}
-
-	NetSocket::SocketType type() override {
-		return this->stype;
+	if (typeid(listenSocket) != typeid(SocketLin)) {
+		printf("tried to call SocketHandle:accept() with non platform socket!\n");
+		return false;
 	}
+	SocketLin socket;
+	return listenSocket.accept(socket) && adopt(socket);
+}
 
-	int lastError() override {
-		return errno;
+bool NetSocket::SocketHandle::connect(const INetAddress& address, unsigned long timeout) {
+	if (isOpen()) {
+		printf("tried to call SocketHandle:connect() on open handle!\n");
+		return false;
 	}
+	SocketLin socket;
+	return socket.connect(address, timeout) && adopt(socket);
+}
 
-	bool getINet(NetSocket::INetAddress& address) override {
-		if (this->stype == NetSocket::UNBOUND) {
-			printf("tried to call getINet() on unbound socket!\n");
-			return false;
-		}
-
-		unsigned int addrlen = sizeof(addr_t);
-		if (::getpeername(this->handle, &((addr_t*) address.addr)->sockaddrU, &addrlen) == -1) {
-			if (errno == EBADF || errno == EIO) {
-				close();
-				return false;
-			}
-			printError("error %d in Socket:getINet:getpeername(): %s\n");
-			return false;
-		}
+bool NetSocket::SocketHandle::adopt(Socket& socket) {
+	if (isOpen()) {
+		printf("tried to call SocketHandle:adopt() on open handle!\n");
+		return false;
+	}
+	if (typeid(socket) != typeid(SocketLin) || ((SocketLin&) socket).stype != STREAM) {
+		printf("tried to call SocketHandle:adopt() with non STREAM platform socket!\n");
+		return false;
+	}
+	SocketLin& platformSocket = (SocketLin&) socket;
+	unsigned int users = 0;
+	if (!platformSocket.users.compare_exchange_strong(users, HANDLE_CLOSING)) {
+		printf("tried to call SocketHandle:adopt() with socket in use by another thread!\n");
+		return false;
+	}
+	this->handle = platformSocket.handle;
+	this->flags = platformSocket.blocking ? 0 : FLAG_NON_BLOCKING;
+	platformSocket.handle = -1;
+	platformSocket.remoteLength = 0;
+	platformSocket.stype = UNBOUND;
+	return true;
+}
 
-		return true;
+bool NetSocket::SocketHandle::release(Socket& socket) {
+	if (!isOpen()) {
+		printf("tried to call SocketHandle:release() on closed handle!\n");
+		return false;
 	}
+	if (typeid(socket) != typeid(SocketLin) || ((SocketLin&) socket).stype != UNBOUND) {
+		printf("tried to call SocketHandle:release() with non UNBOUND platform socket!\n");
+		return false;
+	}
+	SocketLin& platformSocket = (SocketLin&) socket;
+	addr_t local;
+	socklen_t localLength = sizeof(addr_t);
+	if (::getsockname(this->handle, &local.sockaddrU, &localLength) == -1) {
+		printError("error %d in SocketHandle:release:getsockname(): %s\n");
+		return false;
+	}
+	platformSocket.addrType = local.sockaddrU.sa_family;
+	platformSocket.blocking = isBlocking();
+	platformSocket.remoteLength = 0;
+	platformSocket.handle = this->handle;
+	platformSocket.setOpen(STREAM);
+	this->handle = -1;
+	this->flags = 0;
+	return true;
+}
 
-	bool setNagle(bool enableBuffering) override {
-		if (this->stype != NetSocket::STREAM) {
-			printf("tried to call setNagle() on non stream socket!\n");
-			return false;
-		}
+void NetSocket::SocketHandle::close() {
+	if (!isOpen()) return;
+	::close(this->handle);
+	this->handle = -1;
+	this->flags = 0;
+}
 
-		unsigned int optval = enableBuffering ? 0 : 1;
-		if (::setsockopt(this->handle, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(int)) == -1) {
-			if (errno == EBADF || errno == EIO) {
-				close();
-				return false;
-			}
-			printError("error %d in Socket:setNagle:setsockopt(TCP_NODELAY): %s\n");
-			return false;
-		}
+bool NetSocket::SocketHandle::setBlocking(bool blocking) {
+	if (!isOpen()) {
+		printf("tried to call SocketHandle:setBlocking() on closed handle!\n");
+		return false;
+	}
+	if (!SocketLin::applyBlocking(this->handle, blocking))
+		return false;
+	this->flags = blocking ? this->flags & ~FLAG_NON_BLOCKING : this->flags | FLAG_NON_BLOCKING;
+	return true;
+}
 
-		return true;
+/*
+ * Waits until the handle is ready for the events, returns false if poll failed or the handle was closed while waiting
+ */
+static bool waitHandle(const int& handle, short events, const char* errorFormat) {
+	struct pollfd fd = {
+		.fd = handle,
+		.events = events,
+		.revents = 0
+	};
+	int result = 0;
+	while (((result = ::poll(&fd, 1UL, READ_SOCKET_TIMEOUT)) == 0 || (result == -1 && errno == EINTR)) && handle != -1);
+	if (result < 0 && handle != -1) {
+		printError(errorFormat);
+		return false;
 	}
+	return handle != -1;
+}
 
-	bool getNagle(bool* enableBuffering) override {
-		if (this->stype != NetSocket::STREAM) {
-			printf("tried to call getNagle() on non stream socket!\n");
-			return false;
-		}
+bool NetSocket::SocketHandle::send(const char* buffer, unsigned int length) {
+	if (!isOpen()) {
+		printf("tried to call SocketHandle:send() on closed handle!\n");
+		return false;
+	}
 
-		unsigned int optlen = sizeof(int);
-		int optval = 0;
-		if (::getsockopt(this->handle, IPPROTO_TCP, TCP_NODELAY, &optval, &optlen) == -1) {
+	while (length > 0) {
+		int result = ::send(this->handle, buffer, length, MSG_NOSIGNAL);
+		if (result == -1) {
+			if ((errno == EAGAIN || errno == EWOULDBLOCK) && !isBlocking()) {
+				// send() always transmits the whole buffer, only trySend() returns early in non blocking mode
+				if (!waitHandle(this->handle, POLLOUT, "error %d in SocketHandle:send:poll(): %s\n"))
+					return false;
+				continue;
+			}
+			if (errno == ETIMEDOUT)
+				return true; // timed out
+			else if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return false; // send timeout expired with only part of the buffer sent
+			else if (errno == ECONNRESET || errno == EPIPE)
+				return false; // connection closed
 			if (errno == EBADF || errno == EIO) {
 				close();
 				return false;
 			}
-			printError("error %d in Socket:getNagle:setsockopt(TCP_NODELAY): %s\n");
+			printError("error %d in SocketHandle:send:send(): %s\n");
 			return false;
 		}
-
-		*enableBuffering = optval == 1 ? false : true;
-		return true;
+		buffer += result;
+		length -= result;
 	}
 
-	bool listen(const NetSocket::INetAddress& address) override {
-		if (this->stype != NetSocket::UNBOUND) {
-			printf("tried to call listen() on already bound socket!\n");
-			return false;
-		}
-
-		this->addrType = ((addr_t*) address.addr)->sockaddrU.sa_family;
-		this->handle = ::socket(((addr_t*) address.addr)->sockaddrU.sa_family, SOCK_STREAM, IPPROTO_TCP);
-		if (this->handle == -1) {
-			printError("error %d in Socket:listen:socket(): %s\n");
-			return false;
-		}
-
-		if (::bind(this->handle, &((addr_t*) address.addr)->sockaddrU, ((addr_t*) address.addr)->sockaddrU.sa_family == AF_INET ? sizeof(sockaddr_in) : sizeof(sockaddr_in6)) != 0) {
-			printError("error %d in Socket:listen:bind(): %s\n");
-			::close(this->handle);
-			this->handle = -1;
-			return false;
-		}
-
-		if (::listen(this->handle, SOMAXCONN) != 0) {
-			printError("error %d in Socket:listen:listen(): %s\n");
-			::close(this->handle);
-			this->handle = -1;
-			return false;
-		}
+	return true;
+}
 
-		this->stype = NetSocket::LISTEN_TCP;
-		return true;
+bool NetSocket::SocketHandle::receive(char* buffer, unsigned int length, unsigned int* received) {
+	if (!isOpen()) {
+		printf("tried to call SocketHandle:receive() on closed handle!\n");
+		return false;
 	}
 
-	bool bind(const NetSocket::INetAddress& address) override {
-		if (this->stype != NetSocket::UNBOUND) {
-			printf("tried to call listen() on already bound socket!\n");
-			return false;
-		}
-
-		this->addrType = ((addr_t*) address.addr)->sockaddrU.sa_family;
-		this->handle = ::socket(((addr_t*) address.addr)->sockaddrU.sa_family, SOCK_DGRAM, IPPROTO_UDP);
-		if (this->handle == -1) {
-			printError("error %d in Socket:bind:socket(): %s\n");
-			return false;
-		}
+	*received = 0;
+	if (isBlocking() && !waitHandle(this->handle, POLLIN, "error %d in SocketHandle:receive:poll(): %s\n"))
+		return false;
 
-		if (::bind(this->handle, &((addr_t*) address.addr)->sockaddrU, ((addr_t*) address.addr)->sockaddrU.sa_family == AF_INET ? sizeof(sockaddr_in) : sizeof(sockaddr_in6)) != 0) {
-			printError("error %d in Socket:bind:bind(): %s\n");
-			::close(this->handle);
-			this->handle = -1;
+	int result = ::recv(this->handle, buffer, length, 0);
+	if (result == 0) {
+		return false; // connection closed
+	} else if (result < 0) {
+		if (errno == ETIMEDOUT || errno == EAGAIN || errno == EWOULDBLOCK)
+			return true; // timed out or nothing to read in non blocking mode
+		else if (errno == ECONNRESET)
+			return false; // connection closed
+		if (errno == EBADF || errno == EIO) {
+			close();
 			return false;
 		}
-
-		this->stype = NetSocket::LISTEN_UDP;
-		return true;
+		printError("error %d in SocketHandle:receive:recv(): %s\n");
+		return false;
 	}
 
-	bool accept(NetSocket::Socket& socket) override {
-		if (this->stype != NetSocket::LISTEN_TCP) {
-			printf("tried to call accept() on non LISTEN_TCP socket!\n");
-			return false;
-		}
-		if (((SocketLin&) socket).stype != NetSocket::UNBOUND) {
-			printf("tried to call accept() with already bound socket!\n");
-			return false;
-		}
-
-		int clientSocket = ::accept(this->handle, NULL, NULL);
-		if (clientSocket == -1) {
-			printError("error %d in Socket:accept:accept(): %s\n");
-			return false;
-		}
+	*received = result;
+	return true;
+}
 
-		((SocketLin&) socket).addrType = this->addrType;
-		((SocketLin&) socket).handle = clientSocket;
-		((SocketLin&) socket).stype = NetSocket::STREAM;
-		return true;
+bool NetSocket::SocketHandle::trySend(const char* buffer, unsigned int length, unsigned int* sent, bool* wouldBlock) {
+	if (!isOpen()) {
+		printf("tried to call SocketHandle:trySend() on closed handle!\n");
+		return false;
 	}
 
-	bool setTimeouts(unsigned long readTimeout, unsigned long writeTimeout) override {
-		if (this->stype == NetSocket::UNBOUND) {
-			printf("tried to call setTimeouts() on unbound socket!\n");
+	*sent = 0;
+	*wouldBlock = false;
+	int result = ::send(this->handle, buffer, length, MSG_DONTWAIT | MSG_NOSIGNAL);
+	if (result == -1) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			*wouldBlock = true;
+			return true;
+		} else if (errno == ECONNRESET || errno == EPIPE)
+			return false; // connection closed
+		if (errno == EBADF || errno == EIO) {
+			close();
 			return false;
 		}
+		printError("error %d in SocketHandle:trySend:send(): %s\n");
+		return false;
+	}
 
-		struct timeval rcvTimeout = {
-				.tv_sec = readTimeout / 1000,
-				.tv_usec = (readTimeout % 1000) * 1000
-		};
-		struct timeval sndTimeout = {
-				.tv_sec = readTimeout / 1000,
-				.tv_usec = (readTimeout % 1000) * 1000
-		};
-		bool b1 = setsockopt(this->handle, SOL_SOCKET, SO_SNDTIMEO, &sndTimeout, sizeof(struct timeval)) == 0;
-		bool b2 = setsockopt(this->handle, SOL_SOCKET, SO_RCVTIMEO, &rcvTimeout, sizeof(struct timeval)) == 0;
-		return b1 & b2;
-	}
-
-	bool getTimeouts(unsigned long* readTimeout, unsigned long* writeTimeout) override {
-		if (this->stype == NetSocket::UNBOUND) {
-			printf("tried to call getTimeouts() on unbound socket!\n");
-			return false;
-		}
+	*sent = result;
+	*wouldBlock = (unsigned int) result < length;
+	return true;
+}
 
-		socklen_t optlen = 0;
-		struct timeval rcvTimeout = {0};
-		struct timeval sndTimeout = {0};
-		bool b1 = getsockopt(this->handle, SOL_SOCKET, SO_SNDTIMEO, &sndTimeout, &optlen) == 0;
-		bool b2 = getsockopt(this->handle, SOL_SOCKET, SO_RCVTIMEO, &rcvTimeout, &optlen) == 0;
-		if (b1) *writeTimeout = sndTimeout.tv_sec * 1000 + (sndTimeout.tv_usec / 1000);
-		if (b2) *readTimeout = rcvTimeout.tv_sec * 1000 + (rcvTimeout.tv_usec / 1000);
-		return b1 & b2;
+bool NetSocket::SocketHandle::tryReceive(char* buffer, unsigned int length, unsigned int* received, bool* wouldBlock) {
+	if (!isOpen()) {
+		printf("tried to call SocketHandle:tryReceive() on closed handle!\n");
+		return false;
 	}
 
-	bool connect(const NetSocket::INetAddress& address, unsigned long timeout) override {
-		if (this->stype != NetSocket::UNBOUND) {
-			printf("tried to call connect() on already bound socket!\n");
+	*received = 0;
+	*wouldBlock = false;
+	int result = ::recv(this->handle, buffer, length, MSG_DONTWAIT);
+	if (result == 0) {
+		return false; // connection closed
+	} else if (result == -1) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			*wouldBlock = true;
+			return true;
+		} else if (errno == ECONNRESET)
+			return false; // connection closed
+		if (errno == EBADF || errno == EIO) {
+			close();
 			return false;
 		}
+		printError("error %d in SocketHandle:tryReceive:recv(): %s\n");
+		return false;
+	}
 
-		this->handle = ::socket(((addr_t*) address.addr)->sockaddrU.sa_family, SOCK_STREAM, IPPROTO_TCP);
-		this->pollfd.fd = this->handle;
-		this->pollfd.events = POLLIN | POLLOUT;
-		if (this->handle == -1) {
-			printError("error %d in Socket:connect:socket(): %s\n");
-			return false;
-		}
+	*received = result;
+	return true;
+}
 
-		int flags = ::fcntl(this->handle, F_GETFL, 0);
-		if (::fcntl(this->handle, F_SETFL, flags | O_NONBLOCK) == -1) {
-			printError("error %d in Socket:connect:fcntl(O_NONBLOCK=1): %s\n");
-			::close(this->handle);
-			return false;
+void NetSocket::Socket::sampleStats(Socket** sockets, ConnectionStats* stats, unsigned int count, unsigned int* sampledCount) {
+	*sampledCount = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		SocketLin* socket = dynamic_cast<SocketLin*>(sockets[i]);
+		if (socket == 0 || socket->stype != STREAM || socket->addrType == AF_UNIX) {
+			memset(stats + i, 0, sizeof(ConnectionStats));
+			continue;
 		}
-
-		int result = ::connect(this->handle, &((addr_t*) address.addr)->sockaddrU, ((addr_t*) address.addr)->sockaddrU.sa_family == AF_INET ? sizeof(sockaddr_in) : sizeof(sockaddr_in6));
-		if (result == -1) {
-			if (errno == EINPROGRESS || errno == EAGAIN) {
-
-				this->pollfd.revents = 0;
-				result = ::poll(&this->pollfd, 1U, (int) timeout);
-				if (result == 0) {
-					::close(this->handle);
-					this->handle = -1;
-					return false; // timed out
-				}
-
-			} else {
-				printError("error %d in Socket:connect:connect(): %s\n");
-				::close(this->handle);
-				this->handle = -1;
-				return false;
-			}
+		SocketLin::HandleUse use(socket);
+		if (!use || !readStats(socket->handle, stats + i)) {
+			memset(stats + i, 0, sizeof(ConnectionStats));
+			continue;
 		}
+		(*sampledCount)++;
+	}
+}
 
-		if (::fcntl(this->handle, F_SETFL, flags ^ O_NONBLOCK) == -1) {
-			printError("error %d in Socket:connect:fcntl(O_NONBLOCK=0): %s\n");
-			::close(this->handle);
+bool NetSocket::Socket::pollMany(Socket** sockets, const int* events, int* readyEvents, unsigned int count, int timeout, unsigned int* readyCount) {
+	*readyCount = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		if (dynamic_cast<SocketLin*>(sockets[i]) == 0) {
+			printf("tried to call pollMany() with socket not backed by an handle!\n");
 			return false;
 		}
-
-		this->stype = NetSocket::STREAM;
-		return true;
 	}
 
-	void close() override {
-		if (this->stype == NetSocket::UNBOUND) return;
-		::close(this->handle);
-		this->handle = -1;
-		this->stype = NetSocket::UNBOUND;
+	// the handles are referenced while polling, so an socket closed by another thread wakes up the poll instead of its handle being reused
+	std::vector<struct pollfd> fds(count);
+	std::vector<char> acquired(count);
+	for (unsigned int i = 0; i < count; i++) {
+		readyEvents[i] = 0;
+		SocketLin* socket = (SocketLin*) sockets[i];
+		acquired[i] = socket->acquireHandle();
+		fds[i].fd = acquired[i] ? socket->pollHandle() : -1; // negative handles are ignored by poll
+		fds[i].events = (events[i] & EVENT_READ ? POLLIN : 0) | (events[i] & EVENT_WRITE ? POLLOUT : 0) | (socket->stype == STREAM ? POLLRDHUP : 0);
+		fds[i].revents = 0;
+
+		// data already decrypted by TLS sockets does not make the handle readable
+		if ((events[i] & EVENT_READ) && socket->hasPendingData()) {
+			readyEvents[i] = EVENT_READ;
+			timeout = 0;
+		}
 	}
 
-	bool isOpen() override {
-		return this->stype != NetSocket::UNBOUND && this->handle != -1;
+	int result;
+	while ((result = ::poll(fds.data(), count, timeout)) == -1 && errno == EINTR);
+	for (unsigned int i = 0; i < count; i++)
+		if (acquired[i]) ((SocketLin*) sockets[i])->releaseHandle();
+	if (result == -1) {
+		printError("error %d in Socket:pollMany:poll(): %s\n");
+		return false;
 	}
 
-	bool send(const char* buffer, unsigned int length) override {
-		if (this->stype == NetSocket::UNBOUND) {
-			printf("tried to call send() on unbound socket!\n");
-			return false;
-		} else if (this->stype != NetSocket::STREAM) {
-			printf("tried to call send() on non STREAM socket!\n");
-			return false;
-		}
-
-		if (::send(this->handle, buffer, length, 0) == -1) {
-			if (errno == ETIMEDOUT)
-				return true; // timed out
-			else if (errno == ECONNRESET)
-				return false; // connection closed
-			if (errno == EBADF || errno == EIO) {
-				close();
-				return false;
-			}
-			printError("error %d in Socket:send:send(): %s\n");
-			return false;
-		}
-
-		return true;
+	for (unsigned int i = 0; i < count; i++) {
+		short revents = fds[i].revents;
+		if (revents & POLLIN) readyEvents[i] |= EVENT_READ;
+		if (revents & POLLOUT) readyEvents[i] |= EVENT_WRITE;
+		if (revents & (POLLERR | POLLNVAL)) readyEvents[i] |= EVENT_ERROR;
+		if (revents & (POLLHUP | POLLRDHUP)) readyEvents[i] |= EVENT_CLOSED;
+		if (readyEvents[i] != 0) (*readyCount)++;
 	}
+	return true;
+}
 
-	bool receive(char* buffer, unsigned int length, unsigned int* received) override {
-		if (this->stype == NetSocket::UNBOUND) {
-			printf("tried to call send() on unbound socket!\n");
-			return false;
-		} else if (this->stype != NetSocket::STREAM) {
-			printf("tried to call send() on non STREAM socket!\n");
-			return false;
-		}
+NetSocket::SocketProfile NetSocket::SocketProfile::lowLatency() {
+	return SocketProfile()
+			.set(OPT_NO_DELAY, 1)
+			.set(OPT_QUICK_ACK, 1)
+			.set(OPT_CORK, 0)
+			.set(OPT_NOTSENT_LOWAT, 16384)
+			.set(OPT_PRIORITY, 6);
+}
 
-		struct pollfd fd = {
-			.fd = this->handle,
-			.events = POLLIN,
-			.revents = 0
-		};
-		int result = 0;
-		while ((result = ::poll(&fd, 1UL, READ_SOCKET_TIMEOUT)) == 0 && isOpen()) {
-			if (result < 0) {
-				printError("error %d in Socket:receive:poll(): %s\n");
-				return false;
-			}
-		}
+NetSocket::SocketProfile NetSocket::SocketProfile::bulkThroughput() {
+	return SocketProfile()
+			.set(OPT_NO_DELAY, 0)
+			.set(OPT_RECEIVE_BUFFER, 4 << 20)
+			.set(OPT_SEND_BUFFER, 4 << 20)
+			.set(OPT_PRIORITY, 0);
+}
 
-		result = ::recv(this->handle, buffer, length, 0);
-		if (result == 0) {
-			return false; // connection closed
-		} else if (result < 0) {
-			if (errno == ETIMEDOUT)
-				return true; // timed out
-			else if (errno == ECONNRESET)
-				return false; // connection closed
-			if (errno == EBADF || errno == EIO) {
-				close();
-				return false;
-			}
-			printError("error %d in Socket:receive:recv(): %s\n");
-			return false;
-		} else {
-			*received = result;
-		}
+/*
+ * Bytes used by the listener handover protocol
+ */
+#define HANDOVER_OFFER 'H'
+#define HANDOVER_CONFIRM 'A'
 
-		return true;
+bool NetSocket::handoverListener(Socket& channel, Socket& listenSocket, unsigned long timeout) {
+	if (listenSocket.type() != NetSocket::LISTEN_TCP) {
+		printf("tried to call handoverListener() with non LISTEN_TCP socket!\n");
+		return false;
 	}
 
-	bool receivefrom(NetSocket::INetAddress& address, char* buffer, unsigned int length, unsigned int* received) override {
-		if (this->stype == NetSocket::UNBOUND) {
-			printf("tried to call receivefrom() on unbound socket!\n");
-			return false;
-		} else if (this->stype != NetSocket::LISTEN_UDP) {
-			printf("tried to call receivefrom() on non LISTEN_UDP socket!\n");
-			return false;
-		}
-
-		timeval rcvtimeout;
-		rcvtimeout.tv_sec = 1;
-		rcvtimeout.tv_usec = 0;
-
-		struct pollfd fd = {
-			.fd = this->handle,
-			.events = POLLIN,
-			.revents = 0
-		};
-		int result = 0;
-		while ((result = ::poll(&fd, 1UL, READ_SOCKET_TIMEOUT)) == 0 && isOpen()) {
-			if (result < 0) {
-				printError("error %d in Socket:receivefrom:poll(): %s\n");
-				return false;
-			}
-		}
-
-		socklen_t senderAdressLen = sizeof(sockaddr_in6);
-		result = ::recvfrom(this->handle, buffer, length, 0, &((addr_t*) address.addr)->sockaddrU, &senderAdressLen);
-		if (result == 0) {
-			return false; // connection closed
-		} else if (result == -1) {
-			if (errno == ETIMEDOUT)
-				return true; // timed out
-			else if (errno == ECONNRESET)
-				return false; // connection closed
-			if (errno == EBADF || errno == EIO) {
-				close();
-				return false;
-			}
-			printError("error %d in Socket:receivefrom:recvfrom(): %s\n");
-			return false;
-		} else {
-			*received = result;
-		}
-
-		return true;
+	char offer = HANDOVER_OFFER;
+	if (!channel.sendSocket(listenSocket, &offer, 1))
+		return false;
 
+	struct pollfd fd = {
+		.fd = ((SocketLin&) channel).handle,
+		.events = POLLIN,
+		.revents = 0
+	};
+	int result = ::poll(&fd, 1UL, timeout == 0 ? -1 : (int) timeout);
+	if (result <= 0) {
+		if (result < 0) printError("error %d in Socket:handoverListener:poll(): %s\n");
+		return false; // not confirmed in time, keep serving
 	}
 
-	bool sendto(const NetSocket::INetAddress& address, const char* buffer, unsigned int length) override {
-		if (this->stype == NetSocket::UNBOUND) {
-			printf("tried to call sendto() on unbound socket!\n");
-			return false;
-		} else if (this->stype != NetSocket::LISTEN_UDP) {
-			printf("tried to call sendto() on non LISTEN_UDP socket!\n");
-			return false;
-		}
+	char confirm = 0;
+	unsigned int received = 0;
+	if (!channel.receive(&confirm, 1, &received) || received != 1 || confirm != HANDOVER_CONFIRM) {
+		printf("handoverListener() was not confirmed by the new process!\n");
+		return false;
+	}
 
-		if (((addr_t*) address.addr)->sockaddrU.sa_family != this->addrType) {
-			printf("tried to call receivefrom() with invalid address type for this socket!\n");
-			return false;
-		}
+	listenSocket.close();
+	return true;
+}
 
-		int result = ::sendto(this->handle, buffer, length, 0, &((addr_t*) address.addr)->sockaddrU, ((addr_t*) address.addr)->sockaddrU.sa_family == AF_INET ? sizeof(sockaddr_in) : sizeof(sockaddr_in6));
-		if (result == -1) {
-			if (errno == ETIMEDOUT)
-				return true; // timed out
-			else if (errno == ECONNRESET)
-				return false; // connection closed
-			if (errno == EBADF || errno == EIO) {
-				close();
-				return false;
-			}
-			printError("error %d in Socket:sendto:sendto(): %s\n");
-			return false;
-		}
+bool NetSocket::takeoverListener(Socket& channel, Socket& listenSocket) {
+	char offer = 0;
+	unsigned int received = 0;
+	if (!channel.receiveSocket(listenSocket, &offer, 1, &received))
+		return false;
 
-		return true;
+	if (received != 1 || offer != HANDOVER_OFFER || listenSocket.type() != NetSocket::LISTEN_TCP) {
+		printf("takeoverListener() received no listen socket!\n");
+		listenSocket.close();
+		return false;
 	}
 
-};
+	char confirm = HANDOVER_CONFIRM;
+	if (!channel.send(&confirm, 1)) {
+		listenSocket.close();
+		return false;
+	}
 
-NetSocket::Socket* NetSocket::newSocket() {
-	return new SocketLin();
+	return true;
 }
 
 #endif
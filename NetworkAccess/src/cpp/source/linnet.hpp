@@ -0,0 +1,1811 @@
+/*
+ * linnet.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef LINNET_HPP_
+#define LINNET_HPP_
+
+#ifdef PLATFORM_LIN
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <atomic>
+#include <sys/uio.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#include "netsocket.hpp"
+#include "netsocket_filter.hpp"
+#include "nettrace.hpp"
+#include "inetformat.hpp"
+
+/*
+ * On linux read functions may never return if the socket is closed or other special conditions occur
+ * So we have to define an timeout and use poll() to wait for read-readiness on the socket
+ */
+#define READ_SOCKET_TIMEOUT 2000
+
+/*
+ * Maximum number of datagrams transfered by one batch call
+ */
+#define UDP_BATCH_SIZE 64
+
+/*
+ * Maximum number of buffers passed to one gathered send
+ */
+#define SEND_GATHER_SIZE 64
+
+/*
+ * Set in the user count of an socket while its handle is closed or being closed, no call can acquire the handle then
+ */
+#define HANDLE_CLOSING 0x80000000U
+
+/*
+ * Set together with HANDLE_CLOSING if close() had to shut the handle down to wake up calls of other threads
+ */
+#define HANDLE_SHUT_DOWN 0x40000000U
+
+void printError(const char* format);
+
+typedef union {
+		sockaddr sockaddrU;
+		sockaddr_in sockaddr4;
+		sockaddr_in6 sockaddr6;
+		sockaddr_un sockaddrUn;
+} addr_t;
+
+/*
+ * Returns the number of bytes of the address structure actually used by the stored address family
+ * Abstract unix addresses (sun_path starting with a zero byte) are not null terminated, their length is part of the address
+ */
+inline socklen_t addrLength(const addr_t* address) {
+	switch (address->sockaddrU.sa_family) {
+	case AF_INET: return sizeof(sockaddr_in);
+	case AF_INET6: return sizeof(sockaddr_in6);
+	case AF_UNIX:
+		if (address->sockaddrUn.sun_path[0] == '\0')
+			return offsetof(sockaddr_un, sun_path) + 1 + strnlen(address->sockaddrUn.sun_path + 1, sizeof(address->sockaddrUn.sun_path) - 1);
+		return offsetof(sockaddr_un, sun_path) + strnlen(address->sockaddrUn.sun_path, sizeof(address->sockaddrUn.sun_path) - 1) + 1;
+	default: return sizeof(addr_t);
+	}
+}
+
+inline int addrProtocol(const addr_t* address, bool udp) {
+	if (address->sockaddrU.sa_family == AF_UNIX) return 0;
+	return udp ? IPPROTO_UDP : IPPROTO_TCP;
+}
+
+/*
+ * Removes an stale unix socket file left behind by an previous process, since bind() would fail otherwise.
+ * The file is only removed if connecting to it is refused, an socket file still used by an running process is left in place.
+ */
+inline void unlinkStaleUnix(const addr_t* address, int type) {
+	if (address->sockaddrU.sa_family != AF_UNIX || address->sockaddrUn.sun_path[0] == '\0') return;
+	struct stat info;
+	if (::stat(address->sockaddrUn.sun_path, &info) != 0 || !S_ISSOCK(info.st_mode)) return;
+	int probe = ::socket(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (probe == -1) return;
+	bool stale = ::connect(probe, &address->sockaddrU, addrLength(address)) != 0 && errno == ECONNREFUSED;
+	::close(probe);
+	if (stale)
+		::unlink(address->sockaddrUn.sun_path);
+}
+
+/*
+ * Layout of struct tcp_info as returned by current kernels (linux/tcp.h), the one of glibc ends at tcpi_total_retrans.
+ * The kernel only appends fields and returns the length it filled, so older kernels leave the remaining fields zero.
+ */
+struct tcp_info_kernel {
+	uint8_t state, caState, retransmits, probes, backoff, options, wscale, flags;
+	uint32_t rto, ato, sndMss, rcvMss;
+	uint32_t unacked, sacked, lost, retrans, fackets;
+	uint32_t lastDataSent, lastAckSent, lastDataRecv, lastAckRecv;
+	uint32_t pmtu, rcvSsthresh, rtt, rttvar, sndSsthresh, sndCwnd, advmss, reordering;
+	uint32_t rcvRtt, rcvSpace;
+	uint32_t totalRetrans;
+	uint64_t pacingRate, maxPacingRate, bytesAcked, bytesReceived;
+	uint32_t segsOut, segsIn;
+	uint32_t notsentBytes, minRtt, dataSegsIn, dataSegsOut;
+	uint64_t deliveryRate;
+	uint64_t busyTime, rwndLimited, sndbufLimited;
+	uint32_t delivered, deliveredCe;
+	uint64_t bytesSent, bytesRetrans;
+	uint32_t dsackDups, reordSeen;
+	uint32_t rcvOoopack;
+	uint32_t sndWnd;
+};
+
+/*
+ * Reads TCP_INFO of the handle into the portable statistics, errno is set if false is returned
+ */
+inline bool readStats(int handle, NetSocket::ConnectionStats* stats) {
+	struct tcp_info_kernel info;
+	memset(&info, 0, sizeof(info));
+	socklen_t optlen = sizeof(info);
+	if (::getsockopt(handle, IPPROTO_TCP, TCP_INFO, &info, &optlen) == -1) {
+		memset(stats, 0, sizeof(NetSocket::ConnectionStats));
+		return false;
+	}
+
+	stats->valid = true;
+	stats->rtt = info.rtt;
+	stats->rttVariance = info.rttvar;
+	stats->minRtt = info.minRtt;
+	stats->mss = info.sndMss;
+	stats->congestionWindow = info.sndCwnd * info.sndMss;
+	stats->slowStartThreshold = info.sndSsthresh == 0x7fffffff ? 0 : info.sndSsthresh * info.sndMss; // TCP_INFINITE_SSTHRESH
+	stats->peerWindow = info.sndWnd;
+	stats->unacked = info.unacked * info.sndMss;
+	stats->notSent = info.notsentBytes;
+	stats->retransmits = info.retransmits;
+	stats->totalRetransmits = info.totalRetrans;
+	stats->lost = info.lost;
+	stats->bytesSent = info.bytesSent;
+	stats->bytesAcked = info.bytesAcked;
+	stats->bytesReceived = info.bytesReceived;
+	stats->bytesRetransmitted = info.bytesRetrans;
+	stats->deliveryRate = info.deliveryRate;
+	stats->pacingRate = info.pacingRate == ~0ULL ? 0 : info.pacingRate;
+	stats->receiveWindowLimited = info.rwndLimited;
+	stats->sendBufferLimited = info.sndbufLimited;
+	return true;
+}
+
+/*
+ * Scope of an socket option, options are rejected by setOption() and skipped in profiles for sockets outside their scope
+ */
+#define OPTION_ANY 0
+#define OPTION_TCP 1
+#define OPTION_UDP 2
+
+/*
+ * Resolves the level and name of an socket option, IP level options are mapped to their IPv6 counterparts for AF_INET6 sockets
+ */
+inline bool optionName(NetSocket::SocketOption option, unsigned short family, int* level, int* name, int* scope) {
+	static const int options[NetSocket::OPT_COUNT][3] = {
+		{ SOL_SOCKET, SO_RCVBUF, OPTION_ANY },
+		{ SOL_SOCKET, SO_SNDBUF, OPTION_ANY },
+		{ SOL_SOCKET, SO_BUSY_POLL, OPTION_ANY },
+		{ IPPROTO_TCP, TCP_QUICKACK, OPTION_TCP },
+		{ IPPROTO_TCP, TCP_CORK, OPTION_TCP },
+		{ IPPROTO_TCP, TCP_NOTSENT_LOWAT, OPTION_TCP },
+		{ IPPROTO_TCP, TCP_FASTOPEN, OPTION_TCP },
+		{ SOL_SOCKET, SO_PRIORITY, OPTION_ANY },
+		{ IPPROTO_TCP, TCP_NODELAY, OPTION_TCP },
+		{ IPPROTO_TCP, TCP_DEFER_ACCEPT, OPTION_TCP },
+		{ SOL_SOCKET, SO_REUSEADDR, OPTION_ANY },
+		{ IPPROTO_IP, IP_MULTICAST_TTL, OPTION_UDP },
+		{ IPPROTO_IP, IP_MULTICAST_LOOP, OPTION_UDP },
+		{ IPPROTO_IP, IP_MULTICAST_IF, OPTION_UDP },
+		{ SOL_SOCKET, SO_MAX_PACING_RATE, OPTION_ANY }
+	};
+	if (option < 0 || option >= NetSocket::OPT_COUNT) return false;
+	*level = options[option][0];
+	*name = options[option][1];
+	*scope = options[option][2];
+	if (family == AF_INET6 && *level == IPPROTO_IP) {
+		*level = IPPROTO_IPV6;
+		*name = *name == IP_MULTICAST_TTL ? IPV6_MULTICAST_HOPS : *name == IP_MULTICAST_LOOP ? IPV6_MULTICAST_LOOP : IPV6_MULTICAST_IF;
+	}
+	return true;
+}
+
+/*
+ * Sets an integer socket option, IP_MULTICAST_IF is the only one which does not take an int but an struct with the interface index
+ */
+inline int setOptionValue(int handle, int level, int name, int value) {
+	if (level == IPPROTO_IP && name == IP_MULTICAST_IF) {
+		struct ip_mreqn request = {0};
+		request.imr_ifindex = value;
+		return ::setsockopt(handle, level, name, &request, sizeof(struct ip_mreqn));
+	}
+	return ::setsockopt(handle, level, name, &value, sizeof(int));
+}
+
+class SocketLin : public NetSocket::Socket {
+
+public:
+	std::atomic<NetSocket::SocketType> stype;
+	std::atomic<int> handle;
+	std::atomic<unsigned int> users; // calls currently using the handle, plus HANDLE_CLOSING
+	unsigned short addrType;
+	NetSocket::SocketProfile profile;
+	bool blocking;
+	const NetSocket::AddressFilter* filter;
+	addr_t remoteAddress;
+	socklen_t remoteLength;
+
+	SocketLin() {
+		this->stype = NetSocket::UNBOUND;
+		this->handle = -1;
+		this->users = HANDLE_CLOSING;
+		this->addrType = 0;
+		this->blocking = true;
+		this->filter = 0;
+		this->remoteLength = 0;
+	}
+
+	~SocketLin() override {
+		if (this->stype != NetSocket::UNBOUND) {
+			close();
+		}
+	}
+
+	NetSocket::SocketType type() override {
+		return this->stype;
+	}
+
+	/*
+	 * Reference to the handle held for the duration of an call, close() on another thread only marks the socket as closing
+	 * and wakes up blocked calls, the handle is released when the last reference is dropped, so it can never be reused while in use
+	 */
+	class HandleUse {
+	public:
+		HandleUse(SocketLin* socket) : socket(socket), acquired(socket->acquireHandle()) {}
+		~HandleUse() {
+			if (this->acquired) this->socket->releaseHandle();
+		}
+		explicit operator bool() const {
+			return this->acquired;
+		}
+	private:
+		SocketLin* socket;
+		bool acquired;
+	};
+
+	/*
+	 * Adds an reference to the handle, returns false if the socket is closed or being closed
+	 */
+	bool acquireHandle() {
+		unsigned int users = this->users.load(std::memory_order_relaxed);
+		do {
+			if (users & HANDLE_CLOSING) return false;
+		} while (!this->users.compare_exchange_weak(users, users + 1, std::memory_order_acquire, std::memory_order_relaxed));
+		return true;
+	}
+
+	/*
+	 * Drops an reference to the handle, the last reference after close() releases it
+	 */
+	void releaseHandle() {
+		if ((this->users.fetch_sub(1, std::memory_order_acq_rel) & ~HANDLE_SHUT_DOWN) == (HANDLE_CLOSING | 1))
+			closeHandle();
+	}
+
+	/*
+	 * Publishes an fully set up handle, calls can acquire it from now on
+	 */
+	void setOpen(NetSocket::SocketType type) {
+		this->stype = type;
+		this->users.store(0, std::memory_order_release);
+	}
+
+	int lastError() override {
+		return errno;
+	}
+
+	bool getINet(NetSocket::INetAddress& address) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call getINet() on unbound socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		if (this->remoteLength > 0) {
+			// known from connect() or accept()
+			memcpy(address.addr, &this->remoteAddress, this->remoteLength);
+			return true;
+		}
+
+		unsigned int addrlen = sizeof(addr_t);
+		if (::getpeername(this->handle, &((addr_t*) address.addr)->sockaddrU, &addrlen) == -1) {
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:getINet:getpeername(): %s\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool setNagle(bool enableBuffering) override {
+		if (this->stype != NetSocket::STREAM) {
+			printf("tried to call setNagle() on non stream socket!\n");
+			return false;
+		}
+		if (this->addrType == AF_UNIX)
+			return true; // no buffering algorithm on local sockets
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		unsigned int optval = enableBuffering ? 0 : 1;
+		if (::setsockopt(this->handle, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(int)) == -1) {
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:setNagle:setsockopt(TCP_NODELAY): %s\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool getNagle(bool* enableBuffering) override {
+		if (this->stype != NetSocket::STREAM) {
+			printf("tried to call getNagle() on non stream socket!\n");
+			return false;
+		}
+		if (this->addrType == AF_UNIX) {
+			*enableBuffering = false;
+			return true;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		unsigned int optlen = sizeof(int);
+		int optval = 0;
+		if (::getsockopt(this->handle, IPPROTO_TCP, TCP_NODELAY, &optval, &optlen) == -1) {
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:getNagle:setsockopt(TCP_NODELAY): %s\n");
+			return false;
+		}
+
+		*enableBuffering = optval == 1 ? false : true;
+		return true;
+	}
+
+	bool setOption(NetSocket::SocketOption option, int value) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call setOption() on unbound socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		return applyOption(this->handle, option, value);
+	}
+
+	bool getOption(NetSocket::SocketOption option, int* value) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call getOption() on unbound socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		int level, name, scope;
+		if (!optionName(option, this->addrType, &level, &name, &scope)) {
+			printf("tried to call getOption() with invalid option %d!\n", option);
+			return false;
+		}
+
+		socklen_t optlen = sizeof(int);
+		if (::getsockopt(this->handle, level, name, value, &optlen) == -1) {
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:getOption:getsockopt(): %s\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool setProfile(const NetSocket::SocketProfile& profile) override {
+		this->profile = profile;
+		if (this->stype == NetSocket::UNBOUND)
+			return true;
+		HandleUse use(this);
+		if (!use) return true; // closed by another thread
+		return applyProfile(this->handle, this->profile, this->stype);
+	}
+
+	bool applyOption(int handle, NetSocket::SocketOption option, int value) {
+		int level, name, scope;
+		if (!optionName(option, this->addrType, &level, &name, &scope)) {
+			printf("tried to set invalid socket option %d!\n", option);
+			return false;
+		}
+		if (scope == OPTION_TCP && (this->addrType == AF_UNIX || this->stype == NetSocket::LISTEN_UDP)) {
+			printf("tried to set TCP socket option %d on non TCP socket!\n", option);
+			return false;
+		}
+		if (scope == OPTION_UDP && (this->addrType == AF_UNIX || this->stype != NetSocket::LISTEN_UDP)) {
+			printf("tried to set UDP socket option %d on non UDP socket!\n", option);
+			return false;
+		}
+
+		if (setOptionValue(handle, level, name, value) == -1) {
+			printError("error %d in Socket:applyOption:setsockopt(): %s\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	/*
+	 * Applies all options of the profile which are meaningful for the socket type, stops at the first failure
+	 */
+	bool applyProfile(int handle, const NetSocket::SocketProfile& profile, NetSocket::SocketType type) {
+		bool tcp = type != NetSocket::LISTEN_UDP && this->addrType != AF_UNIX;
+		bool udp = type == NetSocket::LISTEN_UDP && this->addrType != AF_UNIX;
+		for (int i = 0; i < NetSocket::OPT_COUNT; i++) {
+			if (profile.values[i] == -1) continue;
+			int level, name, scope;
+			optionName((NetSocket::SocketOption) i, this->addrType, &level, &name, &scope);
+			if ((scope == OPTION_TCP && !tcp) || (scope == OPTION_UDP && !udp)) continue;
+			if ((i == NetSocket::OPT_FAST_OPEN || i == NetSocket::OPT_DEFER_ACCEPT) && type != NetSocket::LISTEN_TCP) continue; // server side only
+			if (setOptionValue(handle, level, name, profile.values[i]) == -1) {
+				printError("error %d in Socket:applyProfile:setsockopt(): %s\n");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool listen(const NetSocket::INetAddress& address) override {
+		if (this->stype != NetSocket::UNBOUND) {
+			printf("tried to call listen() on already bound socket!\n");
+			return false;
+		}
+
+		this->addrType = ((addr_t*) address.addr)->sockaddrU.sa_family;
+		this->handle = ::socket(((addr_t*) address.addr)->sockaddrU.sa_family, SOCK_STREAM, addrProtocol((addr_t*) address.addr, false));
+		if (this->handle == -1) {
+			printError("error %d in Socket:listen:socket(): %s\n");
+			return false;
+		}
+
+		if (!applyProfile(this->handle, this->profile, NetSocket::LISTEN_TCP) || !applyBlocking(this->handle, this->blocking)) {
+			::close(this->handle);
+			this->handle = -1;
+			return false;
+		}
+
+		unlinkStaleUnix((addr_t*) address.addr, SOCK_STREAM);
+		if (::bind(this->handle, &((addr_t*) address.addr)->sockaddrU, addrLength((addr_t*) address.addr)) != 0) {
+			printError("error %d in Socket:listen:bind(): %s\n");
+			::close(this->handle);
+			this->handle = -1;
+			return false;
+		}
+
+		if (::listen(this->handle, SOMAXCONN) != 0) {
+			printError("error %d in Socket:listen:listen(): %s\n");
+			::close(this->handle);
+			this->handle = -1;
+			return false;
+		}
+
+		setOpen(NetSocket::LISTEN_TCP);
+		return true;
+	}
+
+	bool bind(const NetSocket::INetAddress& address) override {
+		if (this->stype != NetSocket::UNBOUND) {
+			printf("tried to call listen() on already bound socket!\n");
+			return false;
+		}
+
+		this->addrType = ((addr_t*) address.addr)->sockaddrU.sa_family;
+		this->handle = ::socket(((addr_t*) address.addr)->sockaddrU.sa_family, SOCK_DGRAM, addrProtocol((addr_t*) address.addr, true));
+		if (this->handle == -1) {
+			printError("error %d in Socket:bind:socket(): %s\n");
+			return false;
+		}
+
+		if (!applyProfile(this->handle, this->profile, NetSocket::LISTEN_UDP) || !applyBlocking(this->handle, this->blocking)) {
+			::close(this->handle);
+			this->handle = -1;
+			return false;
+		}
+
+		unlinkStaleUnix((addr_t*) address.addr, SOCK_DGRAM);
+		if (::bind(this->handle, &((addr_t*) address.addr)->sockaddrU, addrLength((addr_t*) address.addr)) != 0) {
+			printError("error %d in Socket:bind:bind(): %s\n");
+			::close(this->handle);
+			this->handle = -1;
+			return false;
+		}
+
+		setOpen(NetSocket::LISTEN_UDP);
+		return true;
+	}
+
+	bool accept(NetSocket::Socket& socket) override {
+		if (this->stype != NetSocket::LISTEN_TCP) {
+			printf("tried to call accept() on non LISTEN_TCP socket!\n");
+			return false;
+		}
+		if (((SocketLin&) socket).stype != NetSocket::UNBOUND) {
+			printf("tried to call accept() with already bound socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		TRACE_BEGIN(acceptStart);
+		addr_t* peer = &((SocketLin&) socket).remoteAddress;
+		socklen_t peerLength;
+		int clientSocket;
+		do {
+			peerLength = sizeof(addr_t);
+			clientSocket = ::accept(this->handle, &peer->sockaddrU, &peerLength);
+			if (clientSocket == -1) {
+				if ((errno == EAGAIN || errno == EWOULDBLOCK) && !this->blocking)
+					return false; // no connection queued
+				if (!isOpen())
+					return false; // closed by another thread
+				printError("error %d in Socket:accept:accept(): %s\n");
+				return false;
+			}
+			if (isDenied(peer)) {
+				// dropped before any option or handshake work is done for it
+				::close(clientSocket);
+				clientSocket = -1;
+			}
+		} while (clientSocket == -1);
+		TRACE_END(NetSocket::TRACE_ACCEPT_WAIT, acceptStart);
+
+		((SocketLin&) socket).addrType = this->addrType;
+		bool ownProfile = false;
+		for (int i = 0; i < NetSocket::OPT_COUNT; i++)
+			if (((SocketLin&) socket).profile.values[i] != -1) ownProfile = true;
+		if (!((SocketLin&) socket).applyProfile(clientSocket, ownProfile ? ((SocketLin&) socket).profile : this->profile, NetSocket::STREAM) ||
+			!applyBlocking(clientSocket, ((SocketLin&) socket).blocking)) {
+			::close(clientSocket);
+			return false;
+		}
+
+		((SocketLin&) socket).remoteLength = peerLength;
+		((SocketLin&) socket).handle = clientSocket;
+		((SocketLin&) socket).setOpen(NetSocket::STREAM);
+		return true;
+	}
+
+	/*
+	 * Checks the address of an peer against the filter, only IPv4 and IPv6 addresses are filtered
+	 */
+	bool isDenied(const addr_t* address) {
+		if (this->filter == 0) return false;
+		if (address->sockaddrU.sa_family == AF_INET)
+			return !this->filter->isAllowed((const unsigned char*) &address->sockaddr4.sin_addr, 4);
+		if (address->sockaddrU.sa_family == AF_INET6)
+			return !this->filter->isAllowed((const unsigned char*) &address->sockaddr6.sin6_addr, 16);
+		return false;
+	}
+
+	bool setFilter(const NetSocket::AddressFilter* filter) override {
+		this->filter = filter;
+		return true;
+	}
+
+	bool setTimeouts(unsigned long readTimeout, unsigned long writeTimeout) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call setTimeouts() on unbound socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		struct timeval rcvTimeout = {
+				.tv_sec = readTimeout / 1000,
+				.tv_usec = (readTimeout % 1000) * 1000
+		};
+		struct timeval sndTimeout = {
+				.tv_sec = readTimeout / 1000,
+				.tv_usec = (readTimeout % 1000) * 1000
+		};
+		bool b1 = setsockopt(this->handle, SOL_SOCKET, SO_SNDTIMEO, &sndTimeout, sizeof(struct timeval)) == 0;
+		bool b2 = setsockopt(this->handle, SOL_SOCKET, SO_RCVTIMEO, &rcvTimeout, sizeof(struct timeval)) == 0;
+		return b1 & b2;
+	}
+
+	bool getTimeouts(unsigned long* readTimeout, unsigned long* writeTimeout) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call getTimeouts() on unbound socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		socklen_t optlen = 0;
+		struct timeval rcvTimeout = {0};
+		struct timeval sndTimeout = {0};
+		bool b1 = getsockopt(this->handle, SOL_SOCKET, SO_SNDTIMEO, &sndTimeout, &optlen) == 0;
+		bool b2 = getsockopt(this->handle, SOL_SOCKET, SO_RCVTIMEO, &rcvTimeout, &optlen) == 0;
+		if (b1) *writeTimeout = sndTimeout.tv_sec * 1000 + (sndTimeout.tv_usec / 1000);
+		if (b2) *readTimeout = rcvTimeout.tv_sec * 1000 + (rcvTimeout.tv_usec / 1000);
+		return b1 & b2;
+	}
+
+	bool connect(const NetSocket::INetAddress& address, unsigned long timeout) override {
+		if (this->stype != NetSocket::UNBOUND) {
+			printf("tried to call connect() on already bound socket!\n");
+			return false;
+		}
+		TRACE_SCOPE(NetSocket::TRACE_CONNECT);
+
+		this->addrType = ((addr_t*) address.addr)->sockaddrU.sa_family;
+		this->handle = ::socket(((addr_t*) address.addr)->sockaddrU.sa_family, SOCK_STREAM, addrProtocol((addr_t*) address.addr, false));
+		if (this->handle == -1) {
+			printError("error %d in Socket:connect:socket(): %s\n");
+			return false;
+		}
+
+		if (!applyProfile(this->handle, this->profile, NetSocket::STREAM)) {
+			::close(this->handle);
+			this->handle = -1;
+			return false;
+		}
+
+		// the connection is established in non blocking mode to be able to time out
+		if (!applyBlocking(this->handle, false)) {
+			::close(this->handle);
+			this->handle = -1;
+			return false;
+		}
+
+		int result = ::connect(this->handle, &((addr_t*) address.addr)->sockaddrU, addrLength((addr_t*) address.addr));
+		if (result == -1) {
+			if (errno == EINPROGRESS || errno == EAGAIN) {
+
+				struct pollfd fd = {
+					.fd = this->handle,
+					.events = POLLIN | POLLOUT,
+					.revents = 0
+				};
+				result = ::poll(&fd, 1U, (int) timeout);
+				int error = 0;
+				socklen_t optlen = sizeof(int);
+				if (result <= 0 || ::getsockopt(this->handle, SOL_SOCKET, SO_ERROR, &error, &optlen) == -1 || error != 0) {
+					if (result != 0) {
+						if (error != 0) errno = error;
+						printError("error %d in Socket:connect:connect(): %s\n");
+					}
+					::close(this->handle);
+					this->handle = -1;
+					return false; // timed out or refused
+				}
+
+			} else {
+				printError("error %d in Socket:connect:connect(): %s\n");
+				::close(this->handle);
+				this->handle = -1;
+				return false;
+			}
+		}
+
+		if (!applyBlocking(this->handle, this->blocking)) {
+			::close(this->handle);
+			this->handle = -1;
+			return false;
+		}
+
+		this->remoteLength = addrLength((addr_t*) address.addr);
+		memcpy(&this->remoteAddress, address.addr, this->remoteLength);
+		setOpen(NetSocket::STREAM);
+		return true;
+	}
+
+	bool connectFastOpen(const NetSocket::INetAddress& address, unsigned long timeout, const char* buffer, unsigned int length, bool* fastOpenUsed) override {
+		if (this->stype != NetSocket::UNBOUND) {
+			printf("tried to call connectFastOpen() on already bound socket!\n");
+			return false;
+		}
+
+		*fastOpenUsed = false;
+		if (((addr_t*) address.addr)->sockaddrU.sa_family == AF_UNIX || length == 0) {
+			// no handshake to save on local sockets
+			return connect(address, timeout) && (length == 0 || send(buffer, length));
+		}
+		TRACE_SCOPE(NetSocket::TRACE_CONNECT);
+
+		this->addrType = ((addr_t*) address.addr)->sockaddrU.sa_family;
+		this->handle = ::socket(((addr_t*) address.addr)->sockaddrU.sa_family, SOCK_STREAM, IPPROTO_TCP);
+		if (this->handle == -1) {
+			printError("error %d in Socket:connectFastOpen:socket(): %s\n");
+			return false;
+		}
+
+		if (!applyProfile(this->handle, this->profile, NetSocket::STREAM)) {
+			::close(this->handle);
+			this->handle = -1;
+			return false;
+		}
+
+		if (!applyBlocking(this->handle, false)) {
+			::close(this->handle);
+			this->handle = -1;
+			return false;
+		}
+
+		// sends the SYN with the data if an cookie is cached, otherwise an cookie is requested and the data has to be sent normally
+		int result = ::sendto(this->handle, buffer, length, MSG_FASTOPEN | MSG_NOSIGNAL, &((addr_t*) address.addr)->sockaddrU, addrLength((addr_t*) address.addr));
+		unsigned int sent = result > 0 ? result : 0;
+		if (result == -1 && errno == EOPNOTSUPP) {
+			// fast open disabled on this system
+			result = ::connect(this->handle, &((addr_t*) address.addr)->sockaddrU, addrLength((addr_t*) address.addr));
+		}
+		if (result == -1 && errno != EINPROGRESS && errno != EAGAIN) {
+			printError("error %d in Socket:connectFastOpen:sendto(MSG_FASTOPEN): %s\n");
+			::close(this->handle);
+			this->handle = -1;
+			return false;
+		}
+
+		struct pollfd fd = {
+			.fd = this->handle,
+			.events = POLLOUT,
+			.revents = 0
+		};
+		result = ::poll(&fd, 1UL, timeout == 0 ? -1 : (int) timeout);
+		int error = 0;
+		socklen_t optlen = sizeof(int);
+		if (result <= 0 || ::getsockopt(this->handle, SOL_SOCKET, SO_ERROR, &error, &optlen) == -1 || error != 0) {
+			if (result != 0) {
+				if (error != 0) errno = error;
+				printError("error %d in Socket:connectFastOpen:connect(): %s\n");
+			}
+			::close(this->handle);
+			this->handle = -1;
+			return false; // timed out or refused
+		}
+
+		if (!applyBlocking(this->handle, this->blocking)) {
+			::close(this->handle);
+			this->handle = -1;
+			return false;
+		}
+
+		this->remoteLength = addrLength((addr_t*) address.addr);
+		memcpy(&this->remoteAddress, address.addr, this->remoteLength);
+		setOpen(NetSocket::STREAM);
+		if (sent < length && !send(buffer + sent, length - sent))
+			return false;
+
+		struct tcp_info info;
+		optlen = sizeof(struct tcp_info);
+		if (::getsockopt(this->handle, IPPROTO_TCP, TCP_INFO, &info, &optlen) == 0)
+			*fastOpenUsed = (info.tcpi_options & TCPI_OPT_SYN_DATA) != 0;
+
+		return true;
+	}
+
+	void close() override {
+		unsigned int users = this->users.load(std::memory_order_relaxed);
+		do {
+			if (users & HANDLE_CLOSING) return; // not open or already closing
+		} while (!this->users.compare_exchange_weak(users, users == 0 ? HANDLE_CLOSING : (users + 1) | HANDLE_CLOSING | HANDLE_SHUT_DOWN, std::memory_order_acq_rel, std::memory_order_relaxed));
+		if (users == 0) {
+			closeHandle();
+		} else {
+			// wakes up the calls blocked on the handle, the own reference keeps it from being closed and reused meanwhile
+			::shutdown(this->handle, SHUT_RDWR);
+			releaseHandle();
+		}
+	}
+
+	/*
+	 * Releases the handle after close() once no call uses it anymore, derived sockets release their own resources here
+	 * The type is reset last, so the socket can not be opened again before the old handle is closed
+	 */
+	virtual void closeHandle() {
+		int handle = this->handle;
+		this->handle = -1;
+		this->remoteLength = 0;
+		::close(handle);
+		this->stype = NetSocket::UNBOUND;
+	}
+
+	bool isOpen() override {
+		return (this->users.load(std::memory_order_relaxed) & HANDLE_CLOSING) == 0;
+	}
+
+	/*
+	 * Sets or clears O_NONBLOCK on an handle
+	 */
+	static bool applyBlocking(int handle, bool blocking) {
+		int flags = ::fcntl(handle, F_GETFL, 0);
+		if (flags == -1 || ::fcntl(handle, F_SETFL, blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK) == -1) {
+			printError("error %d in Socket:applyBlocking:fcntl(O_NONBLOCK): %s\n");
+			return false;
+		}
+		return true;
+	}
+
+	/*
+	 * Waits until data can be read, returns immediately in non blocking mode
+	 * Returns false if poll failed or the socket was closed while waiting
+	 */
+	bool waitReadable(const char* errorFormat) {
+		if (!this->blocking) return true;
+		struct pollfd fd = {
+			.fd = this->handle,
+			.events = POLLIN,
+			.revents = 0
+		};
+		int result = 0;
+		TRACE_BEGIN(waitStart);
+		while (((result = ::poll(&fd, 1UL, READ_SOCKET_TIMEOUT)) == 0 || (result == -1 && errno == EINTR)) && isOpen());
+		TRACE_END(NetSocket::TRACE_RECEIVE_WAIT, waitStart);
+		if (result < 0 && isOpen()) {
+			printError(errorFormat);
+			return false;
+		}
+		return isOpen();
+	}
+
+	/*
+	 * Waits until data can be written
+	 * Returns false if poll failed or the socket was closed while waiting
+	 */
+	bool waitWritable(const char* errorFormat) {
+		struct pollfd fd = {
+			.fd = this->handle,
+			.events = POLLOUT,
+			.revents = 0
+		};
+		int result = 0;
+		while (((result = ::poll(&fd, 1UL, READ_SOCKET_TIMEOUT)) == 0 || (result == -1 && errno == EINTR)) && isOpen());
+		if (result < 0 && isOpen()) {
+			printError(errorFormat);
+			return false;
+		}
+		return isOpen();
+	}
+
+	/*
+	 * Returns true if data is buffered in user space and can be received without the handle being readable
+	 */
+	virtual bool hasPendingData() {
+		return false;
+	}
+
+	/*
+	 * Returns the handle pollMany() waits on for this socket
+	 */
+	virtual int pollHandle() {
+		return this->handle;
+	}
+
+	bool setBlocking(bool blocking) override {
+		this->blocking = blocking;
+		if (this->stype == NetSocket::UNBOUND)
+			return true;
+		HandleUse use(this);
+		if (!use) return true; // closed by another thread
+		return applyBlocking(this->handle, blocking);
+	}
+
+	bool getBlocking(bool* blocking) override {
+		*blocking = this->blocking;
+		return true;
+	}
+
+	bool trySend(const char* buffer, unsigned int length, unsigned int* sent, bool* wouldBlock) override {
+		if (this->stype != NetSocket::STREAM) {
+			printf("tried to call trySend() on non STREAM socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*sent = 0;
+		*wouldBlock = false;
+		TRACE_BEGIN(sendStart);
+		int result = ::send(this->handle, buffer, length, MSG_DONTWAIT | MSG_NOSIGNAL);
+		TRACE_END(NetSocket::TRACE_SEND, sendStart);
+		if (result == -1) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				*wouldBlock = true;
+				return true;
+			} else if (errno == ECONNRESET || errno == EPIPE)
+				return false; // connection closed
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:trySend:send(): %s\n");
+			return false;
+		}
+
+		*sent = result;
+		*wouldBlock = (unsigned int) result < length;
+		return true;
+	}
+
+	bool trySendGather(const NetSocket::SendBuffer* buffers, unsigned int count, unsigned int* sent, bool* wouldBlock) override {
+		if (this->stype != NetSocket::STREAM) {
+			printf("tried to call trySendGather() on non STREAM socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*sent = 0;
+		*wouldBlock = false;
+		if (count > SEND_GATHER_SIZE) count = SEND_GATHER_SIZE;
+		struct iovec payloads[SEND_GATHER_SIZE];
+		size_t length = 0;
+		for (unsigned int i = 0; i < count; i++) {
+			payloads[i].iov_base = (void*) buffers[i].buffer;
+			payloads[i].iov_len = buffers[i].length;
+			length += buffers[i].length;
+		}
+		struct msghdr message;
+		memset(&message, 0, sizeof(message));
+		message.msg_iov = payloads;
+		message.msg_iovlen = count;
+
+		TRACE_BEGIN(sendStart);
+		ssize_t result = ::sendmsg(this->handle, &message, MSG_DONTWAIT | MSG_NOSIGNAL);
+		TRACE_END(NetSocket::TRACE_SEND, sendStart);
+		if (result == -1) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				*wouldBlock = true;
+				return true;
+			} else if (errno == ECONNRESET || errno == EPIPE)
+				return false; // connection closed
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:trySendGather:sendmsg(): %s\n");
+			return false;
+		}
+
+		*sent = result;
+		*wouldBlock = (size_t) result < length;
+		return true;
+	}
+
+	bool tryReceive(char* buffer, unsigned int length, unsigned int* received, bool* wouldBlock) override {
+		if (this->stype != NetSocket::STREAM) {
+			printf("tried to call tryReceive() on non STREAM socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*received = 0;
+		*wouldBlock = false;
+		TRACE_BEGIN(receiveStart);
+		int result = ::recv(this->handle, buffer, length, MSG_DONTWAIT);
+		TRACE_END(NetSocket::TRACE_RECEIVE, receiveStart);
+		if (result == 0) {
+			return false; // connection closed
+		} else if (result == -1) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				*wouldBlock = true;
+				return true;
+			} else if (errno == ECONNRESET)
+				return false; // connection closed
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:tryReceive:recv(): %s\n");
+			return false;
+		}
+
+		*received = result;
+		return true;
+	}
+
+	bool send(const char* buffer, unsigned int length) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call send() on unbound socket!\n");
+			return false;
+		} else if (this->stype != NetSocket::STREAM) {
+			printf("tried to call send() on non STREAM socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		while (length > 0) {
+			TRACE_BEGIN(sendStart);
+			int result = ::send(this->handle, buffer, length, MSG_NOSIGNAL);
+			TRACE_END(NetSocket::TRACE_SEND, sendStart);
+			if (result == -1) {
+				if ((errno == EAGAIN || errno == EWOULDBLOCK) && !this->blocking) {
+					// send() always transmits the whole buffer, only trySend() returns early in non blocking mode
+					if (!waitWritable("error %d in Socket:send:poll(): %s\n"))
+						return false;
+					continue;
+				}
+				if (errno == ETIMEDOUT)
+					return true; // timed out
+				else if (errno == EAGAIN || errno == EWOULDBLOCK)
+					return false; // send timeout expired with only part of the buffer sent
+				else if (errno == ECONNRESET || errno == EPIPE)
+					return false; // connection closed
+				if (errno == EBADF || errno == EIO) {
+					close();
+					return false;
+				}
+				printError("error %d in Socket:send:send(): %s\n");
+				return false;
+			}
+			buffer += result;
+			length -= result;
+		}
+
+		return true;
+	}
+
+	bool receive(char* buffer, unsigned int length, unsigned int* received) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call send() on unbound socket!\n");
+			return false;
+		} else if (this->stype != NetSocket::STREAM) {
+			printf("tried to call send() on non STREAM socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*received = 0;
+		if (!waitReadable("error %d in Socket:receive:poll(): %s\n"))
+			return false;
+
+		TRACE_BEGIN(receiveStart);
+		int result = ::recv(this->handle, buffer, length, 0);
+		TRACE_END(NetSocket::TRACE_RECEIVE, receiveStart);
+		if (result == 0) {
+			return false; // connection closed
+		} else if (result < 0) {
+			if (errno == ETIMEDOUT || errno == EAGAIN || errno == EWOULDBLOCK)
+				return true; // timed out or nothing to read in non blocking mode
+			else if (errno == ECONNRESET)
+				return false; // connection closed
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:receive:recv(): %s\n");
+			return false;
+		} else {
+			*received = result;
+		}
+
+		return true;
+	}
+
+	bool receivefrom(NetSocket::INetAddress& address, char* buffer, unsigned int length, unsigned int* received) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call receivefrom() on unbound socket!\n");
+			return false;
+		} else if (this->stype != NetSocket::LISTEN_UDP) {
+			printf("tried to call receivefrom() on non LISTEN_UDP socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		timeval rcvtimeout;
+		rcvtimeout.tv_sec = 1;
+		rcvtimeout.tv_usec = 0;
+
+		*received = 0;
+		int result;
+		do {
+			if (!waitReadable("error %d in Socket:receivefrom:poll(): %s\n"))
+				return false;
+
+			socklen_t senderAdressLen = sizeof(addr_t);
+			if (this->addrType == AF_UNIX)
+				memset(address.addr, 0, sizeof(addr_t)); // the sender might be unnamed
+			TRACE_BEGIN(receiveStart);
+			result = ::recvfrom(this->handle, buffer, length, 0, &((addr_t*) address.addr)->sockaddrU, &senderAdressLen);
+			TRACE_END(NetSocket::TRACE_RECEIVE, receiveStart);
+		} while (result >= 0 && isDenied((addr_t*) address.addr));
+		if (result == 0) {
+			return false; // connection closed
+		} else if (result == -1) {
+			if (errno == ETIMEDOUT || errno == EAGAIN || errno == EWOULDBLOCK)
+				return true; // timed out or nothing to read in non blocking mode
+			else if (errno == ECONNRESET)
+				return false; // connection closed
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:receivefrom:recvfrom(): %s\n");
+			return false;
+		} else {
+			*received = result;
+		}
+
+		return true;
+
+	}
+
+	bool sendto(const NetSocket::INetAddress& address, const char* buffer, unsigned int length) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call sendto() on unbound socket!\n");
+			return false;
+		} else if (this->stype != NetSocket::LISTEN_UDP) {
+			printf("tried to call sendto() on non LISTEN_UDP socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		if (((addr_t*) address.addr)->sockaddrU.sa_family != this->addrType) {
+			printf("tried to call receivefrom() with invalid address type for this socket!\n");
+			return false;
+		}
+
+		TRACE_BEGIN(sendStart);
+		int result = ::sendto(this->handle, buffer, length, 0, &((addr_t*) address.addr)->sockaddrU, addrLength((addr_t*) address.addr));
+		TRACE_END(NetSocket::TRACE_SEND, sendStart);
+		if (result == -1) {
+			if (errno == ETIMEDOUT)
+				return true; // timed out
+			else if (errno == ECONNRESET)
+				return false; // connection closed
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:sendto:sendto(): %s\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool enableTimestamps(bool receive, bool transmit) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call enableTimestamps() on unbound socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		int flags = 0;
+		if (receive)
+			flags |= SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_RX_HARDWARE;
+		if (transmit)
+			flags |= SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_TX_HARDWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+		if (flags != 0)
+			flags |= SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+
+		if (::setsockopt(this->handle, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(int)) == -1) {
+			// older kernels and some socket families only support software receive timestamps
+			int enable = receive ? 1 : 0;
+			if (transmit || ::setsockopt(this->handle, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(int)) == -1) {
+				printError("error %d in Socket:enableTimestamps:setsockopt(SO_TIMESTAMPING): %s\n");
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/*
+	 * Reads the timestamps from the control messages of an received message
+	 */
+	static void readTimestamp(struct msghdr* message, NetSocket::Timestamp* timestamp) {
+		timestamp->software = 0;
+		timestamp->hardware = 0;
+		for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(message); cmsg != 0; cmsg = CMSG_NXTHDR(message, cmsg)) {
+			if (cmsg->cmsg_level != SOL_SOCKET) continue;
+			if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+				struct timespec times[3];
+				memcpy(times, CMSG_DATA(cmsg), sizeof(times));
+				timestamp->software = times[0].tv_sec * 1000000000ULL + times[0].tv_nsec;
+				timestamp->hardware = times[2].tv_sec * 1000000000ULL + times[2].tv_nsec;
+			} else if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+				struct timespec time;
+				memcpy(&time, CMSG_DATA(cmsg), sizeof(time));
+				timestamp->software = time.tv_sec * 1000000000ULL + time.tv_nsec;
+			}
+		}
+	}
+
+	/*
+	 * Receives data and the timestamp control messages, used by receiveTimestamped() and receivefromTimestamped()
+	 */
+	bool receiveMessage(addr_t* address, char* buffer, unsigned int length, unsigned int* received, NetSocket::Timestamp* timestamp) {
+		if (!waitReadable("error %d in Socket:receiveMessage:poll(): %s\n"))
+			return false;
+
+		struct iovec payload = {
+			.iov_base = buffer,
+			.iov_len = length
+		};
+		char control[256];
+		struct msghdr message;
+		memset(&message, 0, sizeof(struct msghdr));
+		if (address != 0) {
+			if (this->addrType == AF_UNIX)
+				memset(address, 0, sizeof(addr_t)); // the sender might be unnamed
+			message.msg_name = &address->sockaddrU;
+			message.msg_namelen = sizeof(addr_t);
+		}
+		message.msg_iov = &payload;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+
+		TRACE_BEGIN(receiveStart);
+		int result = ::recvmsg(this->handle, &message, 0);
+		TRACE_END(NetSocket::TRACE_RECEIVE, receiveStart);
+		while (result >= 0 && address != 0 && isDenied(address)) {
+			// dropped, wait for the next datagram
+			if (!waitReadable("error %d in Socket:receiveMessage:poll(): %s\n"))
+				return false;
+			message.msg_namelen = sizeof(addr_t);
+			message.msg_controllen = sizeof(control);
+			result = ::recvmsg(this->handle, &message, 0);
+		}
+		if (result == 0 && address == 0) {
+			return false; // connection closed
+		} else if (result == -1) {
+			if (errno == ETIMEDOUT || errno == EAGAIN)
+				return true; // timed out
+			else if (errno == ECONNRESET)
+				return false; // connection closed
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:receiveMessage:recvmsg(): %s\n");
+			return false;
+		}
+
+		*received = result;
+		readTimestamp(&message, timestamp);
+		return true;
+	}
+
+	bool receiveTimestamped(char* buffer, unsigned int length, unsigned int* received, NetSocket::Timestamp* timestamp) override {
+		if (this->stype != NetSocket::STREAM) {
+			printf("tried to call receiveTimestamped() on non STREAM socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*received = 0;
+		return receiveMessage(0, buffer, length, received, timestamp);
+	}
+
+	bool receivefromTimestamped(NetSocket::INetAddress& address, char* buffer, unsigned int length, unsigned int* received, NetSocket::Timestamp* timestamp) override {
+		if (this->stype != NetSocket::LISTEN_UDP) {
+			printf("tried to call receivefromTimestamped() on non LISTEN_UDP socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*received = 0;
+		return receiveMessage((addr_t*) address.addr, buffer, length, received, timestamp);
+	}
+
+	bool receiveTransmitTimestamp(unsigned int* id, NetSocket::Timestamp* timestamp, bool* available) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call receiveTransmitTimestamp() on unbound socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*available = false;
+		char control[512];
+		struct msghdr message;
+		memset(&message, 0, sizeof(struct msghdr));
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+
+		// timestamps are reported trough the error queue, without the payload since SOF_TIMESTAMPING_OPT_TSONLY is set
+		while (::recvmsg(this->handle, &message, MSG_ERRQUEUE | MSG_DONTWAIT) != -1) {
+			bool timestampMessage = false;
+			for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != 0; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+				if ((cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR) || (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+					struct sock_extended_err error;
+					memcpy(&error, CMSG_DATA(cmsg), sizeof(struct sock_extended_err));
+					if (error.ee_errno == ENOMSG && error.ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+						*id = error.ee_data;
+						timestampMessage = true;
+					}
+				}
+			}
+			if (timestampMessage) {
+				readTimestamp(&message, timestamp);
+				*available = true;
+				return true;
+			}
+			// some other error report, skip it
+			message.msg_controllen = sizeof(control);
+		}
+
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return true; // nothing queued
+		if (errno == EBADF || errno == EIO) {
+			close();
+			return false;
+		}
+		printError("error %d in Socket:receiveTransmitTimestamp:recvmsg(): %s\n");
+		return false;
+	}
+
+	bool receivefromBatch(NetSocket::Datagram* datagrams, unsigned int count, unsigned int* receivedCount) override {
+		if (this->stype != NetSocket::LISTEN_UDP) {
+			printf("tried to call receivefromBatch() on non LISTEN_UDP socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		return receiveBatch(datagrams, count, receivedCount, this->blocking);
+	}
+
+	/*
+	 * Implements receivefromBatch(), waits for datagrams only if wait is set instead of following the blocking mode
+	 * The caller has to hold an HandleUse
+	 */
+	bool receiveBatch(NetSocket::Datagram* datagrams, unsigned int count, unsigned int* receivedCount, bool wait) {
+		*receivedCount = 0;
+		if (count > UDP_BATCH_SIZE) count = UDP_BATCH_SIZE;
+		struct mmsghdr messages[UDP_BATCH_SIZE];
+		struct iovec payloads[UDP_BATCH_SIZE];
+		memset(messages, 0, sizeof(struct mmsghdr) * count);
+		for (unsigned int i = 0; i < count; i++) {
+			if (this->addrType == AF_UNIX)
+				memset(datagrams[i].address.addr, 0, sizeof(addr_t)); // the sender might be unnamed
+			payloads[i].iov_base = datagrams[i].buffer;
+			payloads[i].iov_len = datagrams[i].length;
+			messages[i].msg_hdr.msg_name = &((addr_t*) datagrams[i].address.addr)->sockaddrU;
+			messages[i].msg_hdr.msg_namelen = sizeof(addr_t);
+			messages[i].msg_hdr.msg_iov = &payloads[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		unsigned int accepted = 0;
+		int result;
+		do {
+			// under load the queue is never empty, so try to receive first and only poll if there is nothing to read
+			result = ::recvmmsg(this->handle, messages, count, MSG_DONTWAIT, 0);
+			while (result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK) && wait) {
+				if (!waitReadable("error %d in Socket:receivefromBatch:poll(): %s\n"))
+					return false;
+				result = ::recvmmsg(this->handle, messages, count, MSG_DONTWAIT, 0);
+			}
+
+			if (result == -1) {
+				if (errno == ETIMEDOUT || errno == EAGAIN || errno == EWOULDBLOCK)
+					return true; // timed out or nothing to read in non blocking mode
+				else if (errno == ECONNRESET || errno == ECONNREFUSED)
+					return false; // connection closed
+				if (errno == EBADF || errno == EIO) {
+					close();
+					return false;
+				}
+				printError("error %d in Socket:receivefromBatch:recvmmsg(): %s\n");
+				return false;
+			}
+
+			for (int i = 0; i < result; i++) {
+				datagrams[i].received = messages[i].msg_len;
+				if (isDenied((addr_t*) datagrams[i].address.addr)) continue;
+				if (accepted != (unsigned int) i) {
+					// move the datagram to the front without copying its payload or address
+					std::swap(datagrams[accepted].address.addr, datagrams[i].address.addr);
+					std::swap(datagrams[accepted].buffer, datagrams[i].buffer);
+					std::swap(datagrams[accepted].length, datagrams[i].length);
+					std::swap(datagrams[accepted].received, datagrams[i].received);
+				}
+				accepted++;
+			}
+			for (int i = 0; i < result; i++)
+				messages[i].msg_hdr.msg_namelen = sizeof(addr_t);
+		} while (accepted == 0 && result > 0 && wait); // only denied datagrams, wait for the next ones
+
+		*receivedCount = accepted;
+		return true;
+	}
+
+	bool sendtoBatch(const NetSocket::Datagram* datagrams, unsigned int count, unsigned int* sentCount) override {
+		if (this->stype != NetSocket::LISTEN_UDP) {
+			printf("tried to call sendtoBatch() on non LISTEN_UDP socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*sentCount = 0;
+		if (count > UDP_BATCH_SIZE) count = UDP_BATCH_SIZE;
+		struct mmsghdr messages[UDP_BATCH_SIZE];
+		struct iovec payloads[UDP_BATCH_SIZE];
+		memset(messages, 0, sizeof(struct mmsghdr) * count);
+		for (unsigned int i = 0; i < count; i++) {
+			addr_t* address = (addr_t*) datagrams[i].address.addr;
+			if (address->sockaddrU.sa_family != this->addrType) {
+				printf("tried to call sendtoBatch() with invalid address type for this socket!\n");
+				return false;
+			}
+			payloads[i].iov_base = datagrams[i].buffer;
+			payloads[i].iov_len = datagrams[i].length;
+			messages[i].msg_hdr.msg_name = &address->sockaddrU;
+			messages[i].msg_hdr.msg_namelen = addrLength(address);
+			messages[i].msg_hdr.msg_iov = &payloads[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		TRACE_BEGIN(sendStart);
+		int result = ::sendmmsg(this->handle, messages, count, 0);
+		TRACE_END(NetSocket::TRACE_SEND, sendStart);
+		if (result == -1) {
+			if (errno == ETIMEDOUT || errno == EAGAIN || errno == EWOULDBLOCK)
+				return true; // timed out or send buffer full in non blocking mode
+			else if (errno == ECONNRESET)
+				return false; // connection closed
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:sendtoBatch:sendmmsg(): %s\n");
+			return false;
+		}
+
+		*sentCount = result;
+		return true;
+	}
+
+	bool setCongestionControl(const char* algorithm) override {
+		if ((this->stype != NetSocket::STREAM && this->stype != NetSocket::LISTEN_TCP) || this->addrType == AF_UNIX) {
+			printf("tried to call setCongestionControl() on non TCP socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		if (::setsockopt(this->handle, IPPROTO_TCP, TCP_CONGESTION, algorithm, strlen(algorithm)) == -1) {
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:setCongestionControl:setsockopt(TCP_CONGESTION): %s\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool getCongestionControl(std::string& algorithm) override {
+		if ((this->stype != NetSocket::STREAM && this->stype != NetSocket::LISTEN_TCP) || this->addrType == AF_UNIX) {
+			printf("tried to call getCongestionControl() on non TCP socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		char name[16]; // TCP_CA_NAME_MAX
+		socklen_t optlen = sizeof(name);
+		if (::getsockopt(this->handle, IPPROTO_TCP, TCP_CONGESTION, name, &optlen) == -1) {
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:getCongestionControl:getsockopt(TCP_CONGESTION): %s\n");
+			return false;
+		}
+
+		algorithm.assign(name, strnlen(name, optlen));
+		return true;
+	}
+
+	bool getStats(NetSocket::ConnectionStats* stats) override {
+		if (this->stype != NetSocket::STREAM || this->addrType == AF_UNIX) {
+			printf("tried to call getStats() on non TCP STREAM socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		if (!readStats(this->handle, stats)) {
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:getStats:getsockopt(TCP_INFO): %s\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	/*
+	 * Joins or leaves an multicast group using the protocol independent group requests of RFC 3678
+	 */
+	bool changeGroup(const NetSocket::INetAddress& groupAddress, const NetSocket::INetAddress* sourceAddress, unsigned int interfaceIndex, bool join) {
+		if (this->stype != NetSocket::LISTEN_UDP || this->addrType == AF_UNIX) {
+			printf("tried to call joinGroup()/leaveGroup() on non LISTEN_UDP socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		const addr_t* group = (addr_t*) groupAddress.addr;
+		if (group->sockaddrU.sa_family != this->addrType || (sourceAddress != 0 && ((addr_t*) sourceAddress->addr)->sockaddrU.sa_family != this->addrType)) {
+			printf("tried to call joinGroup()/leaveGroup() with invalid address type for this socket!\n");
+			return false;
+		}
+
+		int level = this->addrType == AF_INET6 ? IPPROTO_IPV6 : IPPROTO_IP;
+		int result;
+		if (sourceAddress == 0) {
+			struct group_req request;
+			memset(&request, 0, sizeof(struct group_req));
+			request.gr_interface = interfaceIndex;
+			memcpy(&request.gr_group, group, addrLength(group));
+			result = ::setsockopt(this->handle, level, join ? MCAST_JOIN_GROUP : MCAST_LEAVE_GROUP, &request, sizeof(struct group_req));
+		} else {
+			struct group_source_req request;
+			memset(&request, 0, sizeof(struct group_source_req));
+			request.gsr_interface = interfaceIndex;
+			memcpy(&request.gsr_group, group, addrLength(group));
+			memcpy(&request.gsr_source, sourceAddress->addr, addrLength((addr_t*) sourceAddress->addr));
+			result = ::setsockopt(this->handle, level, join ? MCAST_JOIN_SOURCE_GROUP : MCAST_LEAVE_SOURCE_GROUP, &request, sizeof(struct group_source_req));
+		}
+
+		if (result == -1) {
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError(join ? "error %d in Socket:joinGroup:setsockopt(MCAST_JOIN_GROUP): %s\n" : "error %d in Socket:leaveGroup:setsockopt(MCAST_LEAVE_GROUP): %s\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool joinGroup(const NetSocket::INetAddress& groupAddress, const NetSocket::INetAddress* sourceAddress, unsigned int interfaceIndex) override {
+		return changeGroup(groupAddress, sourceAddress, interfaceIndex, true);
+	}
+
+	bool leaveGroup(const NetSocket::INetAddress& groupAddress, const NetSocket::INetAddress* sourceAddress, unsigned int interfaceIndex) override {
+		return changeGroup(groupAddress, sourceAddress, interfaceIndex, false);
+	}
+
+	bool sendSocket(NetSocket::Socket& socket, const char* buffer, unsigned int length) override {
+		if (this->stype != NetSocket::STREAM || this->addrType != AF_UNIX) {
+			printf("tried to call sendSocket() on non unix STREAM socket!\n");
+			return false;
+		}
+		if (!socket.isOpen()) {
+			printf("tried to call sendSocket() with unbound socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		char zero = 0;
+		struct iovec payload = {
+			.iov_base = length > 0 ? (void*) buffer : (void*) &zero,
+			.iov_len = length > 0 ? length : 1
+		};
+		union {
+			char buffer[CMSG_SPACE(sizeof(int))];
+			struct cmsghdr align;
+		} control;
+		memset(&control, 0, sizeof(control));
+
+		struct msghdr message = {0};
+		message.msg_iov = &payload;
+		message.msg_iovlen = 1;
+		message.msg_control = control.buffer;
+		message.msg_controllen = sizeof(control.buffer);
+
+		struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+		header->cmsg_level = SOL_SOCKET;
+		header->cmsg_type = SCM_RIGHTS;
+		header->cmsg_len = CMSG_LEN(sizeof(int));
+		HandleUse transferred((SocketLin*) &socket);
+		if (!transferred) return false; // closed by another thread
+		int transferredHandle = ((SocketLin&) socket).handle;
+		memcpy(CMSG_DATA(header), &transferredHandle, sizeof(int));
+
+		if (::sendmsg(this->handle, &message, MSG_NOSIGNAL) == -1) {
+			if (errno == ECONNRESET || errno == EPIPE)
+				return false; // connection closed
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:sendSocket:sendmsg(): %s\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool receiveSocket(NetSocket::Socket& socket, char* buffer, unsigned int length, unsigned int* received) override {
+		if (this->stype != NetSocket::STREAM || this->addrType != AF_UNIX) {
+			printf("tried to call receiveSocket() on non unix STREAM socket!\n");
+			return false;
+		}
+		if (((SocketLin&) socket).stype != NetSocket::UNBOUND) {
+			printf("tried to call receiveSocket() with already bound socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		if (!waitReadable("error %d in Socket:receiveSocket:poll(): %s\n"))
+			return false;
+
+		char zero = 0;
+		struct iovec payload = {
+			.iov_base = length > 0 ? (void*) buffer : (void*) &zero,
+			.iov_len = length > 0 ? length : 1
+		};
+		union {
+			char buffer[CMSG_SPACE(sizeof(int) * 4)];
+			struct cmsghdr align;
+		} control;
+
+		struct msghdr message = {0};
+		message.msg_iov = &payload;
+		message.msg_iovlen = 1;
+		message.msg_control = control.buffer;
+		message.msg_controllen = sizeof(control.buffer);
+
+		int result = ::recvmsg(this->handle, &message, MSG_CMSG_CLOEXEC);
+		if (result == 0) {
+			return false; // connection closed
+		} else if (result < 0) {
+			if (errno == ECONNRESET || errno == EAGAIN || errno == EWOULDBLOCK)
+				return false; // connection closed
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:receiveSocket:recvmsg(): %s\n");
+			return false;
+		}
+		*received = length > 0 ? result : 0;
+
+		int clientSocket = -1;
+		for (struct cmsghdr* header = CMSG_FIRSTHDR(&message); header != 0; header = CMSG_NXTHDR(&message, header)) {
+			if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) continue;
+			int count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+			for (int i = 0; i < count; i++) {
+				int handle;
+				memcpy(&handle, CMSG_DATA(header) + i * sizeof(int), sizeof(int));
+				if (clientSocket == -1)
+					clientSocket = handle;
+				else
+					::close(handle); // only one handle is expected per message
+			}
+		}
+		if (clientSocket == -1) {
+			printf("no socket handle received in receiveSocket()!\n");
+			return false;
+		}
+		if (message.msg_flags & MSG_CTRUNC)
+			printf("socket handles were dropped in receiveSocket()!\n");
+
+		int socketType = 0, listening = 0, domain = 0;
+		socklen_t optlen = sizeof(int);
+		bool b1 = ::getsockopt(clientSocket, SOL_SOCKET, SO_TYPE, &socketType, &optlen) == 0;
+		optlen = sizeof(int);
+		bool b2 = ::getsockopt(clientSocket, SOL_SOCKET, SO_ACCEPTCONN, &listening, &optlen) == 0;
+		optlen = sizeof(int);
+		bool b3 = ::getsockopt(clientSocket, SOL_SOCKET, SO_DOMAIN, &domain, &optlen) == 0;
+		if (!b1 || !b2 || !b3) {
+			printError("error %d in Socket:receiveSocket:getsockopt(): %s\n");
+			::close(clientSocket);
+			return false;
+		}
+
+		NetSocket::SocketType type;
+		if (socketType == SOCK_STREAM) {
+			type = listening ? NetSocket::LISTEN_TCP : NetSocket::STREAM;
+		} else if (socketType == SOCK_DGRAM) {
+			type = NetSocket::LISTEN_UDP;
+		} else {
+			printf("received unsupported socket type %d in receiveSocket()!\n", socketType);
+			::close(clientSocket);
+			return false;
+		}
+
+		if (!applyBlocking(clientSocket, ((SocketLin&) socket).blocking)) {
+			::close(clientSocket);
+			return false;
+		}
+
+		((SocketLin&) socket).addrType = domain;
+		((SocketLin&) socket).handle = clientSocket;
+		((SocketLin&) socket).setOpen(type);
+		return true;
+	}
+
+	bool getPeerCredentials(int* pid, int* uid, int* gid) override {
+		if (this->stype == NetSocket::UNBOUND || this->addrType != AF_UNIX) {
+			printf("tried to call getPeerCredentials() on non unix socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		struct ucred credentials;
+		socklen_t optlen = sizeof(struct ucred);
+		if (::getsockopt(this->handle, SOL_SOCKET, SO_PEERCRED, &credentials, &optlen) == -1) {
+			if (errno == EBADF || errno == EIO) {
+				close();
+				return false;
+			}
+			printError("error %d in Socket:getPeerCredentials:getsockopt(SO_PEERCRED): %s\n");
+			return false;
+		}
+
+		*pid = credentials.pid;
+		*uid = credentials.uid;
+		*gid = credentials.gid;
+		return true;
+	}
+
+};
+
+#endif
+
+#endif /* LINNET_HPP_ */
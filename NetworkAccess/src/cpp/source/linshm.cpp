@@ -0,0 +1,744 @@
+#ifdef PLATFORM_LIN
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "linnet.hpp"
+#include "netsocket_shm.hpp"
+
+/*
+ * Number of polls on an empty/full ring before the thread goes to sleep on the futex
+ */
+#define SHM_SPIN_COUNT 4096
+#define SHM_CACHE_LINE 64
+
+/*
+ * Time in ms accept() waits for the client to send the shared memory handle, counted from the accept() call
+ */
+#define SHM_HANDSHAKE_TIMEOUT 5000
+
+/*
+ * Largest ring capacity, the rounding to an power of two must not overflow
+ */
+#define SHM_MAX_CAPACITY 0x80000000U
+
+/*
+ * Seals applied to the memfd, so the peer can not shrink it below the mapped size (which would raise SIGBUS on access)
+ */
+#define SHM_SEALS (F_SEAL_SHRINK | F_SEAL_GROW)
+
+/*
+ * Control block at the start of each ring, head and tail live on separate cache lines to avoid false sharing between the peers
+ */
+struct ShmRing {
+	alignas(SHM_CACHE_LINE) std::atomic<uint64_t> head; // written by the producer
+	alignas(SHM_CACHE_LINE) std::atomic<uint64_t> tail; // written by the consumer
+	alignas(SHM_CACHE_LINE) std::atomic<uint32_t> dataSignal;
+	std::atomic<uint32_t> dataWaiting;
+	std::atomic<uint32_t> spaceSignal;
+	std::atomic<uint32_t> spaceWaiting;
+	std::atomic<uint32_t> closed;
+	uint32_t capacity;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free, "shared memory rings require lock free atomics");
+
+#define SHM_RING_SIZE(capacity) (sizeof(ShmRing) + (capacity))
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	asm volatile("yield");
+#endif
+}
+
+inline void futexWait(std::atomic<uint32_t>* address, uint32_t value, unsigned long timeout) {
+	struct timespec time = {
+		.tv_sec = (time_t) (timeout / 1000),
+		.tv_nsec = (long) (timeout % 1000) * 1000000
+	};
+	::syscall(SYS_futex, (uint32_t*) address, FUTEX_WAIT, value, &time, 0, 0);
+}
+
+inline void futexWake(std::atomic<uint32_t>* address) {
+	::syscall(SYS_futex, (uint32_t*) address, FUTEX_WAKE, 1, 0, 0, 0);
+}
+
+inline unsigned long long monotonicMillis() {
+	struct timespec time;
+	::clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec * 1000ULL + time.tv_nsec / 1000000;
+}
+
+bool sendHandle(int channel, int handle, uint32_t capacity) {
+	struct iovec payload = {
+		.iov_base = &capacity,
+		.iov_len = sizeof(uint32_t)
+	};
+	union {
+		char buffer[CMSG_SPACE(sizeof(int))];
+		struct cmsghdr align;
+	} control;
+	memset(&control, 0, sizeof(control));
+
+	struct msghdr message = {0};
+	message.msg_iov = &payload;
+	message.msg_iovlen = 1;
+	message.msg_control = control.buffer;
+	message.msg_controllen = sizeof(control.buffer);
+
+	struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+	header->cmsg_level = SOL_SOCKET;
+	header->cmsg_type = SCM_RIGHTS;
+	header->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(header), &handle, sizeof(int));
+
+	if (::sendmsg(channel, &message, MSG_NOSIGNAL) != sizeof(uint32_t)) {
+		printError("error %d in SocketShm:sendHandle:sendmsg(): %s\n");
+		return false;
+	}
+	return true;
+}
+
+int receiveHandle(int channel, uint32_t* capacity, unsigned long timeout) {
+	struct iovec payload = {
+		.iov_base = capacity,
+		.iov_len = sizeof(uint32_t)
+	};
+	union {
+		char buffer[CMSG_SPACE(sizeof(int))];
+		struct cmsghdr align;
+	} control;
+
+	struct msghdr message = {0};
+	message.msg_iov = &payload;
+	message.msg_iovlen = 1;
+	message.msg_control = control.buffer;
+	message.msg_controllen = sizeof(control.buffer);
+
+	struct timeval time = {
+		.tv_sec = (time_t) (timeout / 1000),
+		.tv_usec = (suseconds_t) (timeout % 1000) * 1000
+	};
+	if (::setsockopt(channel, SOL_SOCKET, SO_RCVTIMEO, &time, sizeof(struct timeval)) == -1) {
+		printError("error %d in SocketShm:receiveHandle:setsockopt(): %s\n");
+		return -1;
+	}
+	ssize_t length = ::recvmsg(channel, &message, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+	if (length == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+		printf("timed out waiting for shared memory handle in SocketShm:receiveHandle()!\n");
+		return -1;
+	} else if (length != sizeof(uint32_t)) {
+		printError("error %d in SocketShm:receiveHandle:recvmsg(): %s\n");
+		return -1;
+	}
+	time.tv_sec = 0;
+	time.tv_usec = 0;
+	::setsockopt(channel, SOL_SOCKET, SO_RCVTIMEO, &time, sizeof(struct timeval));
+
+	struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+	if (header == 0 || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+		printf("no shared memory handle received in SocketShm:receiveHandle()!\n");
+		return -1;
+	}
+
+	int handle;
+	memcpy(&handle, CMSG_DATA(header), sizeof(int));
+	return handle;
+}
+
+class SocketShm : public NetSocket::Socket {
+
+public:
+	SocketLin control;
+	unsigned int capacity;
+	void* memory;
+	size_t memorySize;
+	ShmRing* sendRing;
+	ShmRing* receiveRing;
+	unsigned long readTimeout;
+	unsigned long writeTimeout;
+	bool blocking;
+	std::atomic<bool> rendezvousPending; // left pending by an non blocking accept(), completed by the first send or receive
+	unsigned long long rendezvousDeadline;
+	std::mutex rendezvousLock;
+
+	SocketShm(unsigned int capacity) {
+		this->capacity = 64;
+		while (this->capacity < capacity) this->capacity <<= 1;
+		this->memory = 0;
+		this->memorySize = 0;
+		this->sendRing = 0;
+		this->receiveRing = 0;
+		this->readTimeout = 0;
+		this->writeTimeout = 0;
+		this->blocking = true;
+		this->rendezvousPending = false;
+		this->rendezvousDeadline = 0;
+	}
+
+	~SocketShm() override {
+		close();
+		if (this->memory != 0)
+			::munmap(this->memory, this->memorySize);
+	}
+
+	NetSocket::SocketType type() override {
+		return this->control.stype;
+	}
+
+	int lastError() override {
+		return errno;
+	}
+
+	bool mapRings(int handle, bool connecting) {
+		if (this->memory != 0)
+			::munmap(this->memory, this->memorySize);
+		this->memorySize = 2 * SHM_RING_SIZE(this->capacity);
+		this->memory = ::mmap(0, this->memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0);
+		if (this->memory == MAP_FAILED) {
+			printError("error %d in SocketShm:mapRings:mmap(): %s\n");
+			this->memory = 0;
+			return false;
+		}
+
+		ShmRing* ring1 = (ShmRing*) this->memory;
+		ShmRing* ring2 = (ShmRing*) ((char*) this->memory + SHM_RING_SIZE(this->capacity));
+		if (connecting) {
+			// the memfd is zero initialized, which is a valid state for all atomics
+			ring1->capacity = ring2->capacity = this->capacity;
+		}
+		this->sendRing = connecting ? ring1 : ring2;
+		this->receiveRing = connecting ? ring2 : ring1;
+		return true;
+	}
+
+	bool getINet(NetSocket::INetAddress& address) override {
+		return this->control.getINet(address);
+	}
+
+	bool setNagle(bool enableBuffering) override {
+		if (this->control.stype != NetSocket::STREAM) {
+			printf("tried to call setNagle() on non stream socket!\n");
+			return false;
+		}
+		return true; // no buffering algorithm on shared memory
+	}
+
+	bool getNagle(bool* enableBuffering) override {
+		if (this->control.stype != NetSocket::STREAM) {
+			printf("tried to call getNagle() on non stream socket!\n");
+			return false;
+		}
+		*enableBuffering = false;
+		return true;
+	}
+
+	bool setOption(NetSocket::SocketOption option, int value) override {
+		printf("tried to call setOption() on shared memory socket!\n");
+		return false;
+	}
+
+	bool getOption(NetSocket::SocketOption option, int* value) override {
+		printf("tried to call getOption() on shared memory socket!\n");
+		return false;
+	}
+
+	bool setProfile(const NetSocket::SocketProfile& profile) override {
+		return true; // none of the options apply to shared memory
+	}
+
+	bool listen(const NetSocket::INetAddress& address) override {
+		if (((addr_t*) address.addr)->sockaddrU.sa_family != AF_UNIX) {
+			printf("tried to call listen() on shared memory socket with non unix address!\n");
+			return false;
+		}
+		this->control.blocking = this->blocking; // only the listen socket follows the mode, the rendezvous is always blocking
+		return this->control.listen(address);
+	}
+
+	bool accept(NetSocket::Socket& socket) override {
+		SocketShm* clientSocket = dynamic_cast<SocketShm*>(&socket);
+		if (clientSocket == 0) {
+			printf("tried to call accept() on shared memory socket with non shared memory socket!\n");
+			return false;
+		}
+
+		if (!this->control.accept(clientSocket->control))
+			return false;
+
+		// in non blocking mode the shared memory is received by the first send or receive, so an slow client does not stall the caller
+		clientSocket->rendezvousDeadline = monotonicMillis() + SHM_HANDSHAKE_TIMEOUT;
+		clientSocket->rendezvousPending = true;
+		bool pending = false;
+		return clientSocket->completeRendezvous(this->blocking, &pending);
+	}
+
+	/*
+	 * Receives and maps the shared memory sent by the client after accept(), waits for it if wait is set
+	 * Returns false and closes the connection if it is invalid or did not arrive in time, pending is set if it did not arrive yet
+	 */
+	bool completeRendezvous(bool wait, bool* pending) {
+		*pending = false;
+		if (!this->rendezvousPending.load(std::memory_order_acquire))
+			return true;
+		std::lock_guard<std::mutex> lock(this->rendezvousLock);
+		if (!this->rendezvousPending.load(std::memory_order_relaxed))
+			return true; // completed by the other thread meanwhile
+
+		unsigned long long now = monotonicMillis();
+		if (!wait) {
+			struct pollfd fd = {
+				.fd = this->control.handle,
+				.events = POLLIN,
+				.revents = 0
+			};
+			if (::poll(&fd, 1UL, 0) == 0 && now < this->rendezvousDeadline) {
+				*pending = true;
+				return true;
+			}
+		}
+
+		uint32_t capacity = 0;
+		int handle = -1;
+		if (now < this->rendezvousDeadline)
+			handle = receiveHandle(this->control.handle, &capacity, this->rendezvousDeadline - now);
+		else
+			printf("timed out waiting for shared memory handle in SocketShm:completeRendezvous()!\n");
+		if (handle == -1 || capacity == 0 || capacity > SHM_MAX_CAPACITY || (capacity & (capacity - 1)) != 0) {
+			if (handle != -1) ::close(handle);
+			this->control.close();
+			return false;
+		}
+
+		struct stat info;
+		int seals = ::fcntl(handle, F_GET_SEALS);
+		if (seals == -1 || (seals & SHM_SEALS) != SHM_SEALS || ::fstat(handle, &info) == -1 || (size_t) info.st_size < 2 * SHM_RING_SIZE(capacity)) {
+			printf("received invalid shared memory region in SocketShm:completeRendezvous()!\n");
+			::close(handle);
+			this->control.close();
+			return false;
+		}
+
+		this->capacity = capacity;
+		bool mapped = mapRings(handle, false);
+		::close(handle);
+		if (!mapped) {
+			this->control.close();
+			return false;
+		}
+
+		this->rendezvousPending.store(false, std::memory_order_release);
+		return true;
+	}
+
+	bool setFilter(const NetSocket::AddressFilter* filter) override {
+		printf("tried to call setFilter() on shared memory socket!\n");
+		return false;
+	}
+
+	bool setTimeouts(unsigned long readTimeout, unsigned long writeTimeout) override {
+		if (this->control.stype == NetSocket::UNBOUND) {
+			printf("tried to call setTimeouts() on unbound socket!\n");
+			return false;
+		}
+		this->readTimeout = readTimeout;
+		this->writeTimeout = writeTimeout;
+		return true;
+	}
+
+	bool getTimeouts(unsigned long* readTimeout, unsigned long* writeTimeout) override {
+		if (this->control.stype == NetSocket::UNBOUND) {
+			printf("tried to call getTimeouts() on unbound socket!\n");
+			return false;
+		}
+		*readTimeout = this->readTimeout;
+		*writeTimeout = this->writeTimeout;
+		return true;
+	}
+
+	bool connect(const NetSocket::INetAddress& address, unsigned long timeout) override {
+		if (((addr_t*) address.addr)->sockaddrU.sa_family != AF_UNIX) {
+			printf("tried to call connect() on shared memory socket with non unix address!\n");
+			return false;
+		}
+
+		if (!this->control.connect(address, timeout))
+			return false;
+
+		int handle = ::memfd_create("netsocket-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+		if (handle == -1) {
+			printError("error %d in SocketShm:connect:memfd_create(): %s\n");
+			this->control.close();
+			return false;
+		}
+
+		if (::ftruncate(handle, 2 * SHM_RING_SIZE(this->capacity)) == -1) {
+			printError("error %d in SocketShm:connect:ftruncate(): %s\n");
+			::close(handle);
+			this->control.close();
+			return false;
+		}
+
+		if (::fcntl(handle, F_ADD_SEALS, SHM_SEALS) == -1) {
+			printError("error %d in SocketShm:connect:fcntl(): %s\n");
+			::close(handle);
+			this->control.close();
+			return false;
+		}
+
+		bool mapped = mapRings(handle, true) && sendHandle(this->control.handle, handle, this->capacity);
+		::close(handle);
+		if (!mapped) {
+			this->control.close();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool connectFastOpen(const NetSocket::INetAddress& address, unsigned long timeout, const char* buffer, unsigned int length, bool* fastOpenUsed) override {
+		*fastOpenUsed = false;
+		return connect(address, timeout) && (length == 0 || send(buffer, length));
+	}
+
+	void close() override {
+		if (this->sendRing != 0) {
+			this->sendRing->closed.store(1);
+			this->receiveRing->closed.store(1);
+			this->sendRing->dataSignal.fetch_add(1);
+			futexWake(&this->sendRing->dataSignal);
+			this->receiveRing->spaceSignal.fetch_add(1);
+			futexWake(&this->receiveRing->spaceSignal);
+		}
+		this->control.close();
+	}
+
+	bool isOpen() override {
+		return this->control.isOpen();
+	}
+
+	/*
+	 * Called if the indices of an ring are inconsistent, which only happens if the peer wrote garbage into the shared memory
+	 * The connection is treated as closed, so the indices are never used to access memory outside of the ring
+	 */
+	bool ringViolation(ShmRing* ring, const char* function) {
+		printf("invalid ring state in SocketShm:%s(), closing connection!\n", function);
+		ring->closed.store(1);
+		return false;
+	}
+
+	/*
+	 * Checks if the peer is still alive, since an crashed process will never set the closed flag
+	 */
+	bool peerAlive(ShmRing* ring) {
+		if (ring->closed.load() || !this->control.isOpen()) return false;
+		struct pollfd fd = {
+			.fd = this->control.handle,
+			.events = POLLRDHUP,
+			.revents = 0
+		};
+		return ::poll(&fd, 1UL, 0) == 0;
+	}
+
+	/*
+	 * Waits until the value returned by the condition changes, spins first and then sleeps on the futex
+	 * Returns false if the timeout expired or the connection was closed
+	 */
+	template<typename Condition>
+	bool waitFor(ShmRing* ring, std::atomic<uint32_t>* signal, std::atomic<uint32_t>* waiting, unsigned long timeout, Condition condition) {
+		// spinning only helps if the peer runs on an other cpu at the same time
+		static const int spinCount = ::sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SHM_SPIN_COUNT : 0;
+		for (int i = 0; i < spinCount; i++) {
+			if (condition()) return true;
+			cpuRelax();
+		}
+
+		unsigned long long deadline = timeout == 0 ? 0 : monotonicMillis() + timeout;
+		while (true) {
+			waiting->store(1);
+			uint32_t value = signal->load();
+			if (condition()) break;
+			if (!peerAlive(ring)) {
+				waiting->store(0);
+				return condition();
+			}
+
+			unsigned long sleep = READ_SOCKET_TIMEOUT;
+			if (deadline != 0) {
+				unsigned long long now = monotonicMillis();
+				if (now >= deadline) {
+					waiting->store(0);
+					return false; // timed out
+				}
+				if (deadline - now < sleep) sleep = deadline - now;
+			}
+			futexWait(signal, value, sleep);
+		}
+		waiting->store(0);
+		return true;
+	}
+
+	bool send(const char* buffer, unsigned int length) override {
+		bool pending = false;
+		if (this->control.stype == NetSocket::STREAM && !completeRendezvous(true, &pending))
+			return false;
+		if (this->control.stype != NetSocket::STREAM || (this->sendRing == 0 && !pending)) {
+			printf("tried to call send() on non STREAM socket!\n");
+			return false;
+		}
+
+		ShmRing* ring = this->sendRing;
+		if (ring->closed.load())
+			return false; // connection closed
+		uint64_t head = ring->head.load(std::memory_order_relaxed);
+		while (length > 0) {
+			uint64_t tail = ring->tail.load(std::memory_order_acquire);
+			if (head - tail > this->capacity)
+				return ringViolation(ring, "send");
+			uint64_t space = this->capacity - (head - tail);
+			if (space == 0) {
+				if (!waitFor(ring, &ring->spaceSignal, &ring->spaceWaiting, this->writeTimeout, [&]() { return ring->tail.load() != tail; }))
+					return false;
+				continue;
+			}
+
+			unsigned int count = length < space ? length : space;
+			unsigned int offset = head & (this->capacity - 1);
+			unsigned int first = count < this->capacity - offset ? count : this->capacity - offset;
+			char* data = (char*) (ring + 1);
+			memcpy(data + offset, buffer, first);
+			memcpy(data, buffer + first, count - first);
+
+			head += count;
+			buffer += count;
+			length -= count;
+			ring->head.store(head);
+			if (ring->dataWaiting.load()) {
+				ring->dataSignal.fetch_add(1);
+				futexWake(&ring->dataSignal);
+			}
+		}
+
+		return true;
+	}
+
+	bool receive(char* buffer, unsigned int length, unsigned int* received) override {
+		bool pending = false;
+		if (this->control.stype == NetSocket::STREAM && !completeRendezvous(this->blocking, &pending))
+			return false;
+		if (this->control.stype != NetSocket::STREAM || (this->receiveRing == 0 && !pending)) {
+			printf("tried to call receive() on non STREAM socket!\n");
+			return false;
+		}
+
+		*received = 0;
+		if (pending)
+			return true; // shared memory not received yet in non blocking mode
+		ShmRing* ring = this->receiveRing;
+		uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+		uint64_t head = ring->head.load(std::memory_order_acquire);
+		if (head == tail) {
+			if (!this->blocking)
+				return peerAlive(ring); // nothing to read in non blocking mode
+			if (!waitFor(ring, &ring->dataSignal, &ring->dataWaiting, this->readTimeout, [&]() { return ring->head.load() != tail; }))
+				return this->readTimeout != 0 && peerAlive(ring); // timed out or connection closed
+			head = ring->head.load(std::memory_order_acquire);
+		}
+		if (head - tail > this->capacity)
+			return ringViolation(ring, "receive");
+
+		unsigned int count = length < head - tail ? length : head - tail;
+		unsigned int offset = tail & (this->capacity - 1);
+		unsigned int first = count < this->capacity - offset ? count : this->capacity - offset;
+		const char* data = (const char*) (ring + 1);
+		memcpy(buffer, data + offset, first);
+		memcpy(buffer + first, data, count - first);
+
+		ring->tail.store(tail + count);
+		if (ring->spaceWaiting.load()) {
+			ring->spaceSignal.fetch_add(1);
+			futexWake(&ring->spaceSignal);
+		}
+
+		*received = count;
+		return true;
+	}
+
+	bool setBlocking(bool blocking) override {
+		this->blocking = blocking;
+		if (this->control.stype == NetSocket::LISTEN_TCP)
+			return this->control.setBlocking(blocking);
+		return true;
+	}
+
+	bool getBlocking(bool* blocking) override {
+		*blocking = this->blocking;
+		return true;
+	}
+
+	bool trySend(const char* buffer, unsigned int length, unsigned int* sent, bool* wouldBlock) override {
+		bool pending = false;
+		if (this->control.stype == NetSocket::STREAM && !completeRendezvous(false, &pending))
+			return false;
+		if (this->control.stype != NetSocket::STREAM || (this->sendRing == 0 && !pending)) {
+			printf("tried to call trySend() on non STREAM socket!\n");
+			return false;
+		}
+
+		*sent = 0;
+		*wouldBlock = pending;
+		if (pending)
+			return true; // shared memory not received yet
+		ShmRing* ring = this->sendRing;
+		if (ring->closed.load())
+			return false; // connection closed
+		uint64_t used = ring->head.load(std::memory_order_relaxed) - ring->tail.load(std::memory_order_acquire);
+		if (used > this->capacity)
+			return ringViolation(ring, "trySend");
+		uint64_t space = this->capacity - used;
+		unsigned int count = length < space ? length : space;
+		*wouldBlock = count < length;
+		if (count == 0)
+			return true;
+
+		// there is enough space, so send() does not wait
+		if (!send(buffer, count))
+			return false;
+		*sent = count;
+		return true;
+	}
+
+	bool trySendGather(const NetSocket::SendBuffer* buffers, unsigned int count, unsigned int* sent, bool* wouldBlock) override {
+		// the rings are written without system calls, so the buffers are just copied one after another
+		*sent = 0;
+		*wouldBlock = false;
+		for (unsigned int i = 0; i < count && !*wouldBlock; i++) {
+			unsigned int bufferSent = 0;
+			if (!trySend(buffers[i].buffer, buffers[i].length, &bufferSent, wouldBlock))
+				return false; // connection closed or failed
+			*sent += bufferSent;
+		}
+		return true;
+	}
+
+	bool tryReceive(char* buffer, unsigned int length, unsigned int* received, bool* wouldBlock) override {
+		bool pending = false;
+		if (this->control.stype == NetSocket::STREAM && !completeRendezvous(false, &pending))
+			return false;
+		if (this->control.stype != NetSocket::STREAM || (this->receiveRing == 0 && !pending)) {
+			printf("tried to call tryReceive() on non STREAM socket!\n");
+			return false;
+		}
+
+		*received = 0;
+		*wouldBlock = pending;
+		if (pending)
+			return true; // shared memory not received yet
+		ShmRing* ring = this->receiveRing;
+		*wouldBlock = ring->head.load(std::memory_order_acquire) == ring->tail.load(std::memory_order_relaxed);
+		if (*wouldBlock)
+			return peerAlive(ring);
+
+		// data is available, so receive() does not wait
+		return receive(buffer, length, received);
+	}
+
+	bool bind(const NetSocket::INetAddress& address) override {
+		printf("tried to call bind() on shared memory socket!\n");
+		return false;
+	}
+
+	bool receivefrom(NetSocket::INetAddress& address, char* buffer, unsigned int length, unsigned int* received) override {
+		printf("tried to call receivefrom() on shared memory socket!\n");
+		return false;
+	}
+
+	bool sendto(const NetSocket::INetAddress& address, const char* buffer, unsigned int length) override {
+		printf("tried to call sendto() on shared memory socket!\n");
+		return false;
+	}
+
+	bool sendSocket(NetSocket::Socket& socket, const char* buffer, unsigned int length) override {
+		return this->control.sendSocket(socket, buffer, length);
+	}
+
+	bool receiveSocket(NetSocket::Socket& socket, char* buffer, unsigned int length, unsigned int* received) override {
+		return this->control.receiveSocket(socket, buffer, length, received);
+	}
+
+	bool receivefromBatch(NetSocket::Datagram* datagrams, unsigned int count, unsigned int* receivedCount) override {
+		printf("tried to call receivefromBatch() on shared memory socket!\n");
+		return false;
+	}
+
+	bool sendtoBatch(const NetSocket::Datagram* datagrams, unsigned int count, unsigned int* sentCount) override {
+		printf("tried to call sendtoBatch() on shared memory socket!\n");
+		return false;
+	}
+
+	bool setCongestionControl(const char* algorithm) override {
+		printf("tried to call setCongestionControl() on shared memory socket!\n");
+		return false;
+	}
+
+	bool getCongestionControl(std::string& algorithm) override {
+		printf("tried to call getCongestionControl() on shared memory socket!\n");
+		return false;
+	}
+
+	bool getStats(NetSocket::ConnectionStats* stats) override {
+		printf("tried to call getStats() on shared memory socket!\n");
+		return false;
+	}
+
+	bool joinGroup(const NetSocket::INetAddress& groupAddress, const NetSocket::INetAddress* sourceAddress, unsigned int interfaceIndex) override {
+		printf("tried to call joinGroup() on shared memory socket!\n");
+		return false;
+	}
+
+	bool leaveGroup(const NetSocket::INetAddress& groupAddress, const NetSocket::INetAddress* sourceAddress, unsigned int interfaceIndex) override {
+		printf("tried to call leaveGroup() on shared memory socket!\n");
+		return false;
+	}
+
+	bool enableTimestamps(bool receive, bool transmit) override {
+		printf("tried to call enableTimestamps() on shared memory socket!\n");
+		return false;
+	}
+
+	bool receiveTimestamped(char* buffer, unsigned int length, unsigned int* received, NetSocket::Timestamp* timestamp) override {
+		printf("tried to call receiveTimestamped() on shared memory socket!\n");
+		return false;
+	}
+
+	bool receivefromTimestamped(NetSocket::INetAddress& address, char* buffer, unsigned int length, unsigned int* received, NetSocket::Timestamp* timestamp) override {
+		printf("tried to call receivefromTimestamped() on shared memory socket!\n");
+		return false;
+	}
+
+	bool receiveTransmitTimestamp(unsigned int* id, NetSocket::Timestamp* timestamp, bool* available) override {
+		printf("tried to call receiveTransmitTimestamp() on shared memory socket!\n");
+		return false;
+	}
+
+	bool getPeerCredentials(int* pid, int* uid, int* gid) override {
+		return this->control.getPeerCredentials(pid, uid, gid);
+	}
+
+};
+
+NetSocket::Socket* NetSocket::newShmSocket(unsigned int capacity) {
+	if (capacity > SHM_MAX_CAPACITY) {
+		printf("tried to call newShmSocket() with capacity larger than 2 GB!\n");
+		return 0;
+	}
+	return new SocketShm(capacity);
+}
+
+#endif
@@ -0,0 +1,572 @@
+#if defined(PLATFORM_LIN) && defined(NETSOCKET_TLS)
+
+#include <chrono>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include "linnet.hpp"
+#include "netsocket_tls.hpp"
+
+void printTLSError(const char* format) {
+	unsigned long errorCode = ERR_get_error();
+	if (errorCode == 0) return;
+	char msg[256];
+	ERR_error_string_n(errorCode, msg, sizeof(msg));
+	printf(format, errorCode, msg);
+	ERR_clear_error();
+}
+
+class SocketTLS : public SocketLin {
+
+public:
+	SSL_CTX* context;
+	SSL* ssl;
+	std::string serverName;
+	unsigned long handshakeTimeout;
+	bool handshakePending; // left pending by an non blocking accept(), completed by the first send or receive
+	std::chrono::steady_clock::time_point handshakeDeadline;
+
+	SocketTLS(SSL_CTX* context, const std::string& serverName, unsigned long handshakeTimeout) {
+		this->context = context;
+		this->ssl = 0;
+		this->serverName = serverName;
+		this->handshakeTimeout = handshakeTimeout;
+		this->handshakePending = false;
+	}
+
+	~SocketTLS() override {
+		if (this->stype != NetSocket::UNBOUND) {
+			close();
+		}
+		SSL_CTX_free(this->context);
+	}
+
+	/*
+	 * The underlying socket might be in non blocking mode (after connect()), so wait for the condition requested by OpenSSL
+	 * Returns false if the socket was closed or the deadline passed, an default constructed deadline waits indefinitely
+	 */
+	bool waitFor(int sslError, std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point()) {
+		struct pollfd fd = {
+			.fd = this->handle,
+			.events = (short) (sslError == SSL_ERROR_WANT_WRITE ? POLLOUT : POLLIN),
+			.revents = 0
+		};
+		int result = 0;
+		while (true) {
+			int timeout = READ_SOCKET_TIMEOUT;
+			if (deadline != std::chrono::steady_clock::time_point()) {
+				long long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+				if (remaining <= 0) {
+					printf("timed out in SocketTLS:waitFor()!\n");
+					return false;
+				}
+				if (remaining < timeout) timeout = (int) remaining;
+			}
+			if ((result = ::poll(&fd, 1UL, timeout)) != 0 || !isOpen()) break;
+		}
+		if (result < 0) {
+			printError("error %d in SocketTLS:waitFor:poll(): %s\n");
+			return false;
+		}
+		return isOpen();
+	}
+
+	/*
+	 * Starts the handshake, if wait is not set it only proceeds as far as possible without waiting for the peer
+	 * and is left pending, to be completed by continueHandshake()
+	 */
+	bool handshake(bool server, bool wait) {
+		this->ssl = SSL_new(this->context);
+		if (this->ssl == 0) {
+			printTLSError("error %lu in SocketTLS:handshake:SSL_new(): %s\n");
+			return false;
+		}
+
+		// the handle stays in non blocking mode, blocking behavior is implemented by waitFor() so OpenSSL never blocks in an system call
+		if (!applyBlocking(this->handle, false)) {
+			SSL_free(this->ssl);
+			this->ssl = 0;
+			return false;
+		}
+		SSL_set_fd(this->ssl, this->handle);
+		SSL_set_mode(this->ssl, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+		if (server) {
+			SSL_set_accept_state(this->ssl);
+		} else {
+			SSL_set_connect_state(this->ssl);
+			if (!this->serverName.empty()) {
+				SSL_set_tlsext_host_name(this->ssl, this->serverName.c_str());
+				SSL_set1_host(this->ssl, this->serverName.c_str());
+			}
+		}
+
+		// an peer which stops responding must not block connect() or accept() forever
+		this->handshakeDeadline = std::chrono::steady_clock::time_point();
+		if (this->handshakeTimeout != 0)
+			this->handshakeDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(this->handshakeTimeout);
+
+		this->handshakePending = true;
+		bool pending = false;
+		if (!continueHandshake(wait, &pending)) {
+			SSL_free(this->ssl);
+			this->ssl = 0;
+			return false;
+		}
+		return true;
+	}
+
+	/*
+	 * Continues an pending handshake, waits until it is complete if wait is set
+	 * Returns false if the handshake failed or its deadline passed, pending is set if it needs more data from the peer
+	 */
+	bool continueHandshake(bool wait, bool* pending) {
+		*pending = false;
+		int result = 0;
+		while ((result = SSL_do_handshake(this->ssl)) != 1) {
+			int error = SSL_get_error(this->ssl, result);
+			if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+				if (wait && waitFor(error, this->handshakeDeadline))
+					continue;
+				if (!wait && (this->handshakeDeadline == std::chrono::steady_clock::time_point() || std::chrono::steady_clock::now() < this->handshakeDeadline)) {
+					*pending = true;
+					return true;
+				}
+				if (!wait) printf("timed out in SocketTLS:continueHandshake()!\n");
+			}
+			printTLSError("error %lu in SocketTLS:continueHandshake:SSL_do_handshake(): %s\n");
+			return false;
+		}
+		this->handshakePending = false;
+		return true;
+	}
+
+	/*
+	 * Completes an handshake left pending by accept() before the first send or receive, closes the connection if it failed
+	 */
+	bool completeHandshake(bool wait, bool* pending) {
+		*pending = false;
+		if (!this->handshakePending)
+			return true;
+		if (continueHandshake(wait, pending))
+			return true;
+		close();
+		return false;
+	}
+
+	bool connect(const NetSocket::INetAddress& address, unsigned long timeout) override {
+		// without an name to check, any certificate signed by an trusted CA would be accepted for any host
+		if (this->serverName.empty() && (SSL_CTX_get_verify_mode(this->context) & SSL_VERIFY_PEER)) {
+			printf("tried to call connect() on TLS socket with peer verification but without server name!\n");
+			return false;
+		}
+
+		if (!SocketLin::connect(address, timeout))
+			return false;
+
+		if (!handshake(false, true)) {
+			SocketLin::close();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool connectFastOpen(const NetSocket::INetAddress& address, unsigned long timeout, const char* buffer, unsigned int length, bool* fastOpenUsed) override {
+		// the data must not leave unencrypted with the SYN, the handshake has to complete first
+		*fastOpenUsed = false;
+		return connect(address, timeout) && (length == 0 || send(buffer, length));
+	}
+
+	bool accept(NetSocket::Socket& socket) override {
+		SocketTLS* clientSocket = dynamic_cast<SocketTLS*>(&socket);
+		if (clientSocket == 0) {
+			printf("tried to call accept() on TLS socket with non TLS socket!\n");
+			return false;
+		}
+
+		while (true) {
+			if (!SocketLin::accept(socket))
+				return false;
+
+			SSL_CTX_up_ref(this->context);
+			SSL_CTX_free(clientSocket->context);
+			clientSocket->context = this->context;
+			clientSocket->handshakeTimeout = this->handshakeTimeout;
+
+			// in non blocking mode the handshake is completed by the first send or receive, so an slow client does not stall the caller
+			if (clientSocket->handshake(true, this->blocking))
+				return true;
+
+			// an failed or stalled handshake only drops this client, in blocking mode the listener waits for the next connection
+			clientSocket->SocketLin::close();
+			if (!this->blocking)
+				return false;
+		}
+	}
+
+	bool bind(const NetSocket::INetAddress& address) override {
+		printf("tried to call bind() on TLS socket!\n");
+		return false;
+	}
+
+	bool receivefrom(NetSocket::INetAddress& address, char* buffer, unsigned int length, unsigned int* received) override {
+		printf("tried to call receivefrom() on TLS socket!\n");
+		return false;
+	}
+
+	bool sendto(const NetSocket::INetAddress& address, const char* buffer, unsigned int length) override {
+		printf("tried to call sendto() on TLS socket!\n");
+		return false;
+	}
+
+	bool receiveTimestamped(char* buffer, unsigned int length, unsigned int* received, NetSocket::Timestamp* timestamp) override {
+		// the decrypted data can not be associated with the packets it arrived in
+		printf("tried to call receiveTimestamped() on TLS socket!\n");
+		return false;
+	}
+
+	bool receivefromTimestamped(NetSocket::INetAddress& address, char* buffer, unsigned int length, unsigned int* received, NetSocket::Timestamp* timestamp) override {
+		printf("tried to call receivefromTimestamped() on TLS socket!\n");
+		return false;
+	}
+
+	bool receivefromBatch(NetSocket::Datagram* datagrams, unsigned int count, unsigned int* receivedCount) override {
+		printf("tried to call receivefromBatch() on TLS socket!\n");
+		return false;
+	}
+
+	bool sendtoBatch(const NetSocket::Datagram* datagrams, unsigned int count, unsigned int* sentCount) override {
+		printf("tried to call sendtoBatch() on TLS socket!\n");
+		return false;
+	}
+
+	bool joinGroup(const NetSocket::INetAddress& groupAddress, const NetSocket::INetAddress* sourceAddress, unsigned int interfaceIndex) override {
+		printf("tried to call joinGroup() on TLS socket!\n");
+		return false;
+	}
+
+	bool leaveGroup(const NetSocket::INetAddress& groupAddress, const NetSocket::INetAddress* sourceAddress, unsigned int interfaceIndex) override {
+		printf("tried to call leaveGroup() on TLS socket!\n");
+		return false;
+	}
+
+	void closeHandle() override {
+		if (this->ssl != 0) {
+			// the close notify can not be sent anymore if the handle was shut down to wake up other threads
+			if (!(this->users.load() & HANDLE_SHUT_DOWN))
+				SSL_shutdown(this->ssl);
+			SSL_free(this->ssl);
+			this->ssl = 0;
+		}
+		SocketLin::closeHandle();
+	}
+
+	bool send(const char* buffer, unsigned int length) override {
+		if (this->stype != NetSocket::STREAM || this->ssl == 0) {
+			printf("tried to call send() on non connected TLS socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		bool pending = false;
+		if (!completeHandshake(true, &pending))
+			return false;
+
+		while (length > 0) {
+			size_t written = 0;
+			int result = SSL_write_ex(this->ssl, buffer, length, &written);
+			if (result != 1) {
+				int error = SSL_get_error(this->ssl, result);
+				if ((error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) && waitFor(error))
+					continue;
+				if (error == SSL_ERROR_ZERO_RETURN)
+					return false; // connection closed
+				if (error == SSL_ERROR_SYSCALL) {
+					if (errno == ETIMEDOUT)
+						return true; // timed out
+					else if (errno == ECONNRESET || errno == EPIPE)
+						return false; // connection closed
+					if (errno == EBADF || errno == EIO) {
+						close();
+						return false;
+					}
+					printError("error %d in SocketTLS:send:SSL_write(): %s\n");
+					return false;
+				}
+				printTLSError("error %lu in SocketTLS:send:SSL_write(): %s\n");
+				return false;
+			}
+			buffer += written;
+			length -= written;
+		}
+
+		return true;
+	}
+
+	bool receive(char* buffer, unsigned int length, unsigned int* received) override {
+		if (this->stype != NetSocket::STREAM || this->ssl == 0) {
+			printf("tried to call receive() on non connected TLS socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*received = 0;
+		bool pending = false;
+		if (!completeHandshake(this->blocking, &pending))
+			return false;
+		if (pending)
+			return true; // handshake not complete yet in non blocking mode
+
+		if (this->blocking && SSL_pending(this->ssl) == 0 && !waitFor(SSL_ERROR_WANT_READ))
+			return false;
+
+		size_t readBytes = 0;
+		int result = SSL_read_ex(this->ssl, buffer, length, &readBytes);
+		if (result != 1) {
+			int error = SSL_get_error(this->ssl, result);
+			if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE)
+				return true; // only an partial record or an control message was received
+			if (error == SSL_ERROR_ZERO_RETURN)
+				return false; // connection closed
+			if (error == SSL_ERROR_SYSCALL) {
+				if (errno == ETIMEDOUT || errno == EAGAIN)
+					return true; // timed out
+				else if (errno == ECONNRESET || errno == 0)
+					return false; // connection closed
+				if (errno == EBADF) {
+					close();
+					return false;
+				}
+				printError("error %d in SocketTLS:receive:SSL_read(): %s\n");
+				return false;
+			}
+			printTLSError("error %lu in SocketTLS:receive:SSL_read(): %s\n");
+			return false;
+		}
+
+		*received = readBytes;
+		return true;
+	}
+
+	bool setBlocking(bool blocking) override {
+		// only the handle of an connection stays non blocking (see handshake()), an listen socket uses the mode of its handle
+		if (this->stype != NetSocket::STREAM)
+			return SocketLin::setBlocking(blocking);
+		this->blocking = blocking;
+		return true;
+	}
+
+	bool hasPendingData() override {
+		HandleUse use(this);
+		return use && this->ssl != 0 && SSL_pending(this->ssl) > 0;
+	}
+
+	bool trySend(const char* buffer, unsigned int length, unsigned int* sent, bool* wouldBlock) override {
+		if (this->stype != NetSocket::STREAM || this->ssl == 0) {
+			printf("tried to call trySend() on non connected TLS socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		// after an would block result OpenSSL requires the unsent data to be passed again in the next call
+		*sent = 0;
+		*wouldBlock = false;
+		if (!completeHandshake(false, wouldBlock))
+			return false;
+		if (*wouldBlock)
+			return true;
+
+		size_t written = 0;
+		int result = SSL_write_ex(this->ssl, buffer, length, &written);
+		if (result != 1) {
+			int error = SSL_get_error(this->ssl, result);
+			if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+				*wouldBlock = true;
+				return true;
+			}
+			if (error == SSL_ERROR_ZERO_RETURN)
+				return false; // connection closed
+			printTLSError("error %lu in SocketTLS:trySend:SSL_write(): %s\n");
+			return false;
+		}
+
+		*sent = written;
+		*wouldBlock = written < length;
+		return true;
+	}
+
+	bool trySendGather(const NetSocket::SendBuffer* buffers, unsigned int count, unsigned int* sent, bool* wouldBlock) override {
+		// each buffer is encrypted on its own, the records are still sent as one stream
+		*sent = 0;
+		*wouldBlock = false;
+		for (unsigned int i = 0; i < count && !*wouldBlock; i++) {
+			unsigned int bufferSent = 0;
+			if (!trySend(buffers[i].buffer, buffers[i].length, &bufferSent, wouldBlock))
+				return false; // connection closed or failed
+			*sent += bufferSent;
+		}
+		return true;
+	}
+
+	bool tryReceive(char* buffer, unsigned int length, unsigned int* received, bool* wouldBlock) override {
+		if (this->stype != NetSocket::STREAM || this->ssl == 0) {
+			printf("tried to call tryReceive() on non connected TLS socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*received = 0;
+		*wouldBlock = false;
+		if (!completeHandshake(false, wouldBlock))
+			return false;
+		if (*wouldBlock)
+			return true;
+
+		size_t readBytes = 0;
+		int result = SSL_read_ex(this->ssl, buffer, length, &readBytes);
+		if (result != 1) {
+			int error = SSL_get_error(this->ssl, result);
+			if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+				*wouldBlock = true;
+				return true;
+			}
+			if (error == SSL_ERROR_ZERO_RETURN)
+				return false; // connection closed
+			if (error == SSL_ERROR_SYSCALL && (errno == ECONNRESET || errno == 0))
+				return false; // connection closed
+			printTLSError("error %lu in SocketTLS:tryReceive:SSL_read(): %s\n");
+			return false;
+		}
+
+		*received = readBytes;
+		return true;
+	}
+
+	bool kernelTLS(bool* kernelSend, bool* kernelReceive) {
+		if (this->stype != NetSocket::STREAM || this->ssl == 0) {
+			printf("tried to call getKernelTLS() on non connected TLS socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*kernelSend = BIO_get_ktls_send(SSL_get_wbio(this->ssl)) == 1;
+		*kernelReceive = BIO_get_ktls_recv(SSL_get_rbio(this->ssl)) == 1;
+		return true;
+	}
+
+	bool sendFile(int fileHandle, long long offset, unsigned long long length) {
+		if (this->stype != NetSocket::STREAM || this->ssl == 0) {
+			printf("tried to call sendFileTLS() on non connected TLS socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		bool pending = false;
+		if (!completeHandshake(true, &pending))
+			return false;
+
+		if (BIO_get_ktls_send(SSL_get_wbio(this->ssl)) == 1) {
+			while (length > 0) {
+				ossl_ssize_t result = SSL_sendfile(this->ssl, fileHandle, offset, length, 0);
+				if (result < 0) {
+					int error = SSL_get_error(this->ssl, (int) result);
+					if ((error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) && waitFor(error))
+						continue;
+					printError("error %d in SocketTLS:sendFile:SSL_sendfile(): %s\n");
+					return false;
+				}
+				offset += result;
+				length -= result;
+			}
+			return true;
+		}
+
+		// no kernel offloading, the data has to pass trough user space for encryption anyway
+		char buffer[16384];
+		while (length > 0) {
+			ssize_t result = ::pread(fileHandle, buffer, length < sizeof(buffer) ? length : sizeof(buffer), offset);
+			if (result <= 0) {
+				printError("error %d in SocketTLS:sendFile:pread(): %s\n");
+				return false;
+			}
+			if (!send(buffer, result))
+				return false;
+			offset += result;
+			length -= result;
+		}
+		return true;
+	}
+
+};
+
+NetSocket::Socket* NetSocket::newTLSSocket(const TLSConfig& config) {
+
+	SSL_CTX* context = SSL_CTX_new(TLS_method());
+	if (context == 0) {
+		printTLSError("error %lu in Socket:newTLSSocket:SSL_CTX_new(): %s\n");
+		return 0;
+	}
+
+	SSL_CTX_set_min_proto_version(context, TLS1_2_VERSION);
+#ifdef SSL_OP_ENABLE_KTLS
+	if (config.kernelOffload)
+		SSL_CTX_set_options(context, SSL_OP_ENABLE_KTLS);
+#endif
+
+	if (!config.certificateFile.empty()) {
+		if (SSL_CTX_use_certificate_chain_file(context, config.certificateFile.c_str()) != 1 ||
+			SSL_CTX_use_PrivateKey_file(context, config.privateKeyFile.c_str(), SSL_FILETYPE_PEM) != 1 ||
+			SSL_CTX_check_private_key(context) != 1) {
+			printTLSError("error %lu in Socket:newTLSSocket:SSL_CTX_use_certificate(): %s\n");
+			SSL_CTX_free(context);
+			return 0;
+		}
+	}
+
+	if (config.verifyPeer) {
+		int result = config.trustedCertificatesFile.empty() ?
+				SSL_CTX_set_default_verify_paths(context) :
+				SSL_CTX_load_verify_locations(context, config.trustedCertificatesFile.c_str(), 0);
+		if (result != 1) {
+			printTLSError("error %lu in Socket:newTLSSocket:SSL_CTX_load_verify_locations(): %s\n");
+			SSL_CTX_free(context);
+			return 0;
+		}
+		SSL_CTX_set_verify(context, SSL_VERIFY_PEER, 0);
+	} else {
+		SSL_CTX_set_verify(context, SSL_VERIFY_NONE, 0);
+	}
+
+	return new SocketTLS(context, config.serverName, config.handshakeTimeout);
+}
+
+bool NetSocket::getKernelTLS(Socket& socket, bool* kernelSend, bool* kernelReceive) {
+	SocketTLS* tlsSocket = dynamic_cast<SocketTLS*>(&socket);
+	if (tlsSocket == 0) {
+		printf("tried to call getKernelTLS() on non TLS socket!\n");
+		return false;
+	}
+	return tlsSocket->kernelTLS(kernelSend, kernelReceive);
+}
+
+bool NetSocket::sendFileTLS(Socket& socket, int fileHandle, long long offset, unsigned long long length) {
+	SocketTLS* tlsSocket = dynamic_cast<SocketTLS*>(&socket);
+	if (tlsSocket == 0) {
+		printf("tried to call sendFileTLS() on non TLS socket!\n");
+		return false;
+	}
+	return tlsSocket->sendFile(fileHandle, offset, length);
+}
+
+#endif
@@ -0,0 +1,941 @@
+#ifdef PLATFORM_LIN
+
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <net/if.h>
+#include <net/ethernet.h>
+#include <netinet/ip.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include "linnet.hpp"
+#include "netsocket_xdp.hpp"
+
+/*
+ * Size of the frames shared with the kernel, received packets start after XDP_PACKET_HEADROOM
+ */
+#define XDP_FRAME_SIZE 4096
+#define XDP_MIN_FRAMES 64
+
+#define XDP_ETH_LENGTH 14
+#define XDP_IPV4_LENGTH 20
+#define XDP_IPV6_LENGTH 40
+#define XDP_UDP_LENGTH 8
+
+/*
+ * Number of wakeup calls after which the remaining transmit descriptors are left for the next send
+ */
+#define XDP_KICK_LIMIT 64
+
+/*
+ * Maximum number of learned peers, the table is cleared when it is full
+ */
+#define XDP_ROUTE_LIMIT 65536
+
+/*
+ * One of the four rings shared with the kernel, the producer and consumer indices run freely and are masked on access
+ */
+struct XdpRing {
+	uint32_t* producer;
+	uint32_t* consumer;
+	uint32_t* flags;
+	void* descriptors;
+	uint32_t mask;
+	void* map;
+	size_t mapLength;
+};
+
+/*
+ * Peer address (4 or 16 bytes), used as key of the learned routes
+ */
+struct XdpPeer {
+	uint64_t address[2];
+
+	bool operator==(const XdpPeer& other) const {
+		return this->address[0] == other.address[0] && this->address[1] == other.address[1];
+	}
+};
+
+struct XdpPeerHash {
+	size_t operator()(const XdpPeer& peer) const {
+		return std::hash<uint64_t>()(peer.address[0] * 31 + peer.address[1]);
+	}
+};
+
+/*
+ * Ethernet address of the next hop towards an peer and the local address the peer sent its packets to
+ */
+struct XdpRoute {
+	unsigned char hardwareAddress[ETH_ALEN];
+	unsigned char localAddress[16];
+};
+
+static inline XdpPeer peerKey(const void* address, unsigned int length) {
+	XdpPeer peer = {{ 0, 0 }};
+	memcpy(peer.address, address, length);
+	return peer;
+}
+
+/*
+ * Adds the data to an ones complement sum, in 32 bit words to keep the loop short
+ */
+static inline uint64_t checksumAdd(uint64_t sum, const void* data, unsigned int length) {
+	const unsigned char* bytes = (const unsigned char*) data;
+	while (length >= 4) {
+		uint32_t word;
+		memcpy(&word, bytes, 4);
+		sum += word;
+		bytes += 4;
+		length -= 4;
+	}
+	if (length >= 2) {
+		uint16_t word;
+		memcpy(&word, bytes, 2);
+		sum += word;
+		bytes += 2;
+		length -= 2;
+	}
+	if (length > 0) {
+		uint16_t word = 0;
+		memcpy(&word, bytes, 1);
+		sum += word;
+	}
+	return sum;
+}
+
+static inline uint16_t checksumFold(uint64_t sum) {
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+	return (uint16_t) ~sum;
+}
+
+static inline long bpfCall(int command, union bpf_attr* attributes) {
+	return ::syscall(SYS_bpf, command, attributes, sizeof(union bpf_attr));
+}
+
+/*
+ * Assembles the XDP program which redirects the UDP packets for the bound address and port into the socket map:
+ * packets of the bound address family without IP options, fragmentation or IPv6 extension headers, which fit into an frame,
+ * are redirected to the socket registered for their receive queue, all other packets continue trough the network stack
+ */
+class XdpProgram {
+
+public:
+	std::vector<struct bpf_insn> code;
+
+	void emit(uint8_t opcode, uint8_t destination, uint8_t source, int16_t offset, int32_t immediate) {
+		struct bpf_insn instruction;
+		instruction.code = opcode;
+		instruction.dst_reg = destination;
+		instruction.src_reg = source;
+		instruction.off = offset;
+		instruction.imm = immediate;
+		this->code.push_back(instruction);
+	}
+
+	/*
+	 * Loads an packet value into r5 and jumps to the pass label if it differs from the expected value
+	 */
+	void expect(uint8_t size, int16_t offset, int32_t value) {
+		emit(BPF_LDX | size | BPF_MEM, BPF_REG_5, BPF_REG_2, offset, 0);
+		this->passJumps.push_back(this->code.size());
+		emit(BPF_JMP32 | BPF_JNE | BPF_K, BPF_REG_5, 0, 0, value);
+	}
+
+	void build(int mapFd, const addr_t* address, unsigned int maxLength) {
+		bool ipv6 = address->sockaddrU.sa_family == AF_INET6;
+		unsigned int headerLength = XDP_ETH_LENGTH + (ipv6 ? XDP_IPV6_LENGTH : XDP_IPV4_LENGTH) + XDP_UDP_LENGTH;
+
+		// r6 = context, r2 = data, r3 = data end
+		emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0);
+		emit(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_2, BPF_REG_1, offsetof(struct xdp_md, data), 0);
+		emit(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_3, BPF_REG_1, offsetof(struct xdp_md, data_end), 0);
+
+		// packets larger than an frame would be dropped by the socket
+		emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0);
+		emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, maxLength);
+		this->passJumps.push_back(this->code.size());
+		emit(BPF_JMP | BPF_JLT | BPF_X, BPF_REG_4, BPF_REG_3, 0, 0);
+
+		// the headers have to be present, this also proves the packet bounds to the verifier
+		emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0);
+		emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, headerLength);
+		this->passJumps.push_back(this->code.size());
+		emit(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 0, 0);
+
+		if (ipv6) {
+			expect(BPF_H, 12, htons(ETHERTYPE_IPV6));
+			expect(BPF_B, XDP_ETH_LENGTH + 6, IPPROTO_UDP);
+			if (!IN6_IS_ADDR_UNSPECIFIED(&address->sockaddr6.sin6_addr)) {
+				for (int i = 0; i < 4; i++) {
+					int32_t part;
+					memcpy(&part, address->sockaddr6.sin6_addr.s6_addr + i * 4, 4);
+					expect(BPF_W, XDP_ETH_LENGTH + 24 + i * 4, part);
+				}
+			}
+			expect(BPF_H, XDP_ETH_LENGTH + XDP_IPV6_LENGTH + 2, address->sockaddr6.sin6_port);
+		} else {
+			expect(BPF_H, 12, htons(ETHERTYPE_IP));
+			expect(BPF_B, XDP_ETH_LENGTH, 0x45);
+			expect(BPF_B, XDP_ETH_LENGTH + 9, IPPROTO_UDP);
+			emit(BPF_LDX | BPF_H | BPF_MEM, BPF_REG_5, BPF_REG_2, XDP_ETH_LENGTH + 6, 0);
+			emit(BPF_ALU | BPF_AND | BPF_K, BPF_REG_5, 0, 0, htons(IP_MF | IP_OFFMASK));
+			this->passJumps.push_back(this->code.size());
+			emit(BPF_JMP32 | BPF_JNE | BPF_K, BPF_REG_5, 0, 0, 0);
+			if (address->sockaddr4.sin_addr.s_addr != INADDR_ANY)
+				expect(BPF_W, XDP_ETH_LENGTH + 16, address->sockaddr4.sin_addr.s_addr);
+			expect(BPF_H, XDP_ETH_LENGTH + XDP_IPV4_LENGTH + 2, address->sockaddr4.sin_port);
+		}
+
+		// return bpf_redirect_map(&map, context->rx_queue_index, XDP_PASS)
+		emit(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_2, BPF_REG_6, offsetof(struct xdp_md, rx_queue_index), 0);
+		emit(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, mapFd);
+		emit(0, 0, 0, 0, 0);
+		emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS);
+		emit(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map);
+		emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+		size_t pass = this->code.size();
+		emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS);
+		emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+		for (size_t jump : this->passJumps)
+			this->code[jump].off = (int16_t) (pass - jump - 1);
+	}
+
+private:
+	std::vector<size_t> passJumps;
+
+};
+
+class SocketXdp : public SocketLin {
+
+public:
+	std::string interfaceName;
+	unsigned int interfaceIndex;
+	unsigned int queue;
+	bool nativeMode;
+	unsigned int frameCount;
+
+	int xsk;
+	int epoll;
+	int xskMap;
+	int program;
+	int link;
+	char* frames;
+	XdpRing rx;
+	XdpRing tx;
+	XdpRing fill;
+	XdpRing completion;
+	bool zeroCopy;
+	std::vector<uint64_t> freeFrames;
+
+	addr_t localAddress;
+	unsigned char hardwareAddress[ETH_ALEN];
+	unsigned int mtu;
+	uint16_t nextId;
+	std::mutex routeLock;
+	std::unordered_map<XdpPeer, XdpRoute, XdpPeerHash> routes;
+
+	SocketXdp(const char* interfaceName, unsigned int queue, bool nativeMode, unsigned int frameCount) {
+		this->interfaceName = interfaceName;
+		this->interfaceIndex = 0;
+		this->queue = queue;
+		this->nativeMode = nativeMode;
+		this->frameCount = XDP_MIN_FRAMES;
+		while (this->frameCount < frameCount) this->frameCount <<= 1;
+
+		this->xsk = this->epoll = this->xskMap = this->program = this->link = -1;
+		this->frames = 0;
+		memset(&this->rx, 0, sizeof(XdpRing));
+		memset(&this->tx, 0, sizeof(XdpRing));
+		memset(&this->fill, 0, sizeof(XdpRing));
+		memset(&this->completion, 0, sizeof(XdpRing));
+		this->zeroCopy = false;
+		memset(&this->localAddress, 0, sizeof(addr_t));
+		memset(this->hardwareAddress, 0, ETH_ALEN);
+		this->mtu = 0;
+		this->nextId = 0;
+	}
+
+	~SocketXdp() override {
+		if (this->stype != NetSocket::UNBOUND) {
+			close();
+		}
+	}
+
+	bool listen(const NetSocket::INetAddress& address) override {
+		printf("tried to call listen() on XDP socket!\n");
+		return false;
+	}
+
+	bool connect(const NetSocket::INetAddress& address, unsigned long timeout) override {
+		printf("tried to call connect() on XDP socket!\n");
+		return false;
+	}
+
+	bool connectFastOpen(const NetSocket::INetAddress& address, unsigned long timeout, const char* buffer, unsigned int length, bool* fastOpenUsed) override {
+		printf("tried to call connectFastOpen() on XDP socket!\n");
+		return false;
+	}
+
+	bool receivefromTimestamped(NetSocket::INetAddress& address, char* buffer, unsigned int length, unsigned int* received, NetSocket::Timestamp* timestamp) override {
+		// packets on the XDP path never pass the network stack which records the timestamps
+		printf("tried to call receivefromTimestamped() on XDP socket!\n");
+		return false;
+	}
+
+	bool bind(const NetSocket::INetAddress& address) override {
+		if (this->stype != NetSocket::UNBOUND) {
+			printf("tried to call bind() on already bound socket!\n");
+			return false;
+		}
+		unsigned short family = ((addr_t*) address.addr)->sockaddrU.sa_family;
+		if (family != AF_INET && family != AF_INET6) {
+			printf("tried to call bind() with non IP address on XDP socket!\n");
+			return false;
+		}
+
+		if (!SocketLin::bind(address))
+			return false;
+
+		// the port might have been chosen by the system
+		socklen_t length = sizeof(addr_t);
+		if (::getsockname(this->handle, &this->localAddress.sockaddrU, &length) == -1) {
+			printError("error %d in SocketXdp:bind:getsockname(): %s\n");
+			SocketLin::close();
+			return false;
+		}
+
+		if (!openXdp()) {
+			closeXdp();
+			SocketLin::close();
+			return false;
+		}
+		return true;
+	}
+
+	/*
+	 * Maps an ring shared with the kernel, the offsets are the ones returned by XDP_MMAP_OFFSETS
+	 */
+	bool mapRing(XdpRing* ring, const struct xdp_ring_offset* offsets, unsigned int size, size_t entrySize, off_t pageOffset) {
+		ring->mapLength = offsets->desc + size * entrySize;
+		ring->map = ::mmap(0, ring->mapLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->xsk, pageOffset);
+		if (ring->map == MAP_FAILED) {
+			ring->map = 0;
+			printError("error %d in SocketXdp:bind:mmap(): %s\n");
+			return false;
+		}
+		ring->producer = (uint32_t*) ((char*) ring->map + offsets->producer);
+		ring->consumer = (uint32_t*) ((char*) ring->map + offsets->consumer);
+		ring->flags = (uint32_t*) ((char*) ring->map + offsets->flags);
+		ring->descriptors = (char*) ring->map + offsets->desc;
+		ring->mask = size - 1;
+		return true;
+	}
+
+	bool openXdp() {
+		this->interfaceIndex = ::if_nametoindex(this->interfaceName.c_str());
+		if (this->interfaceIndex == 0) {
+			printError("error %d in SocketXdp:bind:if_nametoindex(): %s\n");
+			return false;
+		}
+
+		// the own ethernet address and the MTU are needed to build outgoing frames
+		struct ifreq request;
+		memset(&request, 0, sizeof(request));
+		strncpy(request.ifr_name, this->interfaceName.c_str(), IFNAMSIZ - 1);
+		if (::ioctl(this->handle, SIOCGIFHWADDR, &request) == -1) {
+			printError("error %d in SocketXdp:bind:ioctl(SIOCGIFHWADDR): %s\n");
+			return false;
+		}
+		memcpy(this->hardwareAddress, request.ifr_hwaddr.sa_data, ETH_ALEN);
+		if (::ioctl(this->handle, SIOCGIFMTU, &request) == -1) {
+			printError("error %d in SocketXdp:bind:ioctl(SIOCGIFMTU): %s\n");
+			return false;
+		}
+		this->mtu = request.ifr_mtu;
+
+		this->xsk = ::socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0);
+		if (this->xsk == -1) {
+			printError("error %d in SocketXdp:bind:socket(AF_XDP): %s\n");
+			return false;
+		}
+
+		size_t framesLength = (size_t) this->frameCount * XDP_FRAME_SIZE;
+		this->frames = (char*) ::mmap(0, framesLength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+		if (this->frames == MAP_FAILED) {
+			this->frames = 0;
+			printError("error %d in SocketXdp:bind:mmap(): %s\n");
+			return false;
+		}
+
+		struct xdp_umem_reg umem;
+		memset(&umem, 0, sizeof(umem));
+		umem.addr = (uint64_t) (uintptr_t) this->frames;
+		umem.len = framesLength;
+		umem.chunk_size = XDP_FRAME_SIZE;
+		umem.headroom = 0;
+		if (::setsockopt(this->xsk, SOL_XDP, XDP_UMEM_REG, &umem, sizeof(umem)) == -1) {
+			printError("error %d in SocketXdp:bind:setsockopt(XDP_UMEM_REG): %s\n");
+			return false;
+		}
+
+		// half of the frames receive, the other half sends, each ring can hold all frames of its direction
+		unsigned int ringSize = this->frameCount / 2;
+		if (::setsockopt(this->xsk, SOL_XDP, XDP_UMEM_FILL_RING, &ringSize, sizeof(ringSize)) == -1 ||
+			::setsockopt(this->xsk, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ringSize, sizeof(ringSize)) == -1 ||
+			::setsockopt(this->xsk, SOL_XDP, XDP_RX_RING, &ringSize, sizeof(ringSize)) == -1 ||
+			::setsockopt(this->xsk, SOL_XDP, XDP_TX_RING, &ringSize, sizeof(ringSize)) == -1) {
+			printError("error %d in SocketXdp:bind:setsockopt(XDP_RING): %s\n");
+			return false;
+		}
+
+		struct xdp_mmap_offsets offsets;
+		socklen_t length = sizeof(offsets);
+		if (::getsockopt(this->xsk, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &length) == -1) {
+			printError("error %d in SocketXdp:bind:getsockopt(XDP_MMAP_OFFSETS): %s\n");
+			return false;
+		}
+		if (!mapRing(&this->rx, &offsets.rx, ringSize, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING) ||
+			!mapRing(&this->tx, &offsets.tx, ringSize, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING) ||
+			!mapRing(&this->fill, &offsets.fr, ringSize, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING) ||
+			!mapRing(&this->completion, &offsets.cr, ringSize, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING))
+			return false;
+
+		uint64_t* fillFrames = (uint64_t*) this->fill.descriptors;
+		for (unsigned int i = 0; i < ringSize; i++)
+			fillFrames[i] = (uint64_t) i * XDP_FRAME_SIZE;
+		__atomic_store_n(this->fill.producer, ringSize, __ATOMIC_RELEASE);
+		this->freeFrames.clear();
+		for (unsigned int i = ringSize; i < this->frameCount; i++)
+			this->freeFrames.push_back((uint64_t) i * XDP_FRAME_SIZE);
+
+		// zero copy is only possible in native mode and only if the driver supports it
+		struct sockaddr_xdp xdpAddress;
+		memset(&xdpAddress, 0, sizeof(xdpAddress));
+		xdpAddress.sxdp_family = AF_XDP;
+		xdpAddress.sxdp_ifindex = this->interfaceIndex;
+		xdpAddress.sxdp_queue_id = this->queue;
+		xdpAddress.sxdp_flags = XDP_USE_NEED_WAKEUP | (this->nativeMode ? XDP_ZEROCOPY : XDP_COPY);
+		this->zeroCopy = this->nativeMode;
+		int result = ::bind(this->xsk, (struct sockaddr*) &xdpAddress, sizeof(xdpAddress));
+		if (result == -1 && this->nativeMode) {
+			xdpAddress.sxdp_flags = XDP_USE_NEED_WAKEUP | XDP_COPY;
+			this->zeroCopy = false;
+			result = ::bind(this->xsk, (struct sockaddr*) &xdpAddress, sizeof(xdpAddress));
+		}
+		if (result == -1) {
+			printError("error %d in SocketXdp:bind:bind(AF_XDP): %s\n");
+			return false;
+		}
+
+		union bpf_attr attributes;
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.map_type = BPF_MAP_TYPE_XSKMAP;
+		attributes.key_size = sizeof(uint32_t);
+		attributes.value_size = sizeof(uint32_t);
+		attributes.max_entries = this->queue + 1;
+		this->xskMap = bpfCall(BPF_MAP_CREATE, &attributes);
+		if (this->xskMap == -1) {
+			printError("error %d in SocketXdp:bind:bpf(BPF_MAP_CREATE): %s\n");
+			return false;
+		}
+
+		uint32_t key = this->queue;
+		uint32_t value = this->xsk;
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.map_fd = this->xskMap;
+		attributes.key = (uint64_t) (uintptr_t) &key;
+		attributes.value = (uint64_t) (uintptr_t) &value;
+		if (bpfCall(BPF_MAP_UPDATE_ELEM, &attributes) == -1) {
+			printError("error %d in SocketXdp:bind:bpf(BPF_MAP_UPDATE_ELEM): %s\n");
+			return false;
+		}
+
+		XdpProgram code;
+		code.build(this->xskMap, &this->localAddress, XDP_FRAME_SIZE - XDP_PACKET_HEADROOM);
+		char log[4096] = { 0 };
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.prog_type = BPF_PROG_TYPE_XDP;
+		attributes.expected_attach_type = BPF_XDP;
+		attributes.insns = (uint64_t) (uintptr_t) code.code.data();
+		attributes.insn_cnt = code.code.size();
+		attributes.license = (uint64_t) (uintptr_t) "Dual BSD/GPL";
+		attributes.log_buf = (uint64_t) (uintptr_t) log;
+		attributes.log_size = sizeof(log);
+		attributes.log_level = 1;
+		this->program = bpfCall(BPF_PROG_LOAD, &attributes);
+		if (this->program == -1) {
+			printError("error %d in SocketXdp:bind:bpf(BPF_PROG_LOAD): %s\n");
+			printf("%s\n", log);
+			return false;
+		}
+
+		// the link detaches the program when it is closed, even if the process dies
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.link_create.prog_fd = this->program;
+		attributes.link_create.target_ifindex = this->interfaceIndex;
+		attributes.link_create.attach_type = BPF_XDP;
+		attributes.link_create.flags = this->nativeMode ? XDP_FLAGS_DRV_MODE : XDP_FLAGS_SKB_MODE;
+		this->link = bpfCall(BPF_LINK_CREATE, &attributes);
+		if (this->link == -1) {
+			printError("error %d in SocketXdp:bind:bpf(BPF_LINK_CREATE): %s\n");
+			return false;
+		}
+
+		// one handle which becomes readable for both paths, used for blocking receives and by pollMany()
+		this->epoll = ::epoll_create1(EPOLL_CLOEXEC);
+		if (this->epoll == -1) {
+			printError("error %d in SocketXdp:bind:epoll_create1(): %s\n");
+			return false;
+		}
+		struct epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.fd = this->xsk;
+		bool added = ::epoll_ctl(this->epoll, EPOLL_CTL_ADD, this->xsk, &event) == 0;
+		event.data.fd = this->handle;
+		added = added && ::epoll_ctl(this->epoll, EPOLL_CTL_ADD, this->handle, &event) == 0;
+		if (!added) {
+			printError("error %d in SocketXdp:bind:epoll_ctl(): %s\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	void closeXdp() {
+		if (this->link != -1) ::close(this->link);
+		if (this->program != -1) ::close(this->program);
+		if (this->xskMap != -1) ::close(this->xskMap);
+		if (this->epoll != -1) ::close(this->epoll);
+		this->link = this->program = this->xskMap = this->epoll = -1;
+		XdpRing* rings[] = { &this->rx, &this->tx, &this->fill, &this->completion };
+		for (XdpRing* ring : rings) {
+			if (ring->map != 0) ::munmap(ring->map, ring->mapLength);
+			memset(ring, 0, sizeof(XdpRing));
+		}
+		if (this->xsk != -1) ::close(this->xsk);
+		this->xsk = -1;
+		if (this->frames != 0) ::munmap(this->frames, (size_t) this->frameCount * XDP_FRAME_SIZE);
+		this->frames = 0;
+		this->freeFrames.clear();
+		std::lock_guard<std::mutex> guard(this->routeLock);
+		this->routes.clear();
+	}
+
+	void closeHandle() override {
+		closeXdp();
+		SocketLin::closeHandle();
+	}
+
+	int pollHandle() override {
+		return this->epoll;
+	}
+
+	bool hasPendingData() override {
+		HandleUse use(this);
+		return use && this->rx.map != 0 && __atomic_load_n(this->rx.producer, __ATOMIC_ACQUIRE) != *this->rx.consumer;
+	}
+
+	/*
+	 * Parses an received frame, fills in the sender and copies the payload (truncated to the buffer length)
+	 * Returns false if the frame is not an datagram for this socket or the sender is denied by the filter
+	 */
+	bool parseFrame(const unsigned char* frame, unsigned int frameLength, addr_t* address, char* buffer, unsigned int length, unsigned int* received) {
+		if (frameLength < XDP_ETH_LENGTH) return false;
+		uint16_t etherType;
+		memcpy(&etherType, frame + 12, 2);
+		const unsigned char* ip = frame + XDP_ETH_LENGTH;
+		const unsigned char* udp;
+		const unsigned char* localAddress;
+		unsigned int addressLength;
+
+		if (etherType == htons(ETHERTYPE_IP) && this->addrType == AF_INET) {
+			unsigned int ipLength = (ip[0] & 0x0f) * 4;
+			if (frameLength < XDP_ETH_LENGTH + ipLength + XDP_UDP_LENGTH || ip[9] != IPPROTO_UDP) return false;
+			udp = ip + ipLength;
+			memset(&address->sockaddr4, 0, sizeof(sockaddr_in));
+			address->sockaddr4.sin_family = AF_INET;
+			memcpy(&address->sockaddr4.sin_addr, ip + 12, 4);
+			memcpy(&address->sockaddr4.sin_port, udp, 2);
+			localAddress = ip + 16;
+			addressLength = 4;
+		} else if (etherType == htons(ETHERTYPE_IPV6) && this->addrType == AF_INET6) {
+			if (frameLength < XDP_ETH_LENGTH + XDP_IPV6_LENGTH + XDP_UDP_LENGTH || ip[6] != IPPROTO_UDP) return false;
+			udp = ip + XDP_IPV6_LENGTH;
+			memset(&address->sockaddr6, 0, sizeof(sockaddr_in6));
+			address->sockaddr6.sin6_family = AF_INET6;
+			memcpy(&address->sockaddr6.sin6_addr, ip + 8, 16);
+			memcpy(&address->sockaddr6.sin6_port, udp, 2);
+			if (IN6_IS_ADDR_LINKLOCAL(&address->sockaddr6.sin6_addr))
+				address->sockaddr6.sin6_scope_id = this->interfaceIndex;
+			localAddress = ip + 24;
+			addressLength = 16;
+		} else {
+			return false;
+		}
+		if (isDenied(address)) return false;
+
+		uint16_t udpLength;
+		memcpy(&udpLength, udp + 4, 2);
+		unsigned int payloadLength = ntohs(udpLength) - XDP_UDP_LENGTH;
+		unsigned int available = frameLength - (udp + XDP_UDP_LENGTH - frame);
+		if (ntohs(udpLength) < XDP_UDP_LENGTH || payloadLength > available) return false;
+		*received = payloadLength < length ? payloadLength : length;
+		memcpy(buffer, udp + XDP_UDP_LENGTH, *received);
+
+		// replies to this peer can take the XDP path, but only if the packet was addressed to this interface directly (not multicast)
+		// IPv4 loopback packets which do not come from the local stack are dropped as martians, so they always take the normal path
+		if (memcmp(frame, this->hardwareAddress, ETH_ALEN) == 0 && !(addressLength == 4 && ip[12] == 127)) {
+			XdpPeer peer = peerKey(addressLength == 4 ? (const void*) &address->sockaddr4.sin_addr : (const void*) &address->sockaddr6.sin6_addr, addressLength);
+			auto entry = this->routes.find(peer);
+			if (entry == this->routes.end() || memcmp(entry->second.hardwareAddress, frame + ETH_ALEN, ETH_ALEN) != 0 || memcmp(entry->second.localAddress, localAddress, addressLength) != 0) {
+				if (this->routes.size() >= XDP_ROUTE_LIMIT) this->routes.clear();
+				XdpRoute& route = this->routes[peer];
+				memcpy(route.hardwareAddress, frame + ETH_ALEN, ETH_ALEN);
+				memcpy(route.localAddress, localAddress, addressLength);
+			}
+		}
+		return true;
+	}
+
+	/*
+	 * Takes up to count datagrams from the receive ring and returns their frames to the fill ring
+	 * Returns the number of datagrams stored, frames which are not accepted by parseFrame() are skipped
+	 */
+	unsigned int receiveRing(addr_t** addresses, char** buffers, const unsigned int* lengths, unsigned int* received, unsigned int count) {
+		uint32_t consumer = *this->rx.consumer;
+		uint32_t available = __atomic_load_n(this->rx.producer, __ATOMIC_ACQUIRE) - consumer;
+		if (available == 0) {
+			// in zero copy mode the driver has to be woken up to continue filling the receive ring
+			if (__atomic_load_n(this->fill.flags, __ATOMIC_RELAXED) & XDP_RING_NEED_WAKEUP)
+				::recvfrom(this->xsk, 0, 0, MSG_DONTWAIT, 0, 0);
+			return 0;
+		}
+		if (available > count) available = count;
+
+		// the fill ring can hold all receive frames, so there is always space for the returned ones
+		uint32_t fillProducer = *this->fill.producer;
+		unsigned int accepted = 0;
+		{
+			std::lock_guard<std::mutex> guard(this->routeLock);
+			for (uint32_t i = 0; i < available; i++) {
+				const struct xdp_desc* descriptor = &((const struct xdp_desc*) this->rx.descriptors)[(consumer + i) & this->rx.mask];
+				if (parseFrame((const unsigned char*) this->frames + descriptor->addr, descriptor->len, addresses[accepted], buffers[accepted], lengths[accepted], &received[accepted]))
+					accepted++;
+				((uint64_t*) this->fill.descriptors)[(fillProducer + i) & this->fill.mask] = descriptor->addr & ~((uint64_t) XDP_FRAME_SIZE - 1);
+			}
+		}
+		__atomic_store_n(this->rx.consumer, consumer + available, __ATOMIC_RELEASE);
+		__atomic_store_n(this->fill.producer, fillProducer + available, __ATOMIC_RELEASE);
+		return accepted;
+	}
+
+	/*
+	 * Waits until one of the two paths has data, returns immediately in non blocking mode
+	 */
+	bool waitBoth(const char* errorFormat) {
+		if (!this->blocking) return true;
+		struct pollfd fd = {
+			.fd = this->epoll,
+			.events = POLLIN,
+			.revents = 0
+		};
+		int result = 0;
+		while (((result = ::poll(&fd, 1UL, READ_SOCKET_TIMEOUT)) == 0 || (result == -1 && errno == EINTR)) && isOpen());
+		if (result < 0 && isOpen()) {
+			printError(errorFormat);
+			return false;
+		}
+		return isOpen();
+	}
+
+	bool receivefrom(NetSocket::INetAddress& address, char* buffer, unsigned int length, unsigned int* received) override {
+		if (this->stype != NetSocket::LISTEN_UDP) {
+			printf("tried to call receivefrom() on unbound XDP socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*received = 0;
+		while (true) {
+			addr_t* sender = (addr_t*) address.addr;
+			if (receiveRing(&sender, &buffer, &length, received, 1) > 0)
+				return true;
+
+			socklen_t senderLength = sizeof(addr_t);
+			int result = ::recvfrom(this->handle, buffer, length, MSG_DONTWAIT, &sender->sockaddrU, &senderLength);
+			if (result >= 0) {
+				if (isDenied(sender)) continue;
+				*received = result;
+				return true;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				if (errno == EBADF || errno == EIO) {
+					close();
+					return false;
+				}
+				printError("error %d in SocketXdp:receivefrom:recvfrom(): %s\n");
+				return false;
+			}
+			if (!this->blocking)
+				return true; // nothing to read in non blocking mode
+			if (!waitBoth("error %d in SocketXdp:receivefrom:poll(): %s\n"))
+				return false;
+		}
+	}
+
+	bool receivefromBatch(NetSocket::Datagram* datagrams, unsigned int count, unsigned int* receivedCount) override {
+		if (this->stype != NetSocket::LISTEN_UDP) {
+			printf("tried to call receivefromBatch() on unbound XDP socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*receivedCount = 0;
+		if (count > UDP_BATCH_SIZE) count = UDP_BATCH_SIZE;
+		addr_t* addresses[UDP_BATCH_SIZE];
+		char* buffers[UDP_BATCH_SIZE];
+		unsigned int lengths[UDP_BATCH_SIZE];
+		unsigned int received[UDP_BATCH_SIZE];
+		for (unsigned int i = 0; i < count; i++) {
+			addresses[i] = (addr_t*) datagrams[i].address.addr;
+			buffers[i] = datagrams[i].buffer;
+			lengths[i] = datagrams[i].length;
+		}
+
+		while (true) {
+			unsigned int accepted = receiveRing(addresses, buffers, lengths, received, count);
+			if (accepted > 0) {
+				for (unsigned int i = 0; i < accepted; i++)
+					datagrams[i].received = received[i];
+				*receivedCount = accepted;
+				return true;
+			}
+
+			// the normal path without waiting, waiting is done for both paths below
+			if (!receiveBatch(datagrams, count, receivedCount, false))
+				return false;
+			if (*receivedCount > 0 || !this->blocking)
+				return true;
+			if (!waitBoth("error %d in SocketXdp:receivefromBatch:poll(): %s\n"))
+				return false;
+		}
+	}
+
+	/*
+	 * Returns the route to the peer if the datagram can be sent trough the XDP ring
+	 */
+	bool findRoute(const addr_t* address, unsigned int length, XdpRoute* route) {
+		if (address->sockaddrU.sa_family != this->addrType) return false;
+		unsigned int headerLength = (this->addrType == AF_INET6 ? XDP_IPV6_LENGTH : XDP_IPV4_LENGTH) + XDP_UDP_LENGTH;
+		if (headerLength + length > this->mtu || XDP_ETH_LENGTH + headerLength + length > XDP_FRAME_SIZE) return false;
+		XdpPeer peer = this->addrType == AF_INET6 ? peerKey(&address->sockaddr6.sin6_addr, 16) : peerKey(&address->sockaddr4.sin_addr, 4);
+		std::lock_guard<std::mutex> guard(this->routeLock);
+		auto entry = this->routes.find(peer);
+		if (entry == this->routes.end()) return false;
+		*route = entry->second;
+		return true;
+	}
+
+	/*
+	 * Writes the ethernet, IP and UDP headers and the payload into an frame, returns the frame length
+	 */
+	unsigned int buildFrame(unsigned char* frame, const XdpRoute& route, const addr_t* address, const char* buffer, unsigned int length) {
+		memcpy(frame, route.hardwareAddress, ETH_ALEN);
+		memcpy(frame + ETH_ALEN, this->hardwareAddress, ETH_ALEN);
+		unsigned char* ip = frame + XDP_ETH_LENGTH;
+		unsigned char* udp;
+		uint16_t udpLength = htons(XDP_UDP_LENGTH + length);
+		uint64_t sum;
+
+		if (this->addrType == AF_INET6) {
+			uint16_t etherType = htons(ETHERTYPE_IPV6);
+			memcpy(frame + 12, &etherType, 2);
+			uint32_t version = htonl(6U << 28);
+			memcpy(ip, &version, 4);
+			memcpy(ip + 4, &udpLength, 2);
+			ip[6] = IPPROTO_UDP;
+			ip[7] = 64;
+			memcpy(ip + 8, route.localAddress, 16);
+			memcpy(ip + 24, &address->sockaddr6.sin6_addr, 16);
+			udp = ip + XDP_IPV6_LENGTH;
+			sum = checksumAdd(0, ip + 8, 32);
+		} else {
+			uint16_t etherType = htons(ETHERTYPE_IP);
+			memcpy(frame + 12, &etherType, 2);
+			uint16_t totalLength = htons(XDP_IPV4_LENGTH + XDP_UDP_LENGTH + length);
+			uint16_t id = htons(this->nextId++);
+			uint16_t fragment = htons(IP_DF);
+			ip[0] = 0x45;
+			ip[1] = 0;
+			memcpy(ip + 2, &totalLength, 2);
+			memcpy(ip + 4, &id, 2);
+			memcpy(ip + 6, &fragment, 2);
+			ip[8] = 64;
+			ip[9] = IPPROTO_UDP;
+			ip[10] = ip[11] = 0;
+			memcpy(ip + 12, route.localAddress, 4);
+			memcpy(ip + 16, &address->sockaddr4.sin_addr, 4);
+			uint16_t check = checksumFold(checksumAdd(0, ip, XDP_IPV4_LENGTH));
+			memcpy(ip + 10, &check, 2);
+			udp = ip + XDP_IPV4_LENGTH;
+			sum = checksumAdd(0, ip + 12, 8);
+		}
+
+		memcpy(udp, this->addrType == AF_INET6 ? &this->localAddress.sockaddr6.sin6_port : &this->localAddress.sockaddr4.sin_port, 2);
+		memcpy(udp + 2, this->addrType == AF_INET6 ? &address->sockaddr6.sin6_port : &address->sockaddr4.sin_port, 2);
+		memcpy(udp + 4, &udpLength, 2);
+		udp[6] = udp[7] = 0;
+		memcpy(udp + XDP_UDP_LENGTH, buffer, length);
+
+		// pseudo header (addresses added above), then the UDP header and payload
+		sum += htons(IPPROTO_UDP);
+		sum += udpLength;
+		uint16_t check = checksumFold(checksumAdd(sum, udp, XDP_UDP_LENGTH + length));
+		if (check == 0) check = 0xffff;
+		memcpy(udp + 6, &check, 2);
+
+		return (udp + XDP_UDP_LENGTH + length) - frame;
+	}
+
+	/*
+	 * Returns the frames the kernel finished sending to the free list
+	 */
+	void reclaimFrames() {
+		uint32_t consumer = *this->completion.consumer;
+		uint32_t available = __atomic_load_n(this->completion.producer, __ATOMIC_ACQUIRE) - consumer;
+		for (uint32_t i = 0; i < available; i++)
+			this->freeFrames.push_back(((const uint64_t*) this->completion.descriptors)[(consumer + i) & this->completion.mask]);
+		__atomic_store_n(this->completion.consumer, consumer + available, __ATOMIC_RELEASE);
+	}
+
+	/*
+	 * Tells the kernel to process the transmit ring, in copy mode the frames are sent during the call, in limited budgets
+	 */
+	void kickTransmit() {
+		if (!(__atomic_load_n(this->tx.flags, __ATOMIC_RELAXED) & XDP_RING_NEED_WAKEUP)) return;
+		for (int i = 0; i < XDP_KICK_LIMIT; i++) {
+			if (::sendto(this->xsk, 0, 0, MSG_DONTWAIT, 0, 0) == 0 || errno != EAGAIN || this->zeroCopy) return;
+			if (__atomic_load_n(this->tx.consumer, __ATOMIC_ACQUIRE) == *this->tx.producer) return;
+		}
+	}
+
+	/*
+	 * Queues the datagrams which can take the XDP path, stops at the first one which can not or if no frame is free
+	 * Returns the number of datagrams queued
+	 */
+	unsigned int queueFrames(const addr_t* const* addresses, const char* const* buffers, const unsigned int* lengths, unsigned int count) {
+		reclaimFrames();
+		uint32_t producer = *this->tx.producer;
+		uint32_t space = (this->tx.mask + 1) - (producer - __atomic_load_n(this->tx.consumer, __ATOMIC_ACQUIRE));
+		unsigned int queued = 0;
+		XdpRoute route;
+		while (queued < count && queued < space && !this->freeFrames.empty() && findRoute(addresses[queued], lengths[queued], &route)) {
+			uint64_t frame = this->freeFrames.back();
+			this->freeFrames.pop_back();
+			struct xdp_desc* descriptor = &((struct xdp_desc*) this->tx.descriptors)[(producer + queued) & this->tx.mask];
+			descriptor->addr = frame;
+			descriptor->len = buildFrame((unsigned char*) this->frames + frame, route, addresses[queued], buffers[queued], lengths[queued]);
+			descriptor->options = 0;
+			queued++;
+		}
+		if (queued > 0) {
+			__atomic_store_n(this->tx.producer, producer + queued, __ATOMIC_RELEASE);
+			kickTransmit();
+		}
+		return queued;
+	}
+
+	bool sendto(const NetSocket::INetAddress& address, const char* buffer, unsigned int length) override {
+		if (this->stype != NetSocket::LISTEN_UDP) {
+			printf("tried to call sendto() on unbound XDP socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		const addr_t* target = (const addr_t*) address.addr;
+		XdpRoute route;
+		if (!findRoute(target, length, &route))
+			return SocketLin::sendto(address, buffer, length);
+
+		// wait for the kernel to complete earlier frames if all are in use
+		while (queueFrames(&target, &buffer, &length, 1) == 0) {
+			if (!this->blocking) {
+				errno = EAGAIN;
+				return false; // all frames in use in non blocking mode, like an full send buffer
+			}
+			struct pollfd fd = {
+				.fd = this->xsk,
+				.events = POLLOUT,
+				.revents = 0
+			};
+			if (::poll(&fd, 1UL, 1) == -1 && errno != EINTR) {
+				printError("error %d in SocketXdp:sendto:poll(): %s\n");
+				return false;
+			}
+			if (!isOpen()) return false;
+			kickTransmit();
+		}
+		return true;
+	}
+
+	bool sendtoBatch(const NetSocket::Datagram* datagrams, unsigned int count, unsigned int* sentCount) override {
+		if (this->stype != NetSocket::LISTEN_UDP) {
+			printf("tried to call sendtoBatch() on unbound XDP socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*sentCount = 0;
+		if (count > UDP_BATCH_SIZE) count = UDP_BATCH_SIZE;
+		const addr_t* addresses[UDP_BATCH_SIZE];
+		const char* buffers[UDP_BATCH_SIZE];
+		unsigned int lengths[UDP_BATCH_SIZE];
+		for (unsigned int i = 0; i < count; i++) {
+			addresses[i] = (const addr_t*) datagrams[i].address.addr;
+			buffers[i] = datagrams[i].buffer;
+			lengths[i] = datagrams[i].length;
+		}
+
+		// runs of datagrams with an known route take the ring, the others the normal path, the order is kept
+		while (*sentCount < count) {
+			unsigned int queued = queueFrames(addresses + *sentCount, buffers + *sentCount, lengths + *sentCount, count - *sentCount);
+			*sentCount += queued;
+			if (*sentCount == count) break;
+
+			XdpRoute route;
+			if (findRoute(addresses[*sentCount], lengths[*sentCount], &route))
+				break; // no free frame or ring space, the remaining datagrams have to be sent again
+
+			unsigned int sent = 0;
+			if (!SocketLin::sendtoBatch(datagrams + *sentCount, 1, &sent))
+				return *sentCount > 0;
+			if (sent == 0) break;
+			*sentCount += sent;
+		}
+		return true;
+	}
+
+};
+
+NetSocket::Socket* NetSocket::newXdpSocket(const char* interfaceName, unsigned int queue, bool nativeMode, unsigned int frameCount) {
+	return new SocketXdp(interfaceName, queue, nativeMode, frameCount);
+}
+
+#endif
@@ -0,0 +1,59 @@
+/*
+ * nettrace.hpp
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+#ifndef NETTRACE_HPP_
+#define NETTRACE_HPP_
+
+/*
+ * Tracing hooks used by the socket implementations, they expand to nothing unless NETSOCKET_TRACING is defined
+ */
+
+#ifdef NETSOCKET_TRACING
+
+#include <time.h>
+#include <atomic>
+#include "netsocket_trace.hpp"
+
+inline unsigned long long traceClock() {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec * 1000000000ULL + time.tv_nsec;
+}
+
+void traceRecord(NetSocket::TraceOperation operation, unsigned long long start, int handle);
+
+/*
+ * Records an span from its construction until the end of the scope, the handle is read at the end since it might not exist at the start
+ */
+class TraceScope {
+
+public:
+	NetSocket::TraceOperation operation;
+	unsigned long long start;
+	const std::atomic<int>& handle;
+
+	TraceScope(NetSocket::TraceOperation operation, const std::atomic<int>& handle) : operation(operation), start(traceClock()), handle(handle) {}
+
+	~TraceScope() {
+		traceRecord(this->operation, this->start, this->handle.load());
+	}
+
+};
+
+#define TRACE_BEGIN(name) unsigned long long name = traceClock()
+#define TRACE_END(operation, name) traceRecord(operation, name, this->handle)
+#define TRACE_SCOPE(operation) TraceScope traceScope(operation, this->handle)
+
+#else
+
+#define TRACE_BEGIN(name)
+#define TRACE_END(operation, name)
+#define TRACE_SCOPE(operation)
+
+#endif
+
+#endif /* NETTRACE_HPP_ */
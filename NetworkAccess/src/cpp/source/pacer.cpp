@@ -0,0 +1,70 @@
+#include "netsocket_pacer.hpp"
+
+using namespace std::chrono;
+
+/*
+ * Maximum number of datagrams passed to one sendtoBatch() call
+ */
+#define PACER_BATCH_SIZE 64
+
+NetSocket::UdpPacer::UdpPacer(Socket& socket, unsigned long long rate, unsigned int burst) : socket(socket) {
+	this->nextSend = steady_clock::now();
+	setRate(rate, burst);
+}
+
+void NetSocket::UdpPacer::setRate(unsigned long long rate, unsigned int burst) {
+	this->rate = rate;
+	this->burstTime = rate == 0 ? 0 : (unsigned long long) burst * 1000000000ULL / rate;
+}
+
+/*
+ * Returns the time in ns the datagram occupies at the configured rate
+ */
+unsigned long long NetSocket::UdpPacer::sendTime(unsigned int length) const {
+	return (unsigned long long) length * 1000000000ULL / this->rate;
+}
+
+bool NetSocket::UdpPacer::send(const Datagram* datagrams, unsigned int count, unsigned int* sentCount) {
+	*sentCount = 0;
+	if (this->rate == 0) {
+		while (*sentCount < count) {
+			unsigned int sent = 0;
+			if (!this->socket.sendtoBatch(datagrams + *sentCount, count - *sentCount, &sent))
+				return false;
+			*sentCount += sent;
+			if (sent == 0) break; // send buffer full
+		}
+		return true;
+	}
+
+	steady_clock::time_point now = steady_clock::now();
+	if (this->nextSend < now) this->nextSend = now;
+	steady_clock::time_point limit = now + nanoseconds(this->burstTime);
+
+	while (*sentCount < count) {
+		// the datagrams allowed by the rate, the first one only has to start within the burst time
+		steady_clock::time_point allowed[PACER_BATCH_SIZE];
+		steady_clock::time_point next = this->nextSend;
+		unsigned int batch = 0;
+		while (batch < PACER_BATCH_SIZE && *sentCount + batch < count && next <= limit) {
+			next += nanoseconds(sendTime(datagrams[*sentCount + batch].length));
+			allowed[batch++] = next;
+		}
+		if (batch == 0) break;
+
+		unsigned int sent = 0;
+		if (!this->socket.sendtoBatch(datagrams + *sentCount, batch, &sent))
+			return false;
+		if (sent > 0) this->nextSend = allowed[sent - 1];
+		*sentCount += sent;
+		if (sent < batch) break; // send buffer full
+	}
+	return true;
+}
+
+unsigned long long NetSocket::UdpPacer::waitTime() const {
+	if (this->rate == 0) return 0;
+	steady_clock::time_point limit = steady_clock::now() + nanoseconds(this->burstTime);
+	if (this->nextSend <= limit) return 0;
+	return (duration_cast<nanoseconds>(this->nextSend - limit).count() + 999) / 1000;
+}
@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <string.h>
+#include "netsocket_rpc.hpp"
+
+using namespace std::chrono;
+
+/*
+ * Frame layout (all fields in network byte order)
+ * type u8 | status u8 | reserved u16 | id u32 | length u32 | payload
+ * WINDOW frames carry the window in the id field and have no payload
+ */
+#define RPC_REQUEST 1
+#define RPC_RESPONSE 2
+#define RPC_CANCEL 3
+#define RPC_WINDOW 4
+#define RPC_HEADER_LENGTH 12
+
+/*
+ * Payloads up to this size are decoded directly from the read buffer
+ */
+#define RPC_READ_CAPACITY 65536
+
+/*
+ * Number of collected bytes which are sent even if the channel is corked
+ */
+#define RPC_CORK_LIMIT 65536
+
+static inline void writeU32(char* buffer, unsigned int value) {
+	buffer[0] = (char) (value >> 24);
+	buffer[1] = (char) (value >> 16);
+	buffer[2] = (char) (value >> 8);
+	buffer[3] = (char) value;
+}
+
+static inline unsigned int readU32(const char* buffer) {
+	return ((unsigned int) (unsigned char) buffer[0] << 24) | ((unsigned char) buffer[1] << 16) | ((unsigned char) buffer[2] << 8) | (unsigned char) buffer[3];
+}
+
+NetSocket::RpcChannel::RpcChannel(Socket& socket, unsigned int window, unsigned int maxMessage) : socket(socket), reader(socket, RPC_READ_CAPACITY) {
+	this->window = window > 0 ? window : 1;
+	this->maxMessage = maxMessage;
+	this->peerWindow = 1;
+	this->nextId = 1;
+	this->closed = false;
+	this->writing = false;
+	this->corked = false;
+	writeFrame(RPC_WINDOW, 0, this->window, 0, 0);
+}
+
+NetSocket::RpcChannel::~RpcChannel() {
+	closeChannel();
+}
+
+void NetSocket::RpcChannel::setRequestHandler(RpcHandler handler) {
+	std::lock_guard<std::mutex> guard(this->lock);
+	this->handler = handler;
+}
+
+unsigned int NetSocket::RpcChannel::inFlight() {
+	std::lock_guard<std::mutex> guard(this->lock);
+	return this->calls.size();
+}
+
+bool NetSocket::RpcChannel::writeFrame(unsigned int type, unsigned int status, unsigned int id, const char* buffer, unsigned int length) {
+	std::unique_lock<std::mutex> guard(this->writeLock);
+	size_t offset = this->pending.size();
+	this->pending.resize(offset + RPC_HEADER_LENGTH + length);
+	char* header = this->pending.data() + offset;
+	header[0] = (char) type;
+	header[1] = (char) status;
+	header[2] = header[3] = 0;
+	writeU32(header + 4, id);
+	writeU32(header + 8, length);
+	if (length > 0) memcpy(header + RPC_HEADER_LENGTH, buffer, length);
+
+	if (this->corked && this->pending.size() < RPC_CORK_LIMIT)
+		return true;
+	return flushPending(guard);
+}
+
+bool NetSocket::RpcChannel::flushPending(std::unique_lock<std::mutex>& guard) {
+	// another thread is writing, it picks up the collected frames with its next write
+	if (this->writing) return true;
+
+	this->writing = true;
+	bool success = true;
+	while (!this->pending.empty() && success) {
+		this->sending.swap(this->pending);
+		guard.unlock();
+		success = this->socket.send(this->sending.data(), this->sending.size());
+		guard.lock();
+		this->sending.clear();
+	}
+	if (!success) this->pending.clear();
+	this->writing = false;
+	return success;
+}
+
+void NetSocket::RpcChannel::cork() {
+	std::lock_guard<std::mutex> guard(this->writeLock);
+	this->corked = true;
+}
+
+bool NetSocket::RpcChannel::uncork() {
+	std::unique_lock<std::mutex> guard(this->writeLock);
+	this->corked = false;
+	return flushPending(guard);
+}
+
+bool NetSocket::RpcChannel::call(const char* buffer, unsigned int length, unsigned long timeout, RpcCallback callback) {
+	unsigned int id;
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		if (this->closed || this->calls.size() >= this->peerWindow)
+			return false;
+		do {
+			id = this->nextId++;
+		} while (id == 0 || this->calls.count(id) != 0);
+
+		Call& call = this->calls[id];
+		call.hasDeadline = timeout > 0;
+		if (call.hasDeadline) call.deadline = steady_clock::now() + milliseconds(timeout);
+		call.callback = callback;
+	}
+
+	if (!writeFrame(RPC_REQUEST, 0, id, buffer, length)) {
+		// closeChannel() or update() might already have taken the call, its callback is called by them then
+		std::lock_guard<std::mutex> guard(this->lock);
+		return this->calls.erase(id) == 0;
+	}
+	return true;
+}
+
+std::future<NetSocket::RpcResult> NetSocket::RpcChannel::call(const char* buffer, unsigned int length, unsigned long timeout) {
+	std::shared_ptr<std::promise<RpcResult>> promise = std::make_shared<std::promise<RpcResult>>();
+	std::future<RpcResult> future = promise->get_future();
+	bool sent = call(buffer, length, timeout, [promise](RpcStatus status, const char* data, unsigned int length) {
+		promise->set_value(RpcResult { status, std::string(data, length) });
+	});
+	if (!sent) {
+		std::lock_guard<std::mutex> guard(this->lock);
+		promise->set_value(RpcResult { this->closed ? RPC_CLOSED : RPC_REJECTED, std::string() });
+	}
+	return future;
+}
+
+bool NetSocket::RpcChannel::respond(unsigned int id, const char* buffer, unsigned int length, RpcStatus status) {
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		if (this->incoming.erase(id) == 0)
+			return false; // unknown or cancelled by the peer
+	}
+	return writeFrame(RPC_RESPONSE, status, id, buffer, length);
+}
+
+void NetSocket::RpcChannel::update() {
+	steady_clock::time_point now = steady_clock::now();
+	std::vector<std::pair<unsigned int, RpcCallback>> expired;
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		for (auto entry = this->calls.begin(); entry != this->calls.end();) {
+			if (entry->second.hasDeadline && entry->second.deadline <= now) {
+				expired.emplace_back(entry->first, std::move(entry->second.callback));
+				entry = this->calls.erase(entry);
+			} else {
+				entry++;
+			}
+		}
+	}
+
+	// the peer drops the request, so its window slot is free again on both sides
+	for (auto& call : expired) {
+		writeFrame(RPC_CANCEL, 0, call.first, 0, 0);
+		call.second(RPC_TIMEOUT, 0, 0);
+	}
+}
+
+void NetSocket::RpcChannel::closeChannel() {
+	std::unordered_map<unsigned int, Call> failed;
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->closed = true;
+		failed.swap(this->calls);
+		this->incoming.clear();
+	}
+	for (auto& call : failed)
+		call.second.callback(RPC_CLOSED, 0, 0);
+}
+
+bool NetSocket::RpcChannel::process() {
+	const char* header;
+	if (!this->reader.peek(RPC_HEADER_LENGTH, &header)) {
+		closeChannel();
+		return false;
+	}
+	unsigned int type = (unsigned char) header[0];
+	unsigned int status = (unsigned char) header[1];
+	unsigned int id = readU32(header + 4);
+	unsigned int length = readU32(header + 8);
+	if (length > this->maxMessage || type < RPC_REQUEST || type > RPC_WINDOW) {
+		printf("received invalid frame in RpcChannel:process()!\n");
+		closeChannel();
+		return false;
+	}
+
+	// small payloads are used in place, larger ones are read into the payload buffer
+	const char* data;
+	if (RPC_HEADER_LENGTH + length <= RPC_READ_CAPACITY) {
+		if (!this->reader.peek(RPC_HEADER_LENGTH + length, &data)) {
+			closeChannel();
+			return false;
+		}
+		data += RPC_HEADER_LENGTH;
+	} else {
+		this->reader.consume(RPC_HEADER_LENGTH);
+		this->payload.resize(length);
+		if (!this->reader.readExact(this->payload.data(), length)) {
+			closeChannel();
+			return false;
+		}
+		data = this->payload.data();
+	}
+
+	switch (type) {
+	case RPC_REQUEST: {
+		std::unique_lock<std::mutex> guard(this->lock);
+		bool accepted = this->incoming.size() < this->window && this->handler;
+		if (accepted) this->incoming.insert(id);
+		RpcHandler handler = this->handler;
+		guard.unlock();
+		if (accepted)
+			handler(id, data, length);
+		else
+			writeFrame(RPC_RESPONSE, handler ? RPC_REJECTED : RPC_ERROR, id, 0, 0);
+		break;
+	}
+	case RPC_RESPONSE: {
+		std::unique_lock<std::mutex> guard(this->lock);
+		auto entry = this->calls.find(id);
+		if (entry == this->calls.end())
+			break; // timed out before
+		RpcCallback callback = std::move(entry->second.callback);
+		this->calls.erase(entry);
+		guard.unlock();
+		callback(status <= RPC_CLOSED ? (RpcStatus) status : RPC_ERROR, data, length);
+		break;
+	}
+	case RPC_CANCEL: {
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->incoming.erase(id);
+		break;
+	}
+	case RPC_WINDOW: {
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->peerWindow = id > 0 ? id : 1;
+		break;
+	}
+	}
+
+	if (RPC_HEADER_LENGTH + length <= RPC_READ_CAPACITY)
+		this->reader.consume(RPC_HEADER_LENGTH + length);
+	return true;
+}
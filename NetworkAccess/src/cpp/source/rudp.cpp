@@ -0,0 +1,421 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "netsocket_rudp.hpp"
+
+using namespace std::chrono;
+
+/*
+ * Packet layout (all fields in network byte order)
+ * DATA: magic u8 | type u8 | mode u8 | reserved u8 | sequence u32 | messageId u32 | order u32 | fragmentIndex u16 | fragmentCount u16 | payload
+ * ACK:  magic u8 | type u8 | reserved u16 | ackSequence u32 | ackBits u32
+ */
+#define RUDP_MAGIC 0xA7
+#define RUDP_DATA 1
+#define RUDP_ACK 2
+#define RUDP_DATA_HEADER 20
+#define RUDP_ACK_LENGTH 12
+
+/*
+ * Number of sequence numbers tracked by the receiver, also limits the unacknowledged packets per peer
+ */
+#define RUDP_WINDOW 1024
+#define RUDP_MAX_RETRIES 10
+#define RUDP_MIN_RTO 20000
+#define RUDP_MAX_RTO 2000000
+#define RUDP_INITIAL_RTO 200000
+#define RUDP_FRAGMENT_TIMEOUT 5000000
+#define RUDP_RELIABLE_FRAGMENT_TIMEOUT 30000000
+#define RUDP_MAX_FRAGMENTS 0xFFFF
+
+struct ReliablePacket {
+	std::string data;
+	steady_clock::time_point sendTime;
+	unsigned int retries;
+};
+
+struct Assembly {
+	std::vector<std::string> fragments;
+	unsigned int received;
+	NetSocket::DeliveryMode mode;
+	unsigned int order;
+	steady_clock::time_point created;
+	unsigned long long bytes; // counted against ReliableUdpLimits::maxBuffered
+};
+
+struct NetSocket::ReliableUdp::Message {
+	NetSocket::INetAddress peer;
+	std::string data;
+	NetSocket::DeliveryMode mode;
+};
+
+struct NetSocket::ReliableUdp::Peer {
+	// sending side
+	unsigned int nextSequence = 0;
+	unsigned int nextMessageId = 0;
+	unsigned int nextOrder = 0;
+	std::map<unsigned int, ReliablePacket> pending;
+	long smoothedRtt = 0;
+	long rttVariance = 0;
+	long rto = RUDP_INITIAL_RTO;
+
+	// receiving side
+	bool receivedAny = false;
+	unsigned int highestReceived = 0;
+	unsigned int receivedSlots[RUDP_WINDOW];
+	std::map<unsigned int, Assembly> assemblies;
+	unsigned int expectedOrder = 0;
+	std::map<unsigned int, std::string> heldOrdered;
+	unsigned long long buffered = 0;
+};
+
+inline void putU16(char* buffer, unsigned int value) {
+	buffer[0] = (char) (value >> 8);
+	buffer[1] = (char) value;
+}
+
+inline void putU32(char* buffer, unsigned int value) {
+	buffer[0] = (char) (value >> 24);
+	buffer[1] = (char) (value >> 16);
+	buffer[2] = (char) (value >> 8);
+	buffer[3] = (char) value;
+}
+
+inline unsigned int getU16(const char* buffer) {
+	return ((unsigned char) buffer[0] << 8) | (unsigned char) buffer[1];
+}
+
+inline unsigned int getU32(const char* buffer) {
+	return ((unsigned int) (unsigned char) buffer[0] << 24) | ((unsigned char) buffer[1] << 16) | ((unsigned char) buffer[2] << 8) | (unsigned char) buffer[3];
+}
+
+/*
+ * Sequence number comparison which survives the wrap around of the 32 bit counter
+ */
+inline bool sequenceNewer(unsigned int a, unsigned int b) {
+	return (int) (a - b) > 0;
+}
+
+NetSocket::ReliableUdp::ReliableUdp(Socket& socket, unsigned int maxPayload, const ReliableUdpLimits& limits) : socket(socket) {
+	this->maxPayload = maxPayload;
+	this->limits = limits;
+	this->buffered = 0;
+}
+
+NetSocket::ReliableUdp::~ReliableUdp() {
+	for (auto& entry : this->peers)
+		delete entry.second;
+	for (Message* message : this->messages)
+		delete message;
+}
+
+NetSocket::ReliableUdp::Peer* NetSocket::ReliableUdp::getPeer(const INetAddress& address) {
+	auto entry = this->peers.find(address);
+	if (entry != this->peers.end())
+		return entry->second;
+	if (this->peers.size() >= this->limits.maxPeers)
+		return 0;
+	Peer* peer = new Peer();
+	for (unsigned int i = 0; i < RUDP_WINDOW; i++)
+		peer->receivedSlots[i] = i + 1; // no sequence number matches its slot initially
+	this->peers[address] = peer;
+	return peer;
+}
+
+void NetSocket::ReliableUdp::removePeer(std::map<INetAddress, Peer*>::iterator entry) {
+	this->buffered -= entry->second->buffered;
+	delete entry->second;
+	this->peers.erase(entry);
+}
+
+bool NetSocket::ReliableUdp::transmit(const INetAddress& address, const std::string& packet) {
+	return this->socket.sendto(address, packet.data(), packet.length());
+}
+
+bool NetSocket::ReliableUdp::send(const INetAddress& address, const char* buffer, unsigned int length, DeliveryMode mode) {
+	unsigned int fragmentCount = length == 0 ? 1 : (length + this->maxPayload - 1) / this->maxPayload;
+	if (fragmentCount > RUDP_MAX_FRAGMENTS || length > this->limits.maxMessage) {
+		printf("tried to call ReliableUdp:send() with too large message!\n");
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(this->lock);
+	Peer* peer = getPeer(address);
+	if (peer == 0) {
+		printf("tried to call ReliableUdp:send() with peer limit reached!\n");
+		return false;
+	}
+	if (mode != UNRELIABLE && peer->pending.size() + fragmentCount > RUDP_WINDOW / 2) {
+		return false; // send window full, the peer has to acknowledge first
+	}
+
+	unsigned int messageId = peer->nextMessageId++;
+	unsigned int order = mode == RELIABLE_ORDERED ? peer->nextOrder++ : 0;
+	steady_clock::time_point now = steady_clock::now();
+	bool result = true;
+	for (unsigned int i = 0; i < fragmentCount; i++) {
+		unsigned int offset = i * this->maxPayload;
+		unsigned int size = length - offset < this->maxPayload ? length - offset : this->maxPayload;
+
+		std::string packet(RUDP_DATA_HEADER + size, '\0');
+		char* header = &packet[0];
+		header[0] = (char) RUDP_MAGIC;
+		header[1] = RUDP_DATA;
+		header[2] = (char) mode;
+		unsigned int sequence = mode != UNRELIABLE ? peer->nextSequence++ : 0;
+		putU32(header + 4, sequence);
+		putU32(header + 8, messageId);
+		putU32(header + 12, order);
+		putU16(header + 16, i);
+		putU16(header + 18, fragmentCount);
+		if (size > 0) memcpy(header + RUDP_DATA_HEADER, buffer + offset, size);
+
+		if (mode != UNRELIABLE) {
+			ReliablePacket& pending = peer->pending[sequence];
+			pending.data = packet;
+			pending.sendTime = now;
+			pending.retries = 0;
+		}
+		// reliable packets are retransmitted by update() if this fails
+		result &= transmit(address, packet);
+	}
+
+	return result || mode != UNRELIABLE;
+}
+
+void NetSocket::ReliableUdp::sendAck(const INetAddress& address, Peer* peer, unsigned int ackSequence) {
+	unsigned int ackBits = 0;
+	for (unsigned int i = 0; i < 32; i++) {
+		unsigned int sequence = ackSequence - 1 - i;
+		if (peer->receivedSlots[sequence % RUDP_WINDOW] == sequence)
+			ackBits |= 1U << i;
+	}
+
+	std::string packet(RUDP_ACK_LENGTH, '\0');
+	packet[0] = (char) RUDP_MAGIC;
+	packet[1] = RUDP_ACK;
+	putU32(&packet[4], ackSequence);
+	putU32(&packet[8], ackBits);
+	transmit(address, packet);
+}
+
+void NetSocket::ReliableUdp::processAck(Peer* peer, unsigned int ackSequence, unsigned int ackBits, steady_clock::time_point now) {
+	for (int i = -1; i < 32; i++) {
+		if (i >= 0 && (ackBits & (1U << i)) == 0) continue;
+		auto entry = peer->pending.find(ackSequence - 1 - i);
+		if (entry == peer->pending.end()) continue;
+
+		// only packets sent once give an unambiguous rtt sample (Karn's algorithm)
+		if (entry->second.retries == 0) {
+			long sample = duration_cast<microseconds>(now - entry->second.sendTime).count();
+			if (peer->smoothedRtt == 0) {
+				peer->smoothedRtt = sample;
+				peer->rttVariance = sample / 2;
+			} else {
+				long delta = sample > peer->smoothedRtt ? sample - peer->smoothedRtt : peer->smoothedRtt - sample;
+				peer->rttVariance = (3 * peer->rttVariance + delta) / 4;
+				peer->smoothedRtt = (7 * peer->smoothedRtt + sample) / 8;
+			}
+			long rto = peer->smoothedRtt + 4 * peer->rttVariance;
+			peer->rto = rto < RUDP_MIN_RTO ? RUDP_MIN_RTO : rto > RUDP_MAX_RTO ? RUDP_MAX_RTO : rto;
+		}
+		peer->pending.erase(entry);
+	}
+}
+
+void NetSocket::ReliableUdp::processPacket(const INetAddress& address, const char* packet, unsigned int length) {
+	if (length < 2 || (unsigned char) packet[0] != RUDP_MAGIC) return;
+
+	steady_clock::time_point now = steady_clock::now();
+	if (packet[1] == RUDP_ACK) {
+		if (length < RUDP_ACK_LENGTH) return;
+		auto entry = this->peers.find(address);
+		if (entry != this->peers.end())
+			processAck(entry->second, getU32(packet + 4), getU32(packet + 8), now);
+		return;
+	}
+	if (packet[1] != RUDP_DATA || length < RUDP_DATA_HEADER) return;
+
+	DeliveryMode mode = (DeliveryMode) packet[2];
+	unsigned int sequence = getU32(packet + 4);
+	unsigned int messageId = getU32(packet + 8);
+	unsigned int order = getU32(packet + 12);
+	unsigned int fragmentIndex = getU16(packet + 16);
+	unsigned int fragmentCount = getU16(packet + 18);
+	unsigned int payloadLength = length - RUDP_DATA_HEADER;
+	unsigned int maxFragments = (this->limits.maxMessage + this->maxPayload - 1) / this->maxPayload;
+	if (mode > RELIABLE_ORDERED || fragmentCount == 0 || fragmentIndex >= fragmentCount) return;
+	if (payloadLength > this->maxPayload || fragmentCount > (maxFragments > 1 ? maxFragments : 1)) return;
+
+	Peer* peer = getPeer(address);
+	if (peer == 0) return; // peer limit reached
+
+	// an honest sender never has more ordered messages in flight than the window, and buffered data has to fit into the limit
+	bool aheadOrder = mode == RELIABLE_ORDERED && sequenceNewer(order, peer->expectedOrder);
+	bool newAssembly = fragmentCount > 1 && peer->assemblies.count(messageId) == 0;
+	unsigned long long cost = payloadLength + (newAssembly ? fragmentCount * sizeof(std::string) : 0);
+	bool fits = (aheadOrder ? order - peer->expectedOrder < RUDP_WINDOW : true) &&
+			((fragmentCount == 1 && !aheadOrder) || this->buffered + cost <= this->limits.maxBuffered);
+
+	if (mode != UNRELIABLE) {
+		bool duplicate = peer->receivedSlots[sequence % RUDP_WINDOW] == sequence ||
+				(peer->receivedAny && !sequenceNewer(sequence, peer->highestReceived - RUDP_WINDOW));
+		if (!duplicate && !fits)
+			return; // dropped before it is recorded and acknowledged, so the sender retransmits it later
+		if (!duplicate) {
+			peer->receivedSlots[sequence % RUDP_WINDOW] = sequence;
+			if (!peer->receivedAny || sequenceNewer(sequence, peer->highestReceived)) {
+				peer->highestReceived = sequence;
+				peer->receivedAny = true;
+			}
+		}
+		sendAck(address, peer, sequence); // based on the received sequence, since it might be far behind the highest one
+		if (duplicate) return;
+	} else if (!fits) {
+		return;
+	}
+
+	std::string payload(packet + RUDP_DATA_HEADER, payloadLength);
+	if (fragmentCount > 1) {
+		Assembly& assembly = peer->assemblies[messageId];
+		if (assembly.fragments.empty()) {
+			assembly.fragments.resize(fragmentCount);
+			assembly.received = 0;
+			assembly.mode = mode;
+			assembly.order = order;
+			assembly.created = now;
+			assembly.bytes = fragmentCount * sizeof(std::string);
+			peer->buffered += assembly.bytes;
+			this->buffered += assembly.bytes;
+		}
+		if (assembly.fragments.size() != fragmentCount || !assembly.fragments[fragmentIndex].empty()) return;
+		assembly.fragments[fragmentIndex] = payload;
+		assembly.bytes += payloadLength;
+		peer->buffered += payloadLength;
+		this->buffered += payloadLength;
+		if (++assembly.received < fragmentCount) return;
+
+		payload.clear();
+		for (std::string& fragment : assembly.fragments)
+			payload += fragment;
+		peer->buffered -= assembly.bytes;
+		this->buffered -= assembly.bytes;
+		peer->assemblies.erase(messageId);
+	}
+
+	if (mode == RELIABLE_ORDERED) {
+		if (order != peer->expectedOrder) {
+			if (sequenceNewer(order, peer->expectedOrder) && peer->heldOrdered.count(order) == 0) {
+				peer->buffered += payload.size();
+				this->buffered += payload.size();
+				peer->heldOrdered[order] = payload;
+			}
+			return;
+		}
+		this->messages.push_back(new Message { address, payload, mode });
+		peer->expectedOrder++;
+		for (auto held = peer->heldOrdered.find(peer->expectedOrder); held != peer->heldOrdered.end(); held = peer->heldOrdered.find(peer->expectedOrder)) {
+			this->messages.push_back(new Message { address, held->second, mode });
+			peer->buffered -= held->second.size();
+			this->buffered -= held->second.size();
+			peer->heldOrdered.erase(held);
+			peer->expectedOrder++;
+		}
+		return;
+	}
+
+	this->messages.push_back(new Message { address, payload, mode });
+}
+
+bool NetSocket::ReliableUdp::receive(INetAddress& peer, std::string& message, DeliveryMode* mode) {
+	std::vector<char> buffer(RUDP_DATA_HEADER + this->maxPayload + 1);
+	INetAddress sender;
+	while (true) {
+		{
+			std::lock_guard<std::mutex> guard(this->lock);
+			if (!this->messages.empty()) {
+				Message* next = this->messages.front();
+				this->messages.pop_front();
+				peer = next->peer;
+				message.swap(next->data);
+				if (mode != 0) *mode = next->mode;
+				delete next;
+				return true;
+			}
+		}
+
+		unsigned int received = 0;
+		if (!this->socket.receivefrom(sender, buffer.data(), buffer.size(), &received))
+			return false;
+		if (received == 0) continue;
+
+		std::lock_guard<std::mutex> guard(this->lock);
+		processPacket(sender, buffer.data(), received);
+	}
+}
+
+void NetSocket::ReliableUdp::update() {
+	std::lock_guard<std::mutex> guard(this->lock);
+	steady_clock::time_point now = steady_clock::now();
+	for (auto entry = this->peers.begin(); entry != this->peers.end();) {
+		Peer* peer = entry->second;
+		bool lost = false;
+		for (auto& pending : peer->pending) {
+			long timeout = peer->rto << (pending.second.retries < 5 ? pending.second.retries : 5); // exponential backoff
+			if (duration_cast<microseconds>(now - pending.second.sendTime).count() < timeout) continue;
+			if (pending.second.retries >= RUDP_MAX_RETRIES) {
+				lost = true;
+				break;
+			}
+			pending.second.retries++;
+			pending.second.sendTime = now;
+			transmit(entry->first, pending.second.data);
+		}
+
+		for (auto assembly = peer->assemblies.begin(); assembly != peer->assemblies.end();) {
+			// reliable fragments are retransmitted, so an reliable message which stays incomplete means the peer gave up or is hostile
+			bool reliable = assembly->second.mode != UNRELIABLE;
+			if (duration_cast<microseconds>(now - assembly->second.created).count() > (reliable ? RUDP_RELIABLE_FRAGMENT_TIMEOUT : RUDP_FRAGMENT_TIMEOUT)) {
+				if (reliable) lost = true;
+				peer->buffered -= assembly->second.bytes;
+				this->buffered -= assembly->second.bytes;
+				assembly = peer->assemblies.erase(assembly);
+			} else {
+				assembly++;
+			}
+		}
+
+		if (lost) {
+			this->lostPeers.push_back(entry->first);
+			auto lostEntry = entry++;
+			removePeer(lostEntry);
+		} else {
+			entry++;
+		}
+	}
+}
+
+bool NetSocket::ReliableUdp::lostPeer(INetAddress& peer) {
+	std::lock_guard<std::mutex> guard(this->lock);
+	if (this->lostPeers.empty()) return false;
+	peer = this->lostPeers.front();
+	this->lostPeers.pop_front();
+	return true;
+}
+
+bool NetSocket::ReliableUdp::getPeerStats(const INetAddress& address, unsigned long* smoothedRtt, unsigned long* rttVariance, unsigned int* pending) {
+	std::lock_guard<std::mutex> guard(this->lock);
+	auto entry = this->peers.find(address);
+	if (entry == this->peers.end()) return false;
+	*smoothedRtt = entry->second->smoothedRtt;
+	*rttVariance = entry->second->rttVariance;
+	*pending = entry->second->pending.size();
+	return true;
+}
+
+void NetSocket::ReliableUdp::disconnect(const INetAddress& address) {
+	std::lock_guard<std::mutex> guard(this->lock);
+	auto entry = this->peers.find(address);
+	if (entry == this->peers.end()) return;
+	removePeer(entry);
+}
@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <string.h>
+#include "netsocket_trace.hpp"
+
+unsigned long long NetSocket::TraceHistogram::bucketValue(unsigned int bucket) {
+	if (bucket < 16) return bucket;
+	unsigned int exponent = bucket / 16 + 3;
+	return (16ULL + bucket % 16) << (exponent - 4);
+}
+
+unsigned long long NetSocket::TraceHistogram::percentile(double percentile) const {
+	if (this->count == 0) return 0;
+	unsigned long long limit = (unsigned long long) (this->count * percentile / 100.0);
+	if (limit >= this->count) return this->maximum;
+	unsigned long long sum = 0;
+	for (unsigned int i = 0; i < TRACE_BUCKETS; i++) {
+		sum += this->buckets[i];
+		if (sum > limit) return bucketValue(i) < this->minimum ? this->minimum : bucketValue(i);
+	}
+	return this->maximum;
+}
+
+#if defined(PLATFORM_LIN) && defined(NETSOCKET_TRACING)
+
+#include <atomic>
+#include <math.h>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "nettrace.hpp"
+
+/*
+ * Number of spans kept per thread for the trace export, older spans are overwritten
+ */
+#define TRACE_BUFFER_SIZE 16384
+
+static const char* operationNames[NetSocket::TRACE_OPERATION_COUNT] = {
+	"connect", "accept wait", "receive wait", "receive", "send"
+};
+
+/*
+ * One slot of the span ring, the sequence number works as an seqlock so the exporter can detect slots overwritten while it reads them
+ */
+struct TraceSpan {
+	std::atomic<unsigned long long> sequence;
+	std::atomic<unsigned long long> start;
+	std::atomic<unsigned long long> duration;
+	std::atomic<int> operation;
+	std::atomic<int> handle;
+};
+
+/*
+ * Per thread trace state, only written by the owning thread, read by the export functions
+ * The buffers of finished threads are reused by new threads but their spans stay available until then
+ */
+struct TraceBuffer {
+	std::atomic<bool> owned;
+	long threadId;
+	std::atomic<unsigned long long> head;
+	TraceSpan spans[TRACE_BUFFER_SIZE];
+	std::atomic<unsigned long long> count[NetSocket::TRACE_OPERATION_COUNT];
+	std::atomic<unsigned long long> minimum[NetSocket::TRACE_OPERATION_COUNT];
+	std::atomic<unsigned long long> maximum[NetSocket::TRACE_OPERATION_COUNT];
+	std::atomic<unsigned long long> total[NetSocket::TRACE_OPERATION_COUNT];
+	std::atomic<unsigned long long> buckets[NetSocket::TRACE_OPERATION_COUNT][TRACE_BUCKETS];
+};
+
+static std::atomic<bool> tracingEnabled(true);
+static std::mutex buffersLock;
+static std::vector<TraceBuffer*> buffers;
+
+/*
+ * Releases the buffer of the thread when it exits
+ */
+struct TraceBufferOwner {
+	TraceBuffer* buffer = 0;
+	~TraceBufferOwner() {
+		if (this->buffer != 0) this->buffer->owned.store(false, std::memory_order_release);
+	}
+};
+
+static thread_local TraceBufferOwner threadBuffer;
+
+static void clearBuffer(TraceBuffer* buffer) {
+	buffer->head.store(0, std::memory_order_relaxed);
+	for (unsigned int i = 0; i < TRACE_BUFFER_SIZE; i++)
+		buffer->spans[i].sequence.store(0, std::memory_order_relaxed);
+	for (unsigned int o = 0; o < NetSocket::TRACE_OPERATION_COUNT; o++) {
+		buffer->count[o].store(0, std::memory_order_relaxed);
+		buffer->minimum[o].store(~0ULL, std::memory_order_relaxed);
+		buffer->maximum[o].store(0, std::memory_order_relaxed);
+		buffer->total[o].store(0, std::memory_order_relaxed);
+		for (unsigned int i = 0; i < TRACE_BUCKETS; i++)
+			buffer->buckets[o][i].store(0, std::memory_order_relaxed);
+	}
+}
+
+static TraceBuffer* acquireBuffer() {
+	std::lock_guard<std::mutex> guard(buffersLock);
+	TraceBuffer* buffer = 0;
+	for (TraceBuffer* candidate : buffers) {
+		if (!candidate->owned.load(std::memory_order_acquire)) {
+			buffer = candidate;
+			break;
+		}
+	}
+	if (buffer == 0) {
+		buffer = new TraceBuffer();
+		clearBuffer(buffer);
+		buffers.push_back(buffer);
+	}
+	buffer->owned.store(true, std::memory_order_relaxed);
+	buffer->threadId = syscall(SYS_gettid);
+	return buffer;
+}
+
+static unsigned int bucketIndex(unsigned long long value) {
+	if (value < 16) return value;
+	unsigned int exponent = 63 - __builtin_clzll(value);
+	return (exponent - 3) * 16 + ((value >> (exponent - 4)) & 15);
+}
+
+void traceRecord(NetSocket::TraceOperation operation, unsigned long long start, int handle) {
+	if (!tracingEnabled.load(std::memory_order_relaxed)) return;
+	unsigned long long duration = traceClock() - start;
+
+	TraceBuffer* buffer = threadBuffer.buffer;
+	if (buffer == 0) buffer = threadBuffer.buffer = acquireBuffer();
+
+	// only this thread writes the buffer, so plain load/store pairs are enough and avoid locked instructions
+	unsigned long long index = buffer->head.load(std::memory_order_relaxed);
+	TraceSpan& span = buffer->spans[index % TRACE_BUFFER_SIZE];
+	span.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	span.start.store(start, std::memory_order_relaxed);
+	span.duration.store(duration, std::memory_order_relaxed);
+	span.operation.store(operation, std::memory_order_relaxed);
+	span.handle.store(handle, std::memory_order_relaxed);
+	span.sequence.store(index * 2 + 2, std::memory_order_release);
+	buffer->head.store(index + 1, std::memory_order_release);
+
+	buffer->count[operation].store(buffer->count[operation].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	buffer->total[operation].store(buffer->total[operation].load(std::memory_order_relaxed) + duration, std::memory_order_relaxed);
+	if (duration < buffer->minimum[operation].load(std::memory_order_relaxed))
+		buffer->minimum[operation].store(duration, std::memory_order_relaxed);
+	if (duration > buffer->maximum[operation].load(std::memory_order_relaxed))
+		buffer->maximum[operation].store(duration, std::memory_order_relaxed);
+	std::atomic<unsigned long long>& bucket = buffer->buckets[operation][bucketIndex(duration)];
+	bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+bool NetSocket::isTracingAvailable() {
+	return true;
+}
+
+void NetSocket::setTracing(bool enabled) {
+	tracingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void NetSocket::resetTrace() {
+	std::lock_guard<std::mutex> guard(buffersLock);
+	for (TraceBuffer* buffer : buffers)
+		clearBuffer(buffer);
+}
+
+bool NetSocket::getTraceHistogram(TraceOperation operation, TraceHistogram& histogram) {
+	if (operation < 0 || operation >= TRACE_OPERATION_COUNT) {
+		printf("tried to call getTraceHistogram() with invalid operation %d!\n", operation);
+		return false;
+	}
+
+	memset(&histogram, 0, sizeof(TraceHistogram));
+	histogram.minimum = ~0ULL;
+	std::lock_guard<std::mutex> guard(buffersLock);
+	for (TraceBuffer* buffer : buffers) {
+		histogram.count += buffer->count[operation].load(std::memory_order_relaxed);
+		histogram.total += buffer->total[operation].load(std::memory_order_relaxed);
+		unsigned long long minimum = buffer->minimum[operation].load(std::memory_order_relaxed);
+		unsigned long long maximum = buffer->maximum[operation].load(std::memory_order_relaxed);
+		if (minimum < histogram.minimum) histogram.minimum = minimum;
+		if (maximum > histogram.maximum) histogram.maximum = maximum;
+		for (unsigned int i = 0; i < TRACE_BUCKETS; i++)
+			histogram.buckets[i] += buffer->buckets[operation][i].load(std::memory_order_relaxed);
+	}
+	if (histogram.count == 0) histogram.minimum = 0;
+	return true;
+}
+
+bool NetSocket::exportTraceHistogram(TraceOperation operation, const std::string& fileName) {
+	TraceHistogram* histogram = new TraceHistogram();
+	if (!getTraceHistogram(operation, *histogram)) {
+		delete histogram;
+		return false;
+	}
+
+	FILE* file = fopen(fileName.c_str(), "w");
+	if (file == 0) {
+		printf("failed to open trace histogram file %s!\n", fileName.c_str());
+		delete histogram;
+		return false;
+	}
+
+	fprintf(file, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+	unsigned long long sum = 0;
+	for (unsigned int i = 0; i < TRACE_BUCKETS; i++) {
+		if (histogram->buckets[i] == 0) continue;
+		sum += histogram->buckets[i];
+		double percentile = (double) sum / histogram->count;
+		double value = (i + 1 < TRACE_BUCKETS ? TraceHistogram::bucketValue(i + 1) - 1 : histogram->maximum) / 1000.0;
+		if (value > histogram->maximum / 1000.0) value = histogram->maximum / 1000.0;
+		if (percentile < 1.0)
+			fprintf(file, "%12.3f %2.12f %10llu %14.2f\n", value, percentile, sum, 1.0 / (1.0 - percentile));
+		else
+			fprintf(file, "%12.3f %2.12f %10llu\n", value, percentile, sum);
+	}
+
+	double mean = histogram->count > 0 ? (double) histogram->total / histogram->count / 1000.0 : 0.0;
+	double variance = 0.0;
+	for (unsigned int i = 0; i < TRACE_BUCKETS; i++) {
+		if (histogram->buckets[i] == 0) continue;
+		double deviation = TraceHistogram::bucketValue(i) / 1000.0 - mean;
+		variance += deviation * deviation * histogram->buckets[i];
+	}
+	if (histogram->count > 0) variance /= histogram->count;
+	fprintf(file, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", mean, sqrt(variance));
+	fprintf(file, "#[Max     = %12.3f, Total count    = %12llu]\n", histogram->maximum / 1000.0, histogram->count);
+	fprintf(file, "#[Buckets = %12d, SubBuckets     = %12d]\n", TRACE_BUCKETS / 16, 16);
+
+	fclose(file);
+	delete histogram;
+	return true;
+}
+
+bool NetSocket::exportChromeTrace(const std::string& fileName) {
+	FILE* file = fopen(fileName.c_str(), "w");
+	if (file == 0) {
+		printf("failed to open trace file %s!\n", fileName.c_str());
+		return false;
+	}
+
+	fprintf(file, "{\"traceEvents\":[");
+	bool first = true;
+	long processId = getpid();
+	std::lock_guard<std::mutex> guard(buffersLock);
+	for (TraceBuffer* buffer : buffers) {
+		unsigned long long head = buffer->head.load(std::memory_order_acquire);
+		for (unsigned long long index = head > TRACE_BUFFER_SIZE ? head - TRACE_BUFFER_SIZE : 0; index < head; index++) {
+			TraceSpan& span = buffer->spans[index % TRACE_BUFFER_SIZE];
+			unsigned long long sequence = span.sequence.load(std::memory_order_acquire);
+			if (sequence != index * 2 + 2) continue;
+			unsigned long long start = span.start.load(std::memory_order_relaxed);
+			unsigned long long duration = span.duration.load(std::memory_order_relaxed);
+			int operation = span.operation.load(std::memory_order_relaxed);
+			int handle = span.handle.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (span.sequence.load(std::memory_order_relaxed) != sequence) continue; // overwritten while reading
+
+			fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"netsocket\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%ld,\"tid\":%ld,\"args\":{\"socket\":%d}}",
+					first ? "" : ",", operationNames[operation], start / 1000.0, duration / 1000.0, processId, buffer->threadId, handle);
+			first = false;
+		}
+	}
+	fprintf(file, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+	fclose(file);
+	return true;
+}
+
+#else
+
+bool NetSocket::isTracingAvailable() {
+	return false;
+}
+
+void NetSocket::setTracing(bool) {}
+
+void NetSocket::resetTrace() {}
+
+bool NetSocket::getTraceHistogram(TraceOperation, TraceHistogram&) {
+	printf("tried to call getTraceHistogram(), library was built without tracing!\n");
+	return false;
+}
+
+bool NetSocket::exportTraceHistogram(TraceOperation, const std::string&) {
+	printf("tried to call exportTraceHistogram(), library was built without tracing!\n");
+	return false;
+}
+
+bool NetSocket::exportChromeTrace(const std::string&) {
+	printf("tried to call exportChromeTrace(), library was built without tracing!\n");
+	return false;
+}
+
+#endif
@@ -4,7 +4,29 @@
 #include <stdio.h>
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <mstcpip.h>
 #include <netsocket.hpp>
+#include <netsocket_filter.hpp>
+#include <netsocket_native.hpp>
+#include <netsocket_handle.hpp>
+#include <typeinfo>
+#include <atomic>
+#include "inetformat.hpp"
+
+/*
+ * Maximum number of datagrams transfered by one batch call, the same as on linux
+ */
+#define UDP_BATCH_SIZE 64
+
+/*
+ * Maximum number of buffers passed to one gathered send
+ */
+#define SEND_GATHER_SIZE 64
+
+/*
+ * Set in the user count of an socket while its handle is closed or being closed, no call can acquire the handle then
+ */
+#define HANDLE_CLOSING 0x80000000U
 
 bool NetSocket::InetInit() {
 
@@ -36,6 +58,37 @@ void printError(const char* format) {
 	}
 }
 
+/*
+ * Reads SIO_TCP_INFO (windows 10 1703 and later) of the handle into the portable statistics, winsock has no rtt variance, loss or rate estimates
+ */
+static bool readStats(SOCKET handle, NetSocket::ConnectionStats* stats) {
+	memset(stats, 0, sizeof(NetSocket::ConnectionStats));
+#ifdef SIO_TCP_INFO
+	DWORD version = 0;
+	TCP_INFO_v0 info;
+	DWORD length = 0;
+	if (::WSAIoctl(handle, SIO_TCP_INFO, &version, sizeof(version), &info, sizeof(info), &length, NULL, NULL) == SOCKET_ERROR)
+		return false;
+
+	stats->valid = true;
+	stats->rtt = info.RttUs;
+	stats->minRtt = info.MinRttUs;
+	stats->mss = info.Mss;
+	stats->congestionWindow = info.Cwnd;
+	stats->peerWindow = info.SndWnd;
+	stats->unacked = info.BytesInFlight;
+	stats->totalRetransmits = info.FastRetrans + info.TimeoutEpisodes;
+	stats->bytesSent = info.BytesOut;
+	stats->bytesAcked = info.BytesOut - info.BytesInFlight;
+	stats->bytesReceived = info.BytesIn;
+	stats->bytesRetransmitted = info.BytesRetrans;
+	return true;
+#else
+	SetLastError(WSAEOPNOTSUPP);
+	return false;
+#endif
+}
+
 typedef union {
 		sockaddr sockaddrU;
 		sockaddr_in sockaddr4;
@@ -85,44 +138,100 @@ bool NetSocket::INetAddress::operator==(const NetSocket::INetAddress& other) con
 	return compare(other) == 0;
 }
 
-bool NetSocket::INetAddress::fromstr(std::string& addressStr, unsigned int port) {
-	if (inet_pton(AF_INET, addressStr.c_str(), &((addr_t*) this->addr)->sockaddr4.sin_addr) == 1) {
-		((addr_t*) this->addr)->sockaddr4.sin_family = AF_INET;
-		((addr_t*) this->addr)->sockaddr4.sin_port = htons(port);
+bool NetSocket::INetAddress::parse(const char* addressStr, unsigned int length, unsigned int port) {
+	addr_t* address = (addr_t*) this->addr;
+	if (parseInet4(addressStr, length, (unsigned char*) &address->sockaddr4.sin_addr)) {
+		address->sockaddr4.sin_family = AF_INET;
+		address->sockaddr4.sin_port = htons(port);
+		memset(address->sockaddr4.sin_zero, 0, sizeof(address->sockaddr4.sin_zero));
 		return true;
-	} else if (inet_pton(AF_INET6, addressStr.c_str(), &((addr_t*) this->addr)->sockaddr6.sin6_addr) == 1) {
-		((addr_t*) this->addr)->sockaddr6.sin6_family = AF_INET6;
-		((addr_t*) this->addr)->sockaddr6.sin6_port = htons(port);
+	} else if (parseInet6(addressStr, length, (unsigned char*) &address->sockaddr6.sin6_addr)) {
+		address->sockaddr6.sin6_family = AF_INET6;
+		address->sockaddr6.sin6_port = htons(port);
+		address->sockaddr6.sin6_flowinfo = 0;
+		address->sockaddr6.sin6_scope_id = 0;
 		return true;
-	} else {
-		printf("INetAddress:fromstr:inet_pton() failed for AF_INET and AF_INET6!\n");
+	}
+	return false;
+}
+
+bool NetSocket::INetAddress::fromstr(std::string& addressStr, unsigned int port) {
+	if (!parse(addressStr.c_str(), addressStr.length(), port)) {
+		printf("INetAddress:fromstr() failed for AF_INET and AF_INET6!\n");
 		return false;
 	}
+	return true;
 }
 
-bool NetSocket::INetAddress::tostr(std::string& addressStr, unsigned int* port) const {
-	if (((addr_t*) this->addr)->sockaddrU.sa_family == AF_INET) {
-		char addrStr[INET_ADDRSTRLEN];
-		if (inet_ntop(AF_INET, &((addr_t*) this->addr)->sockaddr4.sin_addr, addrStr, INET_ADDRSTRLEN) == 0) {
-			printError("Error %lu in INetAddress:tostr:inet_ntop(): %s");
-			return false;
-		}
-		*port = htons(((addr_t*) this->addr)->sockaddr4.sin_port);
-		addressStr = std::string(addrStr);
+bool NetSocket::INetAddress::frombytes(const unsigned char* bytes, unsigned int length, unsigned int port) {
+	addr_t* address = (addr_t*) this->addr;
+	if (length == 4) {
+		memset(&address->sockaddr4, 0, sizeof(SOCKADDR_IN));
+		address->sockaddr4.sin_family = AF_INET;
+		address->sockaddr4.sin_port = htons(port);
+		memcpy(&address->sockaddr4.sin_addr, bytes, 4);
 		return true;
-	} else if (((addr_t*) this->addr)->sockaddrU.sa_family == AF_INET6) {
-		char addrStr[INET6_ADDRSTRLEN];
-		if (inet_ntop(((addr_t*) this->addr)->sockaddr6.sin6_family, &((addr_t*) this->addr)->sockaddr6.sin6_addr, addrStr, INET6_ADDRSTRLEN) == 0) {
-			printError("Error %lu in INetAddress:tostr:inet_ntop(): %s");
-			return false;
-		}
-		*port = htons(((addr_t*) this->addr)->sockaddr6.sin6_port);
-		addressStr = std::string(addrStr);
+	} else if (length == 16) {
+		memset(&address->sockaddr6, 0, sizeof(SOCKADDR_IN6));
+		address->sockaddr6.sin6_family = AF_INET6;
+		address->sockaddr6.sin6_port = htons(port);
+		memcpy(&address->sockaddr6.sin6_addr, bytes, 16);
 		return true;
-	} else {
-		printf("INetAddress:tostr:str_to_inet() with non AF_INET or AF_INET6 address!\n");
+	}
+	printf("INetAddress:frombytes() with length other than 4 or 16 bytes!\n");
+	return false;
+}
+
+bool NetSocket::INetAddress::tobytes(unsigned char* bytes, unsigned int* length, unsigned int* port) const {
+	const addr_t* address = (addr_t*) this->addr;
+	if (address->sockaddrU.sa_family == AF_INET) {
+		memcpy(bytes, &address->sockaddr4.sin_addr, 4);
+		*length = 4;
+		*port = ntohs(address->sockaddr4.sin_port);
+		return true;
+	} else if (address->sockaddrU.sa_family == AF_INET6) {
+		memcpy(bytes, &address->sockaddr6.sin6_addr, 16);
+		*length = 16;
+		*port = ntohs(address->sockaddr6.sin6_port);
+		return true;
+	}
+	return false;
+}
+
+bool NetSocket::INetAddress::fromunix(const std::string& path) {
+	printf("INetAddress:fromunix() unix domain sockets are not supported on this platform!\n");
+	return false;
+}
+
+bool NetSocket::INetAddress::format(char* buffer, unsigned int capacity, unsigned int* length, unsigned int* port) const {
+	const addr_t* address = (addr_t*) this->addr;
+	if (address->sockaddrU.sa_family != AF_INET && address->sockaddrU.sa_family != AF_INET6) {
+		printf("INetAddress:format() with non AF_INET or AF_INET6 address!\n");
+		return false;
+	}
+	bool inet4 = address->sockaddrU.sa_family == AF_INET;
+	if (capacity < (inet4 ? INET4_FORMAT_LENGTH : INET6_FORMAT_LENGTH) + 1) {
+		printf("tried to call INetAddress:format() with too small buffer!\n");
 		return false;
 	}
+	if (inet4) {
+		*length = formatInet4((const unsigned char*) &address->sockaddr4.sin_addr, buffer);
+		*port = ntohs(address->sockaddr4.sin_port);
+	} else {
+		*length = formatInet6((const unsigned char*) &address->sockaddr6.sin6_addr, buffer);
+		*port = ntohs(address->sockaddr6.sin6_port);
+	}
+	buffer[*length] = '\0';
+	return true;
+}
+
+bool NetSocket::INetAddress::tostr(std::string& addressStr, unsigned int* port) const {
+	char buffer[INET_ADDRESS_LENGTH];
+	unsigned int length = 0;
+	if (!format(buffer, sizeof(buffer), &length, port))
+		return false;
+	addressStr.assign(buffer, length);
+	return true;
 }
 
 bool NetSocket::resolveInet(const std::string& hostStr, const std::string& portStr, bool lookForUDP, std::vector<NetSocket::INetAddress>& addresses) {
@@ -151,17 +260,60 @@ bool NetSocket::resolveInet(const std::string& hostStr, const std::string& portS
 	return true;
 }
 
+/*
+ * Scope of an socket option, options are rejected by setOption() and skipped in profiles for sockets outside their scope
+ */
+#define OPTION_ANY 0
+#define OPTION_TCP 1
+#define OPTION_UDP 2
+
+/*
+ * Resolves the level and name of an socket option, options not available on windows are rejected
+ * IP level options are mapped to their IPv6 counterparts for AF_INET6 sockets
+ */
+bool optionName(NetSocket::SocketOption option, unsigned short family, int* level, int* name, int* scope) {
+	switch (option) {
+	case NetSocket::OPT_RECEIVE_BUFFER: *level = SOL_SOCKET; *name = SO_RCVBUF; *scope = OPTION_ANY; return true;
+	case NetSocket::OPT_SEND_BUFFER: *level = SOL_SOCKET; *name = SO_SNDBUF; *scope = OPTION_ANY; return true;
+	case NetSocket::OPT_NO_DELAY: *level = IPPROTO_TCP; *name = TCP_NODELAY; *scope = OPTION_TCP; return true;
+	case NetSocket::OPT_REUSE_ADDRESS: *level = SOL_SOCKET; *name = SO_REUSEADDR; *scope = OPTION_ANY; return true;
+	case NetSocket::OPT_MULTICAST_TTL: *level = family == AF_INET6 ? IPPROTO_IPV6 : IPPROTO_IP; *name = family == AF_INET6 ? IPV6_MULTICAST_HOPS : IP_MULTICAST_TTL; *scope = OPTION_UDP; return true;
+	case NetSocket::OPT_MULTICAST_LOOP: *level = family == AF_INET6 ? IPPROTO_IPV6 : IPPROTO_IP; *name = family == AF_INET6 ? IPV6_MULTICAST_LOOP : IP_MULTICAST_LOOP; *scope = OPTION_UDP; return true;
+	case NetSocket::OPT_MULTICAST_INTERFACE: *level = family == AF_INET6 ? IPPROTO_IPV6 : IPPROTO_IP; *name = family == AF_INET6 ? IPV6_MULTICAST_IF : IP_MULTICAST_IF; *scope = OPTION_UDP; return true;
+	default: return false;
+	}
+}
+
+/*
+ * Converts an option value to the format expected by the system, IP_MULTICAST_IF takes the interface index in network byte order
+ */
+DWORD optionValue(int level, int name, int value) {
+	if (level == IPPROTO_IP && name == IP_MULTICAST_IF)
+		return htonl(value);
+	return value;
+}
+
 class SocketWin : public NetSocket::Socket {
 
 public:
-	NetSocket::SocketType stype;
-	SOCKET handle;
+	std::atomic<NetSocket::SocketType> stype;
+	std::atomic<SOCKET> handle;
+	std::atomic<unsigned int> users; // calls currently using the handle, plus HANDLE_CLOSING
 	unsigned short addrType;
+	NetSocket::SocketProfile profile;
+	bool blocking;
+	const NetSocket::AddressFilter* filter;
+	addr_t remoteAddress;
+	int remoteLength;
 
 	SocketWin() {
 		this->stype = NetSocket::UNBOUND;
 		this->handle = INVALID_SOCKET;
+		this->users = HANDLE_CLOSING;
 		this->addrType = 0;
+		this->blocking = true;
+		this->filter = 0;
+		this->remoteLength = 0;
 	}
 
 	~SocketWin() override {
@@ -174,6 +326,51 @@ public:
 		return this->stype;
 	}
 
+	/*
+	 * Reference to the handle held for the duration of an call, close() on another thread only marks the socket as closing
+	 * and cancels blocked calls, the handle is released when the last reference is dropped, so it can never be reused while in use
+	 */
+	class HandleUse {
+	public:
+		HandleUse(SocketWin* socket) : socket(socket), acquired(socket->acquireHandle()) {}
+		~HandleUse() {
+			if (this->acquired) this->socket->releaseHandle();
+		}
+		explicit operator bool() const {
+			return this->acquired;
+		}
+	private:
+		SocketWin* socket;
+		bool acquired;
+	};
+
+	/*
+	 * Adds an reference to the handle, returns false if the socket is closed or being closed
+	 */
+	bool acquireHandle() {
+		unsigned int users = this->users.load(std::memory_order_relaxed);
+		do {
+			if (users & HANDLE_CLOSING) return false;
+		} while (!this->users.compare_exchange_weak(users, users + 1, std::memory_order_acquire, std::memory_order_relaxed));
+		return true;
+	}
+
+	/*
+	 * Drops an reference to the handle, the last reference after close() releases it
+	 */
+	void releaseHandle() {
+		if (this->users.fetch_sub(1, std::memory_order_acq_rel) == (HANDLE_CLOSING | 1))
+			closeHandle();
+	}
+
+	/*
+	 * Publishes an fully set up handle, calls can acquire it from now on
+	 */
+	void setOpen(NetSocket::SocketType type) {
+		this->stype = type;
+		this->users.store(0, std::memory_order_release);
+	}
+
 	int lastError() override {
 		return GetLastError();
 	}
@@ -184,6 +381,15 @@ public:
 			return false;
 		}
 
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		if (this->remoteLength > 0) {
+			// known from connect() or accept()
+			memcpy(address.addr, &this->remoteAddress, this->remoteLength);
+			return true;
+		}
+
 		int addrlen = sizeof(addr_t);
 		if (::getpeername(this->handle, &((addr_t*) address.addr)->sockaddrU, &addrlen) == SOCKET_ERROR) {
 			if (GetLastError() == ERROR_INVALID_HANDLE) {
@@ -203,6 +409,9 @@ public:
 			return false;
 		}
 
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
 		DWORD optval = enableBuffering ? 0 : 1;
 		if (::setsockopt(this->handle, IPPROTO_TCP, TCP_NODELAY, (const char*) &optval, sizeof(DWORD)) == SOCKET_ERROR) {
 			if (GetLastError() == ERROR_INVALID_HANDLE) {
@@ -222,6 +431,9 @@ public:
 			return false;
 		}
 
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
 		int optlen = sizeof(DWORD);
 		DWORD optval = 0;
 		if (::getsockopt(this->handle, IPPROTO_TCP, TCP_NODELAY, (char*) &optval, &optlen) == SOCKET_ERROR) {
@@ -237,6 +449,96 @@ public:
 		return true;
 	}
 
+	bool setOption(NetSocket::SocketOption option, int value) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call setOption() on unbound socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		int level, name, scope;
+		if (!optionName(option, this->addrType, &level, &name, &scope)) {
+			printf("tried to call setOption() with option %d, not supported on this platform!\n", option);
+			return false;
+		}
+		if (scope == OPTION_UDP && this->stype != NetSocket::LISTEN_UDP) {
+			printf("tried to call setOption() with option %d on non LISTEN_UDP socket!\n", option);
+			return false;
+		}
+
+		DWORD optval = optionValue(level, name, value);
+		if (::setsockopt(this->handle, level, name, (const char*) &optval, sizeof(DWORD)) == SOCKET_ERROR) {
+			if (GetLastError() == ERROR_INVALID_HANDLE) {
+				close();
+				return false;
+			}
+			printError("error 0x%x in Socket:setOption:setsockopt(): %s");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool getOption(NetSocket::SocketOption option, int* value) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call getOption() on unbound socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		int level, name, scope;
+		if (!optionName(option, this->addrType, &level, &name, &scope)) {
+			printf("tried to call getOption() with option %d, not supported on this platform!\n", option);
+			return false;
+		}
+
+		int optlen = sizeof(DWORD);
+		DWORD optval = 0;
+		if (::getsockopt(this->handle, level, name, (char*) &optval, &optlen) == SOCKET_ERROR) {
+			if (GetLastError() == ERROR_INVALID_HANDLE) {
+				close();
+				return false;
+			}
+			printError("error 0x%x in Socket:getOption:getsockopt(): %s");
+			return false;
+		}
+
+		*value = level == IPPROTO_IP && name == IP_MULTICAST_IF ? ntohl(optval) : optval;
+		return true;
+	}
+
+	bool setProfile(const NetSocket::SocketProfile& profile) override {
+		this->profile = profile;
+		if (this->stype == NetSocket::UNBOUND)
+			return true;
+		HandleUse use(this);
+		if (!use) return true; // closed by another thread
+		return applyProfile(this->handle, this->profile, this->stype);
+	}
+
+	/*
+	 * Applies all options of the profile which are available on windows, stops at the first failure
+	 */
+	bool applyProfile(SOCKET handle, const NetSocket::SocketProfile& profile, NetSocket::SocketType type) {
+		for (int i = 0; i < NetSocket::OPT_COUNT; i++) {
+			if (profile.values[i] == -1) continue;
+			int level, name, scope;
+			if (!optionName((NetSocket::SocketOption) i, this->addrType, &level, &name, &scope)) continue;
+			if (scope == OPTION_TCP && type == NetSocket::LISTEN_UDP) continue;
+			if (scope == OPTION_UDP && type != NetSocket::LISTEN_UDP) continue;
+			DWORD optval = optionValue(level, name, profile.values[i]);
+			if (::setsockopt(handle, level, name, (const char*) &optval, sizeof(DWORD)) == SOCKET_ERROR) {
+				printError("error 0x%x in Socket:applyProfile:setsockopt(): %s");
+				return false;
+			}
+		}
+		return true;
+	}
+
 	bool listen(const NetSocket::INetAddress& address) override {
 		if (this->stype != NetSocket::UNBOUND) {
 			printf("tried to call listen() on already bound socket!\n");
@@ -250,6 +552,12 @@ public:
 			return false;
 		}
 
+		if (!applyProfile(this->handle, this->profile, NetSocket::LISTEN_TCP) || !applyBlocking(this->handle, this->blocking)) {
+			::closesocket(this->handle);
+			this->handle = INVALID_SOCKET;
+			return false;
+		}
+
 		int result = ::bind(this->handle, &((addr_t*) address.addr)->sockaddrU, ((addr_t*) address.addr)->sockaddrU.sa_family == AF_INET ? sizeof(SOCKADDR_IN) : sizeof(SOCKADDR_IN6));
 		if (result == SOCKET_ERROR) {
 			printError("error 0x%x in Socket:listen:bind(): %s");
@@ -266,7 +574,7 @@ public:
 			return false;
 		}
 
-		this->stype = NetSocket::LISTEN_TCP;
+		setOpen(NetSocket::LISTEN_TCP);
 		return true;
 	}
 
@@ -283,6 +591,12 @@ public:
 			return false;
 		}
 
+		if (!applyProfile(this->handle, this->profile, NetSocket::LISTEN_UDP) || !applyBlocking(this->handle, this->blocking)) {
+			::closesocket(this->handle);
+			this->handle = INVALID_SOCKET;
+			return false;
+		}
+
 		if (::bind(this->handle, &((addr_t*) address.addr)->sockaddrU, ((addr_t*) address.addr)->sockaddrU.sa_family == AF_INET ? sizeof(SOCKADDR_IN) : sizeof(SOCKADDR_IN6)) == SOCKET_ERROR) {
 			printError("error 0x%x in Socket:bind:bind(): %s");
 			::closesocket(this->handle);
@@ -290,7 +604,7 @@ public:
 			return false;
 		}
 
-		this->stype = NetSocket::LISTEN_UDP;
+		setOpen(NetSocket::LISTEN_UDP);
 		return true;
 	}
 
@@ -304,15 +618,60 @@ public:
 			return false;
 		}
 
-		SOCKET clientSocket = ::accept(this->handle, NULL, NULL);
-		if (clientSocket == INVALID_SOCKET) {
-			printError("error 0x%x in Socket:accept:accept(): %s");
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		addr_t* peer = &((SocketWin&) socket).remoteAddress;
+		int peerLength;
+		SOCKET clientSocket;
+		do {
+			peerLength = sizeof(addr_t);
+			clientSocket = ::accept(this->handle, &peer->sockaddrU, &peerLength);
+			if (clientSocket == INVALID_SOCKET) {
+				if (WSAGetLastError() == WSAEWOULDBLOCK && !this->blocking)
+					return false; // no connection queued
+				if (!isOpen())
+					return false; // closed by another thread
+				printError("error 0x%x in Socket:accept:accept(): %s");
+				return false;
+			}
+			if (isDenied(peer)) {
+				// dropped before any option work is done for it
+				::closesocket(clientSocket);
+				clientSocket = INVALID_SOCKET;
+			}
+		} while (clientSocket == INVALID_SOCKET);
+
+		bool ownProfile = false;
+		for (int i = 0; i < NetSocket::OPT_COUNT; i++)
+			if (((SocketWin&) socket).profile.values[i] != -1) ownProfile = true;
+		if (!applyProfile(clientSocket, ownProfile ? ((SocketWin&) socket).profile : this->profile, NetSocket::STREAM) ||
+			!applyBlocking(clientSocket, ((SocketWin&) socket).blocking)) {
+			::closesocket(clientSocket);
 			return false;
 		}
 
 		((SocketWin&) socket).addrType = this->addrType;
+		((SocketWin&) socket).remoteLength = peerLength;
 		((SocketWin&) socket).handle = clientSocket;
-		((SocketWin&) socket).stype = NetSocket::STREAM;
+		((SocketWin&) socket).setOpen(NetSocket::STREAM);
+		return true;
+	}
+
+	/*
+	 * Checks the address of an peer against the filter
+	 */
+	bool isDenied(const addr_t* address) {
+		if (this->filter == 0) return false;
+		if (address->sockaddrU.sa_family == AF_INET)
+			return !this->filter->isAllowed((const unsigned char*) &address->sockaddr4.sin_addr, 4);
+		if (address->sockaddrU.sa_family == AF_INET6)
+			return !this->filter->isAllowed((const unsigned char*) &address->sockaddr6.sin6_addr, 16);
+		return false;
+	}
+
+	bool setFilter(const NetSocket::AddressFilter* filter) override {
+		this->filter = filter;
 		return true;
 	}
 
@@ -322,6 +681,9 @@ public:
 			return false;
 		}
 
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
 		DWORD rcvTimeout = readTimeout;
 		DWORD sndTimeout = writeTimeout;
 		bool b1 = setsockopt(this->handle, SOL_SOCKET, SO_RCVTIMEO, (const char*) &rcvTimeout, sizeof(DWORD)) == 0;
@@ -335,6 +697,9 @@ public:
 			return false;
 		}
 
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
 		int optlen = 0;
 		DWORD rcvTimeout = 0;
 		DWORD sndTimeout = 0;
@@ -356,6 +721,13 @@ public:
 			printError("error 0x%x in Socket:connect:socket(): %s");
 			return false;
 		}
+		this->addrType = ((addr_t*) address.addr)->sockaddrU.sa_family;
+
+		if (!applyProfile(this->handle, this->profile, NetSocket::STREAM)) {
+			::closesocket(this->handle);
+			this->handle = INVALID_SOCKET;
+			return false;
+		}
 
 		unsigned long nonblock = 1;
 		if (::ioctlsocket(this->handle, FIONBIO, &nonblock) == SOCKET_ERROR) {
@@ -407,52 +779,245 @@ public:
 
 		}
 
-		nonblock = 0;
+		nonblock = this->blocking ? 0 : 1;
 		if (::ioctlsocket(this->handle, FIONBIO, &nonblock) == SOCKET_ERROR) {
-			printError("error 0x%x in Socket:connect:ioctlsocket(FIONBIO=0): %s");
+			printError("error 0x%x in Socket:connect:ioctlsocket(FIONBIO): %s");
 			::closesocket(this->handle);
 			this->handle = INVALID_SOCKET;
 			return false;
 		}
 
-		this->stype = NetSocket::STREAM;
+		this->remoteLength = ((addr_t*) address.addr)->sockaddrU.sa_family == AF_INET ? sizeof(SOCKADDR_IN) : sizeof(SOCKADDR_IN6);
+		memcpy(&this->remoteAddress, address.addr, this->remoteLength);
+		setOpen(NetSocket::STREAM);
 		return true;
 	}
 
+	bool connectFastOpen(const NetSocket::INetAddress& address, unsigned long timeout, const char* buffer, unsigned int length, bool* fastOpenUsed) override {
+		// fast open requires ConnectEx() on windows, fall back to an normal handshake
+		*fastOpenUsed = false;
+		return connect(address, timeout) && (length == 0 || send(buffer, length));
+	}
+
 	void close() override {
-		if (this->stype == NetSocket::UNBOUND) return;
-		::closesocket(this->handle);
+		unsigned int users = this->users.load(std::memory_order_relaxed);
+		do {
+			if (users & HANDLE_CLOSING) return; // not open or already closing
+		} while (!this->users.compare_exchange_weak(users, users == 0 ? HANDLE_CLOSING : (users + 1) | HANDLE_CLOSING, std::memory_order_acq_rel, std::memory_order_relaxed));
+		if (users == 0) {
+			closeHandle();
+		} else {
+			// blocking winsock calls are not woken up by shutdown(), their pending I/O has to be canceled
+			// the own reference keeps the handle from being closed and reused meanwhile
+			::shutdown(this->handle, SD_BOTH);
+			::CancelIoEx((HANDLE) (SOCKET) this->handle, NULL);
+			releaseHandle();
+		}
+	}
+
+	/*
+	 * Releases the handle after close() once no call uses it anymore
+	 * The type is reset last, so the socket can not be opened again before the old handle is closed
+	 */
+	void closeHandle() {
+		SOCKET handle = this->handle;
 		this->handle = INVALID_SOCKET;
+		this->remoteLength = 0;
+		::closesocket(handle);
 		this->stype = NetSocket::UNBOUND;
 	}
 
 	bool isOpen() override {
-		return this->stype != NetSocket::UNBOUND && this->handle != INVALID_SOCKET;
+		return (this->users.load(std::memory_order_relaxed) & HANDLE_CLOSING) == 0;
 	}
 
-	bool send(const char* buffer, unsigned int length) override {
-		if (this->stype == NetSocket::UNBOUND) {
-			printf("tried to call send() on unbound socket!\n");
+	static bool applyBlocking(SOCKET handle, bool blocking) {
+		unsigned long nonblock = blocking ? 0 : 1;
+		if (::ioctlsocket(handle, FIONBIO, &nonblock) == SOCKET_ERROR) {
+			printError("error 0x%x in Socket:applyBlocking:ioctlsocket(FIONBIO): %s");
 			return false;
-		} else if (this->stype != NetSocket::STREAM) {
-			printf("tried to call send() on non STREAM socket!\n");
+		}
+		return true;
+	}
+
+	/*
+	 * Waits until the handle is ready for the event, returns false on timeout or error
+	 */
+	bool waitFor(short event, int timeout) {
+		WSAPOLLFD fd = {
+			.fd = this->handle,
+			.events = event,
+			.revents = 0
+		};
+		int result = ::WSAPoll(&fd, 1, timeout);
+		if (result == SOCKET_ERROR) {
+			printError("error 0x%x in Socket:waitFor:WSAPoll(): %s");
 			return false;
 		}
+		return result > 0;
+	}
+
+	bool setBlocking(bool blocking) override {
+		this->blocking = blocking;
+		if (this->stype == NetSocket::UNBOUND)
+			return true;
+		HandleUse use(this);
+		if (!use) return true; // closed by another thread
+		return applyBlocking(this->handle, blocking);
+	}
+
+	bool getBlocking(bool* blocking) override {
+		*blocking = this->blocking;
+		return true;
+	}
+
+	bool trySend(const char* buffer, unsigned int length, unsigned int* sent, bool* wouldBlock) override {
+		if (this->stype != NetSocket::STREAM) {
+			printf("tried to call trySend() on non STREAM socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		// winsock has no per call non blocking flag, so check for space first if the socket is blocking
+		*sent = 0;
+		*wouldBlock = true;
+		if (this->blocking && !waitFor(POLLWRNORM, 0))
+			return true;
 
 		int result = ::send(this->handle, buffer, length, 0);
 		if (result == SOCKET_ERROR) {
-			if (WSAGetLastError() == WSAETIMEDOUT)
-				return true; // timed out
+			if (WSAGetLastError() == WSAEWOULDBLOCK)
+				return true;
+			else if (WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAECONNABORTED)
+				return false; // connection closed
+			if (GetLastError() == ERROR_INVALID_HANDLE) {
+				close();
+				return false;
+			}
+			printError("error 0x%x in Socket:trySend:send(): %s");
+			return false;
+		}
+
+		*sent = result;
+		*wouldBlock = (unsigned int) result < length;
+		return true;
+	}
+
+	bool trySendGather(const NetSocket::SendBuffer* buffers, unsigned int count, unsigned int* sent, bool* wouldBlock) override {
+		if (this->stype != NetSocket::STREAM) {
+			printf("tried to call trySendGather() on non STREAM socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*sent = 0;
+		*wouldBlock = true;
+		if (this->blocking && !waitFor(POLLWRNORM, 0))
+			return true;
+
+		if (count > SEND_GATHER_SIZE) count = SEND_GATHER_SIZE;
+		WSABUF payloads[SEND_GATHER_SIZE];
+		unsigned long long length = 0;
+		for (unsigned int i = 0; i < count; i++) {
+			payloads[i].buf = (CHAR*) buffers[i].buffer;
+			payloads[i].len = buffers[i].length;
+			length += buffers[i].length;
+		}
+
+		DWORD result = 0;
+		if (::WSASend(this->handle, payloads, count, &result, 0, NULL, NULL) == SOCKET_ERROR) {
+			if (WSAGetLastError() == WSAEWOULDBLOCK)
+				return true;
 			else if (WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAECONNABORTED)
 				return false; // connection closed
 			if (GetLastError() == ERROR_INVALID_HANDLE) {
 				close();
 				return false;
 			}
-			printError("error 0x%x in Socket:send:send(): %s");
+			printError("error 0x%x in Socket:trySendGather:WSASend(): %s");
 			return false;
 		}
 
+		*sent = result;
+		*wouldBlock = result < length;
+		return true;
+	}
+
+	bool tryReceive(char* buffer, unsigned int length, unsigned int* received, bool* wouldBlock) override {
+		if (this->stype != NetSocket::STREAM) {
+			printf("tried to call tryReceive() on non STREAM socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		*received = 0;
+		*wouldBlock = true;
+		if (this->blocking && !waitFor(POLLRDNORM, 0))
+			return true;
+
+		int result = ::recv(this->handle, buffer, length, 0);
+		if (result == 0) {
+			return false; // connection closed
+		} else if (result == SOCKET_ERROR) {
+			if (WSAGetLastError() == WSAEWOULDBLOCK)
+				return true;
+			else if (WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAECONNABORTED)
+				return false; // connection closed
+			if (GetLastError() == ERROR_INVALID_HANDLE) {
+				close();
+				return false;
+			}
+			printError("error 0x%x in Socket:tryReceive:recv(): %s");
+			return false;
+		}
+
+		*wouldBlock = false;
+		*received = result;
+		return true;
+	}
+
+	bool send(const char* buffer, unsigned int length) override {
+		if (this->stype == NetSocket::UNBOUND) {
+			printf("tried to call send() on unbound socket!\n");
+			return false;
+		} else if (this->stype != NetSocket::STREAM) {
+			printf("tried to call send() on non STREAM socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		while (length > 0) {
+			int result = ::send(this->handle, buffer, length, 0);
+			if (result == SOCKET_ERROR) {
+				if (WSAGetLastError() == WSAEWOULDBLOCK && !this->blocking) {
+					// send() always transmits the whole buffer, only trySend() returns early in non blocking mode
+					if (!waitFor(POLLWRNORM, -1))
+						return false;
+					continue;
+				}
+				if (WSAGetLastError() == WSAETIMEDOUT)
+					return true; // timed out
+				else if (WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAECONNABORTED)
+					return false; // connection closed
+				if (GetLastError() == ERROR_INVALID_HANDLE) {
+					close();
+					return false;
+				}
+				printError("error 0x%x in Socket:send:send(): %s");
+				return false;
+			}
+			buffer += result;
+			length -= result;
+		}
+
 		return true;
 	}
 
@@ -465,12 +1030,15 @@ public:
 			return false;
 		}
 
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
 		int result = ::recv(this->handle, buffer, length, 0);
 		if (result == 0) {
 			return false; // connection closed
 		} else if (result == SOCKET_ERROR) {
-			if (WSAGetLastError() == WSAETIMEDOUT)
-				return true; // timed out
+			if (WSAGetLastError() == WSAETIMEDOUT || WSAGetLastError() == WSAEWOULDBLOCK)
+				return true; // timed out or nothing to read in non blocking mode
 			else if (WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAECONNABORTED)
 				return false; // connection closed
 			if (GetLastError() == ERROR_INVALID_HANDLE) {
@@ -495,13 +1063,19 @@ public:
 			return false;
 		}
 
-		int senderAdressLen = sizeof(SOCKADDR_IN6);
-		int result = ::recvfrom(this->handle, buffer, length, 0, &((addr_t*) address.addr)->sockaddrU, &senderAdressLen);
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		int result;
+		do {
+			int senderAdressLen = sizeof(SOCKADDR_IN6);
+			result = ::recvfrom(this->handle, buffer, length, 0, &((addr_t*) address.addr)->sockaddrU, &senderAdressLen);
+		} while (result != SOCKET_ERROR && isDenied((addr_t*) address.addr));
 		if (result == 0) {
 			return false; // connection closed
 		} else if (result == SOCKET_ERROR) {
-			if (WSAGetLastError() == WSAETIMEDOUT)
-				return true; // timed out
+			if (WSAGetLastError() == WSAETIMEDOUT || WSAGetLastError() == WSAEWOULDBLOCK)
+				return true; // timed out or nothing to read in non blocking mode
 			else if (WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAECONNABORTED)
 				return false; // connection closed
 			if (GetLastError() == ERROR_INVALID_HANDLE) {
@@ -527,6 +1101,9 @@ public:
 			return false;
 		}
 
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
 		if (((addr_t*) address.addr)->sockaddrU.sa_family != this->addrType) {
 			printf("tried to call sendto() with invalid address type for this socket!\n");
 			return false;
@@ -549,10 +1126,482 @@ public:
 		return true;
 	}
 
+	bool receivefromBatch(NetSocket::Datagram* datagrams, unsigned int count, unsigned int* receivedCount) override {
+		// there is no batch receive in winsock, just receive one datagram
+		*receivedCount = 0;
+		if (count == 0) return true;
+		if (!receivefrom(datagrams[0].address, datagrams[0].buffer, datagrams[0].length, &datagrams[0].received))
+			return false;
+		*receivedCount = 1;
+		return true;
+	}
+
+	bool sendtoBatch(const NetSocket::Datagram* datagrams, unsigned int count, unsigned int* sentCount) override {
+		// there is no batch send in winsock, send the datagrams one by one
+		*sentCount = 0;
+		if (count > UDP_BATCH_SIZE) count = UDP_BATCH_SIZE;
+		for (unsigned int i = 0; i < count; i++) {
+			if (!sendto(datagrams[i].address, datagrams[i].buffer, datagrams[i].length))
+				return *sentCount > 0;
+			(*sentCount)++;
+		}
+		return true;
+	}
+
+	bool setCongestionControl(const char* algorithm) override {
+		printf("tried to call setCongestionControl(), not supported on this platform!\n");
+		return false;
+	}
+
+	bool getCongestionControl(std::string& algorithm) override {
+		printf("tried to call getCongestionControl(), not supported on this platform!\n");
+		return false;
+	}
+
+	bool getStats(NetSocket::ConnectionStats* stats) override {
+		if (this->stype != NetSocket::STREAM) {
+			printf("tried to call getStats() on non STREAM socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		if (!readStats(this->handle, stats)) {
+			if (GetLastError() == ERROR_INVALID_HANDLE) {
+				close();
+				return false;
+			}
+			printError("error 0x%x in Socket:getStats:WSAIoctl(SIO_TCP_INFO): %s");
+			return false;
+		}
+
+		return true;
+	}
+
+	/*
+	 * Joins or leaves an multicast group using the protocol independent group requests of RFC 3678
+	 */
+	bool changeGroup(const NetSocket::INetAddress& groupAddress, const NetSocket::INetAddress* sourceAddress, unsigned int interfaceIndex, bool join) {
+		if (this->stype != NetSocket::LISTEN_UDP) {
+			printf("tried to call joinGroup()/leaveGroup() on non LISTEN_UDP socket!\n");
+			return false;
+		}
+
+		HandleUse use(this);
+		if (!use) return false; // closed by another thread
+
+		const addr_t* group = (addr_t*) groupAddress.addr;
+		if (group->sockaddrU.sa_family != this->addrType || (sourceAddress != 0 && ((addr_t*) sourceAddress->addr)->sockaddrU.sa_family != this->addrType)) {
+			printf("tried to call joinGroup()/leaveGroup() with invalid address type for this socket!\n");
+			return false;
+		}
+
+		int level = this->addrType == AF_INET6 ? IPPROTO_IPV6 : IPPROTO_IP;
+		int addrLen = this->addrType == AF_INET6 ? sizeof(SOCKADDR_IN6) : sizeof(SOCKADDR_IN);
+		int result;
+		if (sourceAddress == 0) {
+			GROUP_REQ request;
+			memset(&request, 0, sizeof(GROUP_REQ));
+			request.gr_interface = interfaceIndex;
+			memcpy(&request.gr_group, group, addrLen);
+			result = ::setsockopt(this->handle, level, join ? MCAST_JOIN_GROUP : MCAST_LEAVE_GROUP, (const char*) &request, sizeof(GROUP_REQ));
+		} else {
+			GROUP_SOURCE_REQ request;
+			memset(&request, 0, sizeof(GROUP_SOURCE_REQ));
+			request.gsr_interface = interfaceIndex;
+			memcpy(&request.gsr_group, group, addrLen);
+			memcpy(&request.gsr_source, sourceAddress->addr, addrLen);
+			result = ::setsockopt(this->handle, level, join ? MCAST_JOIN_SOURCE_GROUP : MCAST_LEAVE_SOURCE_GROUP, (const char*) &request, sizeof(GROUP_SOURCE_REQ));
+		}
+
+		if (result == SOCKET_ERROR) {
+			if (GetLastError() == ERROR_INVALID_HANDLE) {
+				close();
+				return false;
+			}
+			printError(join ? "error 0x%x in Socket:joinGroup:setsockopt(MCAST_JOIN_GROUP): %s" : "error 0x%x in Socket:leaveGroup:setsockopt(MCAST_LEAVE_GROUP): %s");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool joinGroup(const NetSocket::INetAddress& groupAddress, const NetSocket::INetAddress* sourceAddress, unsigned int interfaceIndex) override {
+		return changeGroup(groupAddress, sourceAddress, interfaceIndex, true);
+	}
+
+	bool leaveGroup(const NetSocket::INetAddress& groupAddress, const NetSocket::INetAddress* sourceAddress, unsigned int interfaceIndex) override {
+		return changeGroup(groupAddress, sourceAddress, interfaceIndex, false);
+	}
+
+	bool sendSocket(NetSocket::Socket& socket, const char* buffer, unsigned int length) override {
+		printf("tried to call sendSocket(), not supported on this platform!\n");
+		return false;
+	}
+
+	bool receiveSocket(NetSocket::Socket& socket, char* buffer, unsigned int length, unsigned int* received) override {
+		printf("tried to call receiveSocket(), not supported on this platform!\n");
+		return false;
+	}
+
+	bool enableTimestamps(bool receive, bool transmit) override {
+		printf("tried to call enableTimestamps(), not supported on this platform!\n");
+		return false;
+	}
+
+	bool receiveTimestamped(char* buffer, unsigned int length, unsigned int* received, NetSocket::Timestamp* timestamp) override {
+		printf("tried to call receiveTimestamped(), not supported on this platform!\n");
+		return false;
+	}
+
+	bool receivefromTimestamped(NetSocket::INetAddress& address, char* buffer, unsigned int length, unsigned int* received, NetSocket::Timestamp* timestamp) override {
+		printf("tried to call receivefromTimestamped(), not supported on this platform!\n");
+		return false;
+	}
+
+	bool receiveTransmitTimestamp(unsigned int* id, NetSocket::Timestamp* timestamp, bool* available) override {
+		printf("tried to call receiveTransmitTimestamp(), not supported on this platform!\n");
+		return false;
+	}
+
+	bool getPeerCredentials(int* pid, int* uid, int* gid) override {
+		printf("tried to call getPeerCredentials(), not supported on this platform!\n");
+		return false;
+	}
+
 };
 
+void NetSocket::Socket::sampleStats(Socket** sockets, ConnectionStats* stats, unsigned int count, unsigned int* sampledCount) {
+	*sampledCount = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		SocketWin* socket = dynamic_cast<SocketWin*>(sockets[i]);
+		if (socket == 0 || socket->stype != STREAM) {
+			memset(stats + i, 0, sizeof(ConnectionStats));
+			continue;
+		}
+		SocketWin::HandleUse use(socket);
+		if (!use || !readStats(socket->handle, stats + i)) {
+			memset(stats + i, 0, sizeof(ConnectionStats));
+			continue;
+		}
+		(*sampledCount)++;
+	}
+}
+
+bool NetSocket::Socket::pollMany(Socket** sockets, const int* events, int* readyEvents, unsigned int count, int timeout, unsigned int* readyCount) {
+	*readyCount = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		if (dynamic_cast<SocketWin*>(sockets[i]) == 0) {
+			printf("tried to call pollMany() with socket not backed by an handle!\n");
+			return false;
+		}
+	}
+
+	// the handles are referenced while polling, so they can not be reused if an socket is closed by another thread
+	std::vector<WSAPOLLFD> fds(count);
+	std::vector<char> acquired(count);
+	for (unsigned int i = 0; i < count; i++) {
+		readyEvents[i] = 0;
+		SocketWin* socket = (SocketWin*) sockets[i];
+		acquired[i] = socket->acquireHandle();
+		fds[i].fd = acquired[i] ? (SOCKET) socket->handle : INVALID_SOCKET; // invalid handles are ignored by WSAPoll
+		fds[i].events = (events[i] & EVENT_READ ? POLLRDNORM : 0) | (events[i] & EVENT_WRITE ? POLLWRNORM : 0);
+		fds[i].revents = 0;
+	}
+
+	int result = ::WSAPoll(fds.data(), count, timeout);
+	for (unsigned int i = 0; i < count; i++)
+		if (acquired[i]) ((SocketWin*) sockets[i])->releaseHandle();
+	if (result == SOCKET_ERROR) {
+		printError("error 0x%x in Socket:pollMany:WSAPoll(): %s");
+		return false;
+	}
+
+	for (unsigned int i = 0; i < count; i++) {
+		short revents = fds[i].revents;
+		if (revents & POLLRDNORM) readyEvents[i] |= EVENT_READ;
+		if (revents & POLLWRNORM) readyEvents[i] |= EVENT_WRITE;
+		if (revents & (POLLERR | POLLNVAL)) readyEvents[i] |= EVENT_ERROR;
+		if (revents & POLLHUP) readyEvents[i] |= EVENT_CLOSED;
+		if (readyEvents[i] != 0) (*readyCount)++;
+	}
+	return true;
+}
+
 NetSocket::Socket* NetSocket::newSocket() {
 	return new SocketWin();
 }
 
+bool NetSocket::NativeSocket::attach(Socket& socket) {
+	// derived sockets (TLS) do not transfer their data directly trough the handle
+	if (typeid(socket) != typeid(SocketWin)) {
+		printf("tried to call NativeSocket:attach() with non platform socket!\n");
+		return false;
+	}
+	SocketWin& platformSocket = (SocketWin&) socket;
+	this->target = &socket;
+	this->handle = &platformSocket.handle;
+	this->stype = &platformSocket.stype;
+	this->family = &platformSocket.addrType;
+	this->filter = &platformSocket.filter;
+	return true;
+}
+
+bool NetSocket::SocketHandle::accept(Socket& listenSocket) {
+	if (isOpen()) {
+		printf("tried to call SocketHandle:accept() on open handle!\n");
+		return false;
+	}
+	if (typeid(listenSocket) != typeid(SocketWin)) {
+		printf("tried to call SocketHandle:accept() with non platform socket!\n");
+		return false;
+	}
+	SocketWin socket;
+	return listenSocket.accept(socket) && adopt(socket);
+}
+
+bool NetSocket::SocketHandle::connect(const INetAddress& address, unsigned long timeout) {
+	if (isOpen()) {
+		printf("tried to call SocketHandle:connect() on open handle!\n");
+		return false;
+	}
+	SocketWin socket;
+	return socket.connect(address, timeout) && adopt(socket);
+}
+
+bool NetSocket::SocketHandle::adopt(Socket& socket) {
+	if (isOpen()) {
+		printf("tried to call SocketHandle:adopt() on open handle!\n");
+		return false;
+	}
+	if (typeid(socket) != typeid(SocketWin) || ((SocketWin&) socket).stype != STREAM) {
+		printf("tried to call SocketHandle:adopt() with non STREAM platform socket!\n");
+		return false;
+	}
+	SocketWin& platformSocket = (SocketWin&) socket;
+	unsigned int users = 0;
+	if (!platformSocket.users.compare_exchange_strong(users, HANDLE_CLOSING)) {
+		printf("tried to call SocketHandle:adopt() with socket in use by another thread!\n");
+		return false;
+	}
+	this->handle = platformSocket.handle;
+	this->flags = platformSocket.blocking ? 0 : FLAG_NON_BLOCKING;
+	platformSocket.handle = INVALID_SOCKET;
+	platformSocket.remoteLength = 0;
+	platformSocket.stype = UNBOUND;
+	return true;
+}
+
+bool NetSocket::SocketHandle::release(Socket& socket) {
+	if (!isOpen()) {
+		printf("tried to call SocketHandle:release() on closed handle!\n");
+		return false;
+	}
+	if (typeid(socket) != typeid(SocketWin) || ((SocketWin&) socket).stype != UNBOUND) {
+		printf("tried to call SocketHandle:release() with non UNBOUND platform socket!\n");
+		return false;
+	}
+	SocketWin& platformSocket = (SocketWin&) socket;
+	addr_t local;
+	int localLength = sizeof(addr_t);
+	if (::getsockname(this->handle, &local.sockaddrU, &localLength) == SOCKET_ERROR) {
+		printError("error 0x%x in SocketHandle:release:getsockname(): %s");
+		return false;
+	}
+	platformSocket.addrType = local.sockaddrU.sa_family;
+	platformSocket.blocking = isBlocking();
+	platformSocket.remoteLength = 0;
+	platformSocket.handle = this->handle;
+	platformSocket.setOpen(STREAM);
+	this->handle = INVALID_SOCKET;
+	this->flags = 0;
+	return true;
+}
+
+void NetSocket::SocketHandle::close() {
+	if (!isOpen()) return;
+	::closesocket(this->handle);
+	this->handle = INVALID_SOCKET;
+	this->flags = 0;
+}
+
+bool NetSocket::SocketHandle::setBlocking(bool blocking) {
+	if (!isOpen()) {
+		printf("tried to call SocketHandle:setBlocking() on closed handle!\n");
+		return false;
+	}
+	if (!SocketWin::applyBlocking(this->handle, blocking))
+		return false;
+	this->flags = blocking ? this->flags & ~FLAG_NON_BLOCKING : this->flags | FLAG_NON_BLOCKING;
+	return true;
+}
+
+/*
+ * Waits until the handle is ready for the event, returns false on timeout or error
+ */
+static bool waitHandle(SOCKET handle, short event, int timeout) {
+	WSAPOLLFD fd = {
+		.fd = handle,
+		.events = event,
+		.revents = 0
+	};
+	int result = ::WSAPoll(&fd, 1, timeout);
+	if (result == SOCKET_ERROR) {
+		printError("error 0x%x in SocketHandle:waitHandle:WSAPoll(): %s");
+		return false;
+	}
+	return result > 0;
+}
+
+bool NetSocket::SocketHandle::send(const char* buffer, unsigned int length) {
+	if (!isOpen()) {
+		printf("tried to call SocketHandle:send() on closed handle!\n");
+		return false;
+	}
+
+	while (length > 0) {
+		int result = ::send(this->handle, buffer, length, 0);
+		if (result == SOCKET_ERROR) {
+			if (WSAGetLastError() == WSAEWOULDBLOCK && !isBlocking()) {
+				// send() always transmits the whole buffer, only trySend() returns early in non blocking mode
+				if (!waitHandle(this->handle, POLLWRNORM, -1))
+					return false;
+				continue;
+			}
+			if (WSAGetLastError() == WSAETIMEDOUT)
+				return true; // timed out
+			else if (WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAECONNABORTED)
+				return false; // connection closed
+			if (GetLastError() == ERROR_INVALID_HANDLE) {
+				close();
+				return false;
+			}
+			printError("error 0x%x in SocketHandle:send:send(): %s");
+			return false;
+		}
+		buffer += result;
+		length -= result;
+	}
+
+	return true;
+}
+
+bool NetSocket::SocketHandle::receive(char* buffer, unsigned int length, unsigned int* received) {
+	if (!isOpen()) {
+		printf("tried to call SocketHandle:receive() on closed handle!\n");
+		return false;
+	}
+
+	*received = 0;
+	int result = ::recv(this->handle, buffer, length, 0);
+	if (result == 0) {
+		return false; // connection closed
+	} else if (result == SOCKET_ERROR) {
+		if (WSAGetLastError() == WSAETIMEDOUT || WSAGetLastError() == WSAEWOULDBLOCK)
+			return true; // timed out or nothing to read in non blocking mode
+		else if (WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAECONNABORTED)
+			return false; // connection closed
+		if (GetLastError() == ERROR_INVALID_HANDLE) {
+			close();
+			return false;
+		}
+		printError("error 0x%x in SocketHandle:receive:recv(): %s");
+		return false;
+	}
+
+	*received = result;
+	return true;
+}
+
+bool NetSocket::SocketHandle::trySend(const char* buffer, unsigned int length, unsigned int* sent, bool* wouldBlock) {
+	if (!isOpen()) {
+		printf("tried to call SocketHandle:trySend() on closed handle!\n");
+		return false;
+	}
+
+	// winsock has no per call non blocking flag, so check for space first if the handle is blocking
+	*sent = 0;
+	*wouldBlock = true;
+	if (isBlocking() && !waitHandle(this->handle, POLLWRNORM, 0))
+		return true;
+
+	int result = ::send(this->handle, buffer, length, 0);
+	if (result == SOCKET_ERROR) {
+		if (WSAGetLastError() == WSAEWOULDBLOCK)
+			return true;
+		else if (WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAECONNABORTED)
+			return false; // connection closed
+		if (GetLastError() == ERROR_INVALID_HANDLE) {
+			close();
+			return false;
+		}
+		printError("error 0x%x in SocketHandle:trySend:send(): %s");
+		return false;
+	}
+
+	*sent = result;
+	*wouldBlock = (unsigned int) result < length;
+	return true;
+}
+
+bool NetSocket::SocketHandle::tryReceive(char* buffer, unsigned int length, unsigned int* received, bool* wouldBlock) {
+	if (!isOpen()) {
+		printf("tried to call SocketHandle:tryReceive() on closed handle!\n");
+		return false;
+	}
+
+	*received = 0;
+	*wouldBlock = true;
+	if (isBlocking() && !waitHandle(this->handle, POLLRDNORM, 0))
+		return true;
+
+	int result = ::recv(this->handle, buffer, length, 0);
+	if (result == 0) {
+		return false; // connection closed
+	} else if (result == SOCKET_ERROR) {
+		if (WSAGetLastError() == WSAEWOULDBLOCK)
+			return true;
+		else if (WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAECONNABORTED)
+			return false; // connection closed
+		if (GetLastError() == ERROR_INVALID_HANDLE) {
+			close();
+			return false;
+		}
+		printError("error 0x%x in SocketHandle:tryReceive:recv(): %s");
+		return false;
+	}
+
+	*wouldBlock = false;
+	*received = result;
+	return true;
+}
+
+NetSocket::SocketProfile NetSocket::SocketProfile::lowLatency() {
+	return SocketProfile()
+			.set(OPT_NO_DELAY, 1)
+			.set(OPT_QUICK_ACK, 1)
+			.set(OPT_CORK, 0)
+			.set(OPT_NOTSENT_LOWAT, 16384)
+			.set(OPT_PRIORITY, 6);
+}
+
+NetSocket::SocketProfile NetSocket::SocketProfile::bulkThroughput() {
+	return SocketProfile()
+			.set(OPT_NO_DELAY, 0)
+			.set(OPT_RECEIVE_BUFFER, 4 << 20)
+			.set(OPT_SEND_BUFFER, 4 << 20)
+			.set(OPT_PRIORITY, 0);
+}
+
+bool NetSocket::handoverListener(Socket& channel, Socket& listenSocket, unsigned long timeout) {
+	printf("tried to call handoverListener(), not supported on this platform!\n");
+	return false;
+}
+
+bool NetSocket::takeoverListener(Socket& channel, Socket& listenSocket) {
+	printf("tried to call takeoverListener(), not supported on this platform!\n");
+	return false;
+}
+
 #endif
@@ -0,0 +1,152 @@
+/*
+ * DatagramBatch.java
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+package de.m_marvin.netsocket;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * An array of datagrams in direct memory, transferred by Socket.receivefromBatch() and Socket.sendtoBatch() with one JNI call.
+ * The payloads live in fixed size slots of one direct buffer, the lengths and addresses in an second direct buffer which the native
+ * library reads and writes in place, so neither the payload nor the addresses are copied across the JNI boundary.
+ * Receiving overwrites the content of the batch, datagram i is then stored in slot slot(i), which is not necessarily slot i.
+ * This class is not thread safe.
+ */
+public final class DatagramBatch {
+
+	/*
+	 * Layout of one metadata entry, has to match JNI_ENTRY_* in jninet.cpp
+	 */
+	static final int ENTRY_SIZE = 32;
+	static final int ENTRY_LENGTH = 0;
+	static final int ENTRY_PORT = 4;
+	static final int ENTRY_ADDRESS_LENGTH = 8;
+	static final int ENTRY_SLOT = 12;
+	static final int ENTRY_ADDRESS = 16;
+
+	final ByteBuffer payload;
+	final ByteBuffer metadata;
+	final int slotSize;
+	int count;
+
+	/**
+	 * Allocates a new batch.
+	 * @param capacity The number of datagrams, at most 64 are received per call
+	 * @param slotSize The maximum size of an datagram, larger datagrams are truncated on receive
+	 */
+	public DatagramBatch(int capacity, int slotSize) {
+		if (capacity <= 0 || slotSize <= 0 || (long) capacity * slotSize > Integer.MAX_VALUE)
+			throw new IllegalArgumentException("invalid batch size");
+		this.payload = ByteBuffer.allocateDirect(capacity * slotSize);
+		this.metadata = ByteBuffer.allocateDirect(capacity * ENTRY_SIZE).order(ByteOrder.nativeOrder());
+		this.slotSize = slotSize;
+		this.count = 0;
+	}
+
+	/**
+	 * Returns the number of datagrams the batch can hold.
+	 * @return The capacity of the batch
+	 */
+	public int capacity() {
+		return this.metadata.capacity() / ENTRY_SIZE;
+	}
+
+	/**
+	 * Returns the maximum size of an datagram.
+	 * @return The size of one slot in bytes
+	 */
+	public int slotSize() {
+		return this.slotSize;
+	}
+
+	/**
+	 * Returns the number of datagrams in the batch, set by the last receive or by setCount().
+	 * @return The number of datagrams
+	 */
+	public int count() {
+		return this.count;
+	}
+
+	/**
+	 * Sets the number of datagrams to send, starting with index zero.
+	 * @param count The number of datagrams
+	 */
+	public void setCount(int count) {
+		if (count < 0 || count > capacity())
+			throw new IndexOutOfBoundsException("count exceeds capacity");
+		this.count = count;
+	}
+
+	/**
+	 * Returns the slot holding the payload of an datagram.
+	 * @param index The index of the datagram
+	 * @return The slot index
+	 */
+	public int slot(int index) {
+		return this.metadata.getInt(index * ENTRY_SIZE + ENTRY_SLOT);
+	}
+
+	/**
+	 * Returns an view of the payload of an received datagram, or of the slot of an datagram to send.
+	 * The view shares the memory of the batch and is overwritten by the next receive.
+	 * @param index The index of the datagram
+	 * @return An buffer with the position at the start and the limit at the end of the payload
+	 */
+	public ByteBuffer payload(int index) {
+		return this.payload.slice(slot(index) * this.slotSize, length(index));
+	}
+
+	/**
+	 * Returns the payload length of an datagram.
+	 * @param index The index of the datagram
+	 * @return The number of bytes received or to send
+	 */
+	public int length(int index) {
+		return this.metadata.getInt(index * ENTRY_SIZE + ENTRY_LENGTH);
+	}
+
+	/**
+	 * Copies the address of an datagram into the supplied address object, without allocating.
+	 * @param index The index of the datagram
+	 * @param address The address to overwrite with the sender (receive) or target (send) address
+	 */
+	public void address(int index, INetAddress address) {
+		int entry = index * ENTRY_SIZE;
+		address.length = this.metadata.getInt(entry + ENTRY_ADDRESS_LENGTH);
+		address.port = this.metadata.getInt(entry + ENTRY_PORT);
+		this.metadata.get(entry + ENTRY_ADDRESS, address.address, 0, address.length);
+	}
+
+	/**
+	 * Sets the target address and length of an datagram to send, the payload has to be written to the buffer returned by slotBuffer().
+	 * @param index The index of the datagram
+	 * @param address The target address
+	 * @param length The payload length, at most slotSize()
+	 */
+	public void set(int index, INetAddress address, int length) {
+		if (length < 0 || length > this.slotSize)
+			throw new IllegalArgumentException("datagram length exceeds slot size");
+		int entry = index * ENTRY_SIZE;
+		this.metadata.putInt(entry + ENTRY_LENGTH, length);
+		this.metadata.putInt(entry + ENTRY_PORT, address.port);
+		this.metadata.putInt(entry + ENTRY_ADDRESS_LENGTH, address.length);
+		this.metadata.putInt(entry + ENTRY_SLOT, index);
+		this.metadata.put(entry + ENTRY_ADDRESS, address.address, 0, address.length);
+	}
+
+	/**
+	 * Returns an view of the whole slot of an datagram to send, to write its payload before calling set().
+	 * Datagrams to send are always stored in the slot with the same index.
+	 * @param index The index of the datagram
+	 * @return An buffer with the position at the start and the limit at the end of the slot
+	 */
+	public ByteBuffer slotBuffer(int index) {
+		return this.payload.slice(index * this.slotSize, this.slotSize);
+	}
+
+}
@@ -0,0 +1,128 @@
+/*
+ * INetAddress.java
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+package de.m_marvin.netsocket;
+
+import java.util.Arrays;
+
+/**
+ * An IPv4 or IPv6 address with port, the java side of NetSocket::INetAddress.
+ * The object is mutable, Socket.receivefrom() and Socket.getINet() overwrite it, so an receive loop can reuse one instance without allocating.
+ * The fields are accessed by the native library and must not be renamed.
+ */
+public final class INetAddress {
+
+	final byte[] address = new byte[16];
+	int length;	// 4 for IPv4, 16 for IPv6, 0 if not set
+	int port;
+
+	static {
+		NetSocket.load();
+	}
+
+	/**
+	 * Creates an address which is not set yet, to be filled by an receive call.
+	 */
+	public INetAddress() {}
+
+	/**
+	 * Creates an address from its raw bytes.
+	 * @param bytes The address in network byte order, 4 bytes for IPv4 or 16 bytes for IPv6
+	 * @param port The port number
+	 */
+	public INetAddress(byte[] bytes, int port) {
+		set(bytes, port);
+	}
+
+	/**
+	 * Parses an numeric IPv4 or IPv6 address without name resolution, use NetSocket.resolveInet() for host names.
+	 * @param text The address text, for example "127.0.0.1" or "::1"
+	 * @param port The port number
+	 * @return The address, or null if the text is not an numeric address
+	 */
+	public static INetAddress parse(String text, int port) {
+		INetAddress address = new INetAddress();
+		return parse0(address, text, port) ? address : null;
+	}
+
+	/**
+	 * Sets the address from its raw bytes.
+	 * @param bytes The address in network byte order, 4 bytes for IPv4 or 16 bytes for IPv6
+	 * @param port The port number
+	 */
+	public void set(byte[] bytes, int port) {
+		if (bytes.length != 4 && bytes.length != 16)
+			throw new IllegalArgumentException("address has to be 4 or 16 bytes long");
+		System.arraycopy(bytes, 0, this.address, 0, bytes.length);
+		this.length = bytes.length;
+		this.port = port;
+	}
+
+	/**
+	 * Copies another address into this one.
+	 * @param other The address to copy
+	 */
+	public void set(INetAddress other) {
+		System.arraycopy(other.address, 0, this.address, 0, 16);
+		this.length = other.length;
+		this.port = other.port;
+	}
+
+	/**
+	 * Returns if the address was set.
+	 * @return true if the address holds an IPv4 or IPv6 address
+	 */
+	public boolean isSet() {
+		return this.length != 0;
+	}
+
+	/**
+	 * Returns the raw address bytes.
+	 * @return An copy of the address in network byte order, 4 bytes for IPv4 or 16 bytes for IPv6
+	 */
+	public byte[] getBytes() {
+		return Arrays.copyOf(this.address, this.length);
+	}
+
+	/**
+	 * Returns the port number.
+	 * @return The port number
+	 */
+	public int getPort() {
+		return this.port;
+	}
+
+	@Override
+	public boolean equals(Object obj) {
+		if (!(obj instanceof INetAddress)) return false;
+		INetAddress other = (INetAddress) obj;
+		return this.length == other.length && this.port == other.port && Arrays.equals(this.address, 0, this.length, other.address, 0, other.length);
+	}
+
+	@Override
+	public int hashCode() {
+		int hash = this.port;
+		for (int i = 0; i < this.length; i++)
+			hash = hash * 31 + this.address[i];
+		return hash;
+	}
+
+	/**
+	 * Returns the address as formatted by NetSocket::INetAddress::tostr(), followed by the port.
+	 * @return The address text, for example "127.0.0.1:80" or "[::1]:80", or an placeholder if the address is not set
+	 */
+	@Override
+	public String toString() {
+		if (this.length == 0) return "<unset>";
+		String text = format0(this);
+		return this.length == 16 ? "[" + text + "]:" + this.port : text + ":" + this.port;
+	}
+
+	private static native boolean parse0(INetAddress address, String text, int port);
+	private static native String format0(INetAddress address);
+
+}
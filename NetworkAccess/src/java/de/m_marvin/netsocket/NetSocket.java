@@ -0,0 +1,83 @@
+/*
+ * NetSocket.java
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+package de.m_marvin.netsocket;
+
+import java.nio.file.Path;
+
+/**
+ * Loads the native library and provides the functions of the NetSocket namespace which do not belong to an socket.
+ * The library has to be built with jniSupport enabled, it registers the native methods of all classes in this package when it is loaded.
+ * The other classes call load() when they are first used, load(Path) has to be called before that to load the library from an explicit file.
+ */
+public final class NetSocket {
+
+	private static boolean loaded = false;
+	private static boolean loading = false;	// JNI_OnLoad initializes the other classes of this package, which call load() again
+
+	private NetSocket() {}
+
+	/**
+	 * Loads the library for the current platform from the java library path, does nothing if it was already loaded.
+	 * The names match the published artifacts: libnetsocket_x64.dll, libnetsocket_x64.so, libnetsocket_arm64.so and libnetsocket_arm32.so.
+	 * @throws UnsatisfiedLinkError if there is no library for the platform or it could not be loaded
+	 */
+	public static synchronized void load() {
+		if (loaded || loading) return;
+		String arch = System.getProperty("os.arch");
+		String suffix;
+		if (arch.equals("amd64") || arch.equals("x86_64")) {
+			suffix = "x64";
+		} else if (arch.equals("aarch64") || arch.equals("arm64")) {
+			suffix = "arm64";
+		} else if (arch.startsWith("arm")) {
+			suffix = "arm32";
+		} else {
+			throw new UnsatisfiedLinkError("no netsocket library for architecture " + arch);
+		}
+		// System.loadLibrary() adds the lib prefix only on unix systems
+		boolean windows = System.getProperty("os.name").toLowerCase().startsWith("windows");
+		loading = true;
+		try {
+			System.loadLibrary(windows ? "libnetsocket_" + suffix : "netsocket_" + suffix);
+			loaded = true;
+		} finally {
+			loading = false;
+		}
+	}
+
+	/**
+	 * Loads the library from an explicit file, for example after extracting it from the maven artifact, does nothing if it was already loaded.
+	 * @param library The path of the library file
+	 * @throws UnsatisfiedLinkError if the library could not be loaded
+	 */
+	public static synchronized void load(Path library) {
+		if (loaded || loading) return;
+		loading = true;
+		try {
+			System.load(library.toAbsolutePath().toString());
+			loaded = true;
+		} finally {
+			loading = false;
+		}
+	}
+
+	/**
+	 * Resolves the supplied host string into a list of network addresses.
+	 * Unix socket addresses are not supported on the java side and skipped.
+	 * @param host The host URL string
+	 * @param port The host port string
+	 * @param lookForUDP If the resolution should happen for TCP or UDP sockets
+	 * @return The resolved addresses, or null if the resolution failed
+	 */
+	public static INetAddress[] resolveInet(String host, String port, boolean lookForUDP) {
+		return resolveInet0(host, port, lookForUDP);
+	}
+
+	private static native INetAddress[] resolveInet0(String host, String port, boolean lookForUDP);
+
+}
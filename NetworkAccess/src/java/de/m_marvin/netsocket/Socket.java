@@ -0,0 +1,293 @@
+/*
+ * Socket.java
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+package de.m_marvin.netsocket;
+
+import java.nio.ByteBuffer;
+
+/**
+ * An platform socket (NetSocket::newSocket()) accessed trough JNI.
+ * All data is read from and written to direct ByteBuffers, the native library passes their memory to the system calls without copying.
+ * The data is taken from (send) or written to (receive) the range between position and limit of the buffer, and the position is advanced
+ * by the number of bytes transferred, the same way as the java.nio channels do.
+ * For UDP traffic receivefromBatch() and sendtoBatch() transfer up to 64 datagrams per JNI call (and system call where supported),
+ * which amortizes the cost of the JNI transition.
+ * The threading rules of the native socket apply: one thread may send while another receives, and any thread may call close().
+ * free() releases the native object and must only be called after all other calls on this socket returned.
+ */
+public class Socket {
+
+	private long pointer;
+
+	static {
+		NetSocket.load();
+	}
+
+	/**
+	 * Creates a new unbound socket.
+	 */
+	public Socket() {
+		this.pointer = newSocket0();
+	}
+
+	/**
+	 * Returns the native socket.
+	 * @throws IllegalStateException if the socket was freed
+	 */
+	private long pointer() {
+		if (this.pointer == 0)
+			throw new IllegalStateException("socket was already freed");
+		return this.pointer;
+	}
+
+	/**
+	 * Checks that the buffer can be passed to the native library.
+	 * @throws IllegalArgumentException if the buffer is not direct
+	 */
+	private static ByteBuffer direct(ByteBuffer buffer) {
+		if (!buffer.isDirect())
+			throw new IllegalArgumentException("buffer has to be an direct ByteBuffer");
+		return buffer;
+	}
+
+	/**
+	 * Closes the socket if it is open and releases the native object, the socket can not be used afterwards.
+	 * Calling this function while another thread still uses the socket leads to undefined behavior.
+	 */
+	public void free() {
+		if (this.pointer == 0) return;
+		free0(this.pointer);
+		this.pointer = 0;
+	}
+
+	/**
+	 * Closes the socket, blocked calls in other threads return with an failure. The socket can be opened again.
+	 */
+	public void close() {
+		close0(pointer());
+	}
+
+	/**
+	 * Returns true if the socket is open.
+	 * @return true if the socket is open
+	 */
+	public boolean isOpen() {
+		return isOpen0(pointer());
+	}
+
+	/**
+	 * Returns the type of the socket.
+	 * @return The socket type
+	 */
+	public SocketType type() {
+		return SocketType.values()[type0(pointer())];
+	}
+
+	/**
+	 * Puts the socket in blocking (default) or non blocking mode, may be called before the socket is opened.
+	 * @param blocking true for blocking mode, false for non blocking mode
+	 * @return true if the mode was set successfully, false otherwise
+	 */
+	public boolean setBlocking(boolean blocking) {
+		return setBlocking0(pointer(), blocking);
+	}
+
+	/**
+	 * Enables or disables the nagle buffering algorithm for this TCP socket.
+	 * @param enableBuffering true for enabling buffering, false for disabling
+	 * @return true if the new state was set successfully, false otherwise
+	 */
+	public boolean setNagle(boolean enableBuffering) {
+		return setNagle0(pointer(), enableBuffering);
+	}
+
+	/**
+	 * Reads the inet address this socket is connected to.
+	 * @param address The address to overwrite
+	 * @return true if the address was read successfully, false otherwise
+	 */
+	public boolean getINet(INetAddress address) {
+		return getINet0(pointer(), address);
+	}
+
+	/**
+	 * Opens a new TCP port for the supplied address.
+	 * @param localAddress The local address to listen on
+	 * @return true if the port was opened successfully, false otherwise
+	 */
+	public boolean listen(INetAddress localAddress) {
+		return listen0(pointer(), localAddress);
+	}
+
+	/**
+	 * Accepts an incoming connection on a TCP listen socket.
+	 * @param clientSocket An unbound socket which is opened for the connection
+	 * @return true if an connection was accepted, false otherwise
+	 */
+	public boolean accept(Socket clientSocket) {
+		return accept0(pointer(), clientSocket.pointer());
+	}
+
+	/**
+	 * Attempts to connect to the supplied TCP address.
+	 * @param remoteAddress The address to connect to
+	 * @param timeout The time in milliseconds to wait for the connection, zero to wait indefinitely
+	 * @return true if the connection was established, false otherwise
+	 */
+	public boolean connect(INetAddress remoteAddress, long timeout) {
+		return connect0(pointer(), remoteAddress, timeout);
+	}
+
+	/**
+	 * Opens a new UDP port for the supplied address.
+	 * @param localAddress The local address to bind to
+	 * @return true if the port was opened successfully, false otherwise
+	 */
+	public boolean bind(INetAddress localAddress) {
+		return bind0(pointer(), localAddress);
+	}
+
+	/**
+	 * Sends all remaining data of the buffer trough the TCP connection.
+	 * @param buffer The direct buffer holding the data, its position is set to the limit if the data was sent
+	 * @return true if the data was sent successfully, false otherwise
+	 */
+	public boolean send(ByteBuffer buffer) {
+		int position = direct(buffer).position();
+		if (!send0(pointer(), buffer, position, buffer.limit() - position)) return false;
+		buffer.position(buffer.limit());
+		return true;
+	}
+
+	/**
+	 * Receives data trough the TCP connection, might block indefinitely until data is received.
+	 * @param buffer The direct buffer to write the data to, up to its limit
+	 * @return The number of bytes received, which might be zero, or -1 if an error occurred or the connection was closed
+	 */
+	public int receive(ByteBuffer buffer) {
+		int position = direct(buffer).position();
+		int received = receive0(pointer(), buffer, position, buffer.limit() - position);
+		if (received > 0) buffer.position(position + received);
+		return received;
+	}
+
+	/**
+	 * Sends data trough the TCP connection without blocking, independent of the blocking mode.
+	 * @param buffer The direct buffer holding the data
+	 * @return The number of bytes sent, less than remaining if the send buffer is full, or -1 if an error occurred
+	 */
+	public int trySend(ByteBuffer buffer) {
+		int position = direct(buffer).position();
+		int sent = trySend0(pointer(), buffer, position, buffer.limit() - position);
+		if (sent > 0) buffer.position(position + sent);
+		return sent;
+	}
+
+	/**
+	 * Receives data trough the TCP connection without blocking, independent of the blocking mode.
+	 * @param buffer The direct buffer to write the data to, up to its limit
+	 * @return The number of bytes received, zero if no data was available, or -1 if an error occurred
+	 */
+	public int tryReceive(ByteBuffer buffer) {
+		int position = direct(buffer).position();
+		int received = tryReceive0(pointer(), buffer, position, buffer.limit() - position);
+		if (received > 0) buffer.position(position + received);
+		return received;
+	}
+
+	/**
+	 * Same as trySend() but sends multiple buffers in order, as one continuous stream, with one JNI call and one system call where supported.
+	 * The positions of the buffers are advanced by the bytes sent from each of them.
+	 * @param buffers The direct buffers to send, at most 64 are sent per call
+	 * @return The total number of bytes sent, or -1 if an error occurred
+	 */
+	public int trySendGather(ByteBuffer... buffers) {
+		int count = Math.min(buffers.length, 64);
+		int[] ranges = new int[count * 2];
+		for (int i = 0; i < count; i++) {
+			ranges[i * 2] = direct(buffers[i]).position();
+			ranges[i * 2 + 1] = buffers[i].remaining();
+		}
+		int sent = trySendGather0(pointer(), buffers, ranges, count);
+		for (int i = 0, remaining = sent; i < count && remaining > 0; i++) {
+			int advance = Math.min(remaining, ranges[i * 2 + 1]);
+			buffers[i].position(ranges[i * 2] + advance);
+			remaining -= advance;
+		}
+		return sent;
+	}
+
+	/**
+	 * Sends the remaining data of the buffer as one UDP datagram.
+	 * @param remoteAddress The target address
+	 * @param buffer The direct buffer holding the data, its position is set to the limit if the data was sent
+	 * @return true if the data was sent successfully, false otherwise
+	 */
+	public boolean sendto(INetAddress remoteAddress, ByteBuffer buffer) {
+		int position = direct(buffer).position();
+		if (!sendto0(pointer(), remoteAddress, buffer, position, buffer.limit() - position)) return false;
+		buffer.position(buffer.limit());
+		return true;
+	}
+
+	/**
+	 * Receives one UDP datagram.
+	 * @param remoteAddress The address to overwrite with the sender address
+	 * @param buffer The direct buffer to write the data to, up to its limit
+	 * @return The number of bytes received, which might be zero, or -1 if an error occurred
+	 */
+	public int receivefrom(INetAddress remoteAddress, ByteBuffer buffer) {
+		int position = direct(buffer).position();
+		int received = receivefrom0(pointer(), remoteAddress, buffer, position, buffer.limit() - position);
+		if (received > 0) buffer.position(position + received);
+		return received;
+	}
+
+	/**
+	 * Receives multiple UDP datagrams into the slots of the batch with one JNI call.
+	 * Blocks until at least one datagram is received, and then returns all datagrams which are already queued, up to 64.
+	 * @param batch The batch to fill, its previous content is overwritten
+	 * @return The number of datagrams received, or -1 if an error occurred
+	 */
+	public int receivefromBatch(DatagramBatch batch) {
+		int received = receivefromBatch0(pointer(), batch.payload, batch.metadata, batch.slotSize, batch.capacity());
+		batch.count = Math.max(received, 0);
+		return received;
+	}
+
+	/**
+	 * Sends the datagrams of the batch with one JNI call, the native library passes them to the system in groups of up to 64.
+	 * @param batch The batch holding the datagrams, set with DatagramBatch.set()
+	 * @return The number of datagrams sent from the start of the batch, less than the count if the send buffer is full, or -1 if an error occurred
+	 */
+	public int sendtoBatch(DatagramBatch batch) {
+		return sendtoBatch0(pointer(), batch.payload, batch.metadata, batch.slotSize, batch.count);
+	}
+
+	private static native long newSocket0();
+	private static native void free0(long pointer);
+	private static native void close0(long pointer);
+	private static native boolean isOpen0(long pointer);
+	private static native int type0(long pointer);
+	private static native boolean setBlocking0(long pointer, boolean blocking);
+	private static native boolean setNagle0(long pointer, boolean enableBuffering);
+	private static native boolean getINet0(long pointer, INetAddress address);
+	private static native boolean listen0(long pointer, INetAddress address);
+	private static native boolean bind0(long pointer, INetAddress address);
+	private static native boolean connect0(long pointer, INetAddress address, long timeout);
+	private static native boolean accept0(long pointer, long clientPointer);
+	private static native boolean send0(long pointer, ByteBuffer buffer, int offset, int length);
+	private static native int receive0(long pointer, ByteBuffer buffer, int offset, int length);
+	private static native int trySend0(long pointer, ByteBuffer buffer, int offset, int length);
+	private static native int tryReceive0(long pointer, ByteBuffer buffer, int offset, int length);
+	private static native int trySendGather0(long pointer, ByteBuffer[] buffers, int[] ranges, int count);
+	private static native boolean sendto0(long pointer, INetAddress address, ByteBuffer buffer, int offset, int length);
+	private static native int receivefrom0(long pointer, INetAddress address, ByteBuffer buffer, int offset, int length);
+	private static native int sendtoBatch0(long pointer, ByteBuffer payload, ByteBuffer metadata, int slotSize, int count);
+	private static native int receivefromBatch0(long pointer, ByteBuffer payload, ByteBuffer metadata, int slotSize, int count);
+
+}
@@ -0,0 +1,18 @@
+/*
+ * SocketType.java
+ *
+ *  Created on: 19.10.2026
+ *      Author: marvi
+ */
+
+package de.m_marvin.netsocket;
+
+/**
+ * The state of an socket, same order as NetSocket::SocketType.
+ */
+public enum SocketType {
+	UNBOUND,
+	LISTEN_TCP,
+	LISTEN_UDP,
+	STREAM
+}